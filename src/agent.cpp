@@ -41,6 +41,8 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 #include <cassert>
 
 #include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 
 namespace nexuslua
 {
@@ -53,6 +55,11 @@ namespace nexuslua
         AgentType             _agentType{AgentType::Undefined};
         Configuration         _configuration;
 
+        // the elements of the std::map _messages keep their addresses; unlike _messages, these indices may be read while messages are added
+        mutable std::shared_mutex                            _mtxMessageIndex;
+        std::unordered_map<int, const AgentMessage*>         _messagesById;   ///< entries of _messages by AgentMessage::GetMessageId()
+        std::unordered_map<std::string, const AgentMessage*> _messagesByName; ///< entries of _messages by name, used by agents::GetMessage
+
         std::shared_ptr<cbeam::lifecycle::item_registry> _agent_registry{cbeam::lifecycle::singleton<cbeam::lifecycle::item_registry>::get("agent_registry")};
     };
 
@@ -60,6 +67,11 @@ namespace nexuslua
         : _impl{std::make_unique<Impl>()}
     {
         _impl->_agents = agent_group;
+
+        if (agent_group)
+        {
+            _impl->_configuration.SetTable(agent_group->GetConfiguration().GetTable());
+        }
     }
 
     Agent::~Agent()
@@ -76,6 +88,12 @@ namespace nexuslua
         return _impl->_configuration;
     }
 
+    std::size_t Agent::GetReplicaCount() const
+    {
+        auto thread_pool_ptr = ThreadPool::Get(_impl->_agents);
+        return thread_pool_ptr ? thread_pool_ptr->GetReplicatedCount(GetId()) : 0;
+    }
+
     std::shared_ptr<agents> Agent::GetAgents()
     {
         if (auto agents_ptr = _impl->_agents.lock())
@@ -153,9 +171,30 @@ namespace nexuslua
         return messageIt->second;
     }
 
-    void Agent::AddMessage(const std::string& messageName, const LuaTable::nested_tables& parameterDescriptions, const std::string& displayName, const std::string& description, const std::string& icon)
+    const AgentMessage* Agent::FindMessage(const int messageId) const
+    {
+        std::shared_lock lock(_impl->_mtxMessageIndex);
+        const auto       it = _impl->_messagesById.find(messageId);
+        return it == _impl->_messagesById.end() ? nullptr : it->second;
+    }
+
+    const AgentMessage* Agent::FindMessage(const std::string& messageName) const
+    {
+        std::shared_lock lock(_impl->_mtxMessageIndex);
+        const auto       it = _impl->_messagesByName.find(messageName);
+        return it == _impl->_messagesByName.end() ? nullptr : it->second;
+    }
+
+    void Agent::AddMessage(const std::string& messageName, const LuaTable::nested_tables& parameterDescriptions, const std::string& displayName, const std::string& description, const std::string& icon, const bool batched, const bool lazy)
+    {
+        IndexMessage(_messages.emplace(messageName, AgentMessage(_impl->_id, _impl->_agentType, GetName(), messageName, parameterDescriptions, displayName, description, icon, batched, lazy)).first->second);
+    }
+
+    void Agent::IndexMessage(const AgentMessage& message)
     {
-        _messages.emplace(messageName, AgentMessage(_impl->_id, _impl->_agentType, GetName(), messageName, parameterDescriptions, displayName, description, icon));
+        std::unique_lock lock(_impl->_mtxMessageIndex);
+        _impl->_messagesById[message.GetMessageId()]     = &message;
+        _impl->_messagesByName[message.GetMessageName()] = &message;
     }
 
     void Agent::Start(const std::filesystem::path& luaPath, const std::string& luaCode)
@@ -190,6 +229,22 @@ namespace nexuslua
         }
     }
 
+    void Agent::Start(const CppBatchHandler& cppBatchHandler)
+    {
+        _impl->_id        = (int)_impl->_agent_registry->register_item();
+        _impl->_agentType = AgentType::Cpp;
+        CBEAM_LOG_DEBUG("Agent::Start: id==" + std::to_string(_impl->_id) + " C++ (batched)");
+        auto thread_pool_ptr = ThreadPool::Get(_impl->_agents);
+        if (thread_pool_ptr)
+        {
+            thread_pool_ptr->StartThread(cppBatchHandler, this);
+        }
+        else
+        {
+            CBEAM_LOG("Did not (re-)start C++ agent because shutdown had been initiated.");
+        }
+    }
+
     int Agent::GetId() const
     {
         if (_impl->_id == -1)
@@ -48,6 +48,12 @@ namespace nexuslua
         Agent::Start(cppHandler);
     }
 
+    void AgentCpp::Start(const CppBatchHandler& cppBatchHandler)
+    {
+        _batched = true;
+        Agent::Start(cppBatchHandler);
+    }
+
     void AgentCpp::AddMessage(const std::string& messageName)
     {
         auto messageIt = _messages.find(messageName);
@@ -57,7 +63,7 @@ namespace nexuslua
             throw std::runtime_error("AgentCpp::AddMessage: message '" + messageName + "' is already registered in agent '" + _name + "'.");
         }
 
-        _messages.emplace(messageName, AgentMessage(GetId(), AgentType::Cpp, _name, messageName));
+        IndexMessage(_messages.emplace(messageName, AgentMessage(GetId(), AgentType::Cpp, _name, messageName, _batched)).first->second);
     }
 
     std::string AgentCpp::GetName() const
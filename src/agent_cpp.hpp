@@ -45,11 +45,13 @@ namespace nexuslua
         explicit AgentCpp(const std::shared_ptr<agents> agent_group, const std::string& name);
         virtual ~AgentCpp();
         void Start(const CppHandler& cppHandler);
+        void Start(const CppBatchHandler& cppBatchHandler);
         using Agent::AddMessage;
         void        AddMessage(const std::string& messageName);
         std::string GetName() const override;
 
     private:
         const std::string _name;
+        bool              _batched{false}; ///< true if the agent was started with a CppBatchHandler
     };
 }
\ No newline at end of file
@@ -32,6 +32,9 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 #include "agent_thread_lua.hpp"
 #include "lua.hpp"
 #include "message_counter.hpp"
+#include "message_pool.hpp"
+#include "name_ids.hpp"
+#include "pending_calls.hpp"
 #include "platform_specific.hpp"
 #include "thread_pool.hpp"
 
@@ -44,15 +47,18 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 
 using namespace nexuslua;
 
-AgentMessage::AgentMessage(const int agentN, const AgentType& agentType, const std::string& agentName, const std::string& messageName, const LuaTable::nested_tables& parameterDescriptions, const std::string& displayName, const std::string& description, const std::string& icon)
+AgentMessage::AgentMessage(const int agentN, const AgentType& agentType, const std::string& agentName, const std::string& messageName, const LuaTable::nested_tables& parameterDescriptions, const std::string& displayName, const std::string& description, const std::string& icon, const bool batched, const bool lazy)
     : _agentN(agentN)
     , _agentType(agentType)
     , _agentName(agentName)
     , _messageName(messageName)
+    , _messageId(NameIds::Intern(messageName))
     , _parameterDescriptions(parameterDescriptions)
     , _displayName(displayName.empty() ? messageName : displayName)
     , _description(description.empty() ? _displayName : description)
     , _svgIcon(icon)
+    , _batched(batched)
+    , _lazy(lazy)
 {
     if (messageName.empty())
     {
@@ -65,13 +71,16 @@ AgentMessage::AgentMessage(const int agentN, const AgentType& agentType, const s
     }
 }
 
-AgentMessage::AgentMessage(const int agentN, const AgentType& agentType, const std::string& agentName, const std::string& messageName)
+AgentMessage::AgentMessage(const int agentN, const AgentType& agentType, const std::string& agentName, const std::string& messageName, const bool batched)
     : _agentN{agentN}
     , _agentType(agentType)
     , _agentName{agentName}
     , _messageName{messageName}
+    , _messageId{NameIds::Intern(messageName)}
     , _displayName{messageName}
     , _description{messageName}
+    , _batched{batched}
+    , _lazy{false}
 {
     if (messageName.empty())
     {
@@ -96,23 +105,81 @@ void AgentMessage::Validate(const LuaTable& parameterValues) const
     }
 }
 
-void AgentMessage::Send(const LuaTable& parameterValues) const
+bool AgentMessage::Send(const LuaTable& parameterValues) const
 {
+    return Send(parameterValues, true);
+}
+
+bool AgentMessage::TrySend(const LuaTable& parameterValues) const
+{
+    return Send(parameterValues, false);
+}
+
+bool AgentMessage::Send(LuaTable&& parameterValues) const
+{
+    return Send(std::move(parameterValues), true);
+}
+
+bool AgentMessage::TrySend(LuaTable&& parameterValues) const
+{
+    return Send(std::move(parameterValues), false);
+}
+
+bool AgentMessage::Send(LuaTable parameterValues, const bool mayBlock) const
+{
+    // parameterValues is the only copy of the parameters; it is completed in place and moved into a recycled message
     message_counter::get()->increase();
 
-    LuaTable parameterValuesPlusDefault = AddDefaultParameterValues(parameterValues);
+    AddDefaultParameterValues(parameterValues);
 
-    Validate(parameterValuesPlusDefault);
+    Validate(parameterValues);
 
     auto thread_pool = ThreadPool::Get();
     if (thread_pool)
     {
-        thread_pool->SendMessage(std::make_shared<Message>(_agentN, _messageName, parameterValuesPlusDefault));
+        return thread_pool->SendMessage(MessagePool::Make(_agentN, _messageId, _messageName, std::move(parameterValues)), mayBlock);
     }
-    else
+
+    CBEAM_LOG("Skipped message '" + _messageName + "' because shutdown had been initiated");
+    return false;
+}
+
+std::future<LuaTable> AgentMessage::Call(const LuaTable& parameterValues) const
+{
+    auto promise = std::make_shared<std::promise<LuaTable>>();
+    auto future  = promise->get_future();
+
+    if (!Call(parameterValues, [promise](LuaTable reply)
+              { promise->set_value(std::move(reply)); }))
     {
-        CBEAM_LOG("Skipped message '" + _messageName + "' because shutdown had been initiated");
+        promise->set_exception(std::make_exception_ptr(std::runtime_error("nexuslua::AgentMessage '" + _displayName + "': message has not been sent to agent '" + _agentName + "', because its mailbox is full or shutdown had been initiated")));
     }
+
+    return future;
+}
+
+bool AgentMessage::Call(const LuaTable& parameterValues, std::function<void(LuaTable reply)> callback) const
+{
+    // the receiving agent passes its result to PendingCalls instead of sending a reply-to message
+    LuaTable        parameters = parameterValues;
+    const long long call       = PendingCalls::Add(std::move(callback));
+    parameters.SetReplyToCall(call);
+
+    try
+    {
+        if (Send(std::move(parameters), true))
+        {
+            return true;
+        }
+    }
+    catch (...)
+    {
+        PendingCalls::Cancel(call);
+        throw;
+    }
+
+    PendingCalls::Cancel(call);
+    return false;
 }
 
 LuaTable::nested_tables AgentMessage::GetDescriptionsOfUnsetParameters(const LuaTable& parameterValues) const
@@ -130,36 +197,32 @@ LuaTable::nested_tables AgentMessage::GetDescriptionsOfUnsetParameters(const Lua
     return unsetParameterDescriptions;
 }
 
-LuaTable AgentMessage::AddDefaultParameterValues(const LuaTable& parameterValues) const
+void AgentMessage::AddDefaultParameterValues(LuaTable& parameterValues) const
 {
-    LuaTable result = parameterValues;
-
     for (const auto& p : _parameterDescriptions)
     {
-        const auto& resultData = result.data.find(p.first);
-        if (resultData == result.data.end())
+        const auto& valueData = parameterValues.data.find(p.first);
+        if (valueData == parameterValues.data.end())
         {
             const auto& parameterData = p.second.data.find("default");
 
             if (parameterData != p.second.data.end())
             {
-                result.data[p.first] = parameterData->second;
+                parameterValues.data[p.first] = parameterData->second;
             }
         }
 
-        const auto& resultSubTable = result.sub_tables.find(p.first);
-        if (resultSubTable == result.sub_tables.end())
+        const auto& valueSubTable = parameterValues.sub_tables.find(p.first);
+        if (valueSubTable == parameterValues.sub_tables.end())
         {
             const auto& parameterSubTable = p.second.sub_tables.find("default");
 
             if (parameterSubTable != p.second.sub_tables.end())
             {
-                result.sub_tables[p.first] = parameterSubTable->second;
+                parameterValues.sub_tables[p.first] = parameterSubTable->second;
             }
         }
     }
-
-    return result;
 }
 
 std::string AgentMessage::GetAgentName() const { return _agentName; }
@@ -168,6 +231,8 @@ AgentType AgentMessage::GetAgentType() const { return _agentType; }
 
 std::string AgentMessage::GetMessageName() const { return _messageName; }
 
+int AgentMessage::GetMessageId() const { return _messageId; }
+
 std::string AgentMessage::GetDisplayName() const { return _displayName; }
 
 std::string AgentMessage::GetDescription() const { return _description; }
@@ -175,3 +240,6 @@ std::string AgentMessage::GetDescription() const { return _description; }
 LuaTable::nested_tables AgentMessage::GetParameterDescriptions() const { return _parameterDescriptions; }
 
 std::string AgentMessage::GetIconPath() const { return _svgIcon; }
+
+bool AgentMessage::IsBatched() const { return _batched; }
+bool AgentMessage::IsLazy() const { return _lazy; }
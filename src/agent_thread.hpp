@@ -27,60 +27,72 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 
 #include "agent_thread_base.hpp"
 
+#include "agent_message.hpp"
+#include "agents.hpp"
+
 #include <cbeam/convert/xpod.hpp>
 
-#include <cbeam/concurrency/message_manager.hpp>
 #include <cbeam/convert/nested_map.hpp>
 
 #include "agent_thread.hpp"
 
 #include "configuration.hpp"
+#include "mailbox.hpp"
+#include "pending_calls.hpp"
 
 #include <cbeam/logging/log_manager.hpp>
 #include <cbeam/serialization/xpod.hpp>
 
+#include <algorithm>
+#include <span>
+#include <string>
+#include <vector>
+
 namespace nexuslua
 {
     class AgentThread : public agent_thread_base
     {
     public:
-        using message_manager_type = cbeam::concurrency::message_manager<std::shared_ptr<Message>>;
-
-        AgentThread(Agent* agent, const std::shared_ptr<message_manager_type> message_manager, const std::string& threadName = {})
+        AgentThread(Agent* agent, std::shared_ptr<Mailbox> mailbox, const std::string& threadName = {})
             : agent_thread_base(agent, threadName)
-            , _message_manager{message_manager}
+            , _mailbox{mailbox}
         {
         }
 
         virtual ~AgentThread()
         {
-            _message_manager->dispose(_agent->GetId());
+            removeHandler();
         }
 
         void addHandler()
         {
-            _message_manager->add_handler(_agent->GetId(), [this](std::shared_ptr<Message> message)
-                                          { handleMessage(message); },
-                                          nullptr,
-                                          nullptr,
-                                          _tName,
-                                          cbeam::concurrency::message_manager<std::shared_ptr<Message>>::order_type::FIFO);
+            addHandler(nullptr);
+        }
 
+        /// like addHandler(), but the handler runs first before it takes any queued message, see Mailbox::AddHandler
+        void addHandler(Mailbox::Task first)
+        {
+            _batched = _mailbox->GetBatchSelection(); // set by the agent, also valid for its replicas
+
+            // depending on Configuration::scheduler, the mailbox either starts a thread for this handler or executes it by the Scheduler of the ThreadPool
             if (_agent->GetConfiguration().GetInternal<bool>(Configuration::logMessages))
             {
-                //                std::string agent_name = GetAgent()->GetName();
-                //                bool        agent_name_empty  = agent_name.empty();
-                //                size_t      agent_name_length = agent_name.length();
-                //                assert(agent_name_empty || agent_name_length <= 1024);
-
-                _message_manager->set_logger(_agent->GetId(), [=](std::size_t receiver, std::shared_ptr<Message> msg, bool sending)
-                                             {
-//                    TODO agent_name is sporadically corrupted after being copied into this Lambda (above assert is okay when below is not). Best to reproduce with demo5_fast.lua
-//                    bool agent_name_empty = agent_name.empty();
-//                    size_t agent_name_length = agent_name.length();
-//                    assert(agent_name_empty || agent_name_length <= 1024);
-//                    CBEAM_LOG("Agent " + agent_name + ": Message " + msg->name + " to handler" + std::to_string(receiver)+ " was " + (sending ? "sent" : "received") + " with parameters\n" + cbeam::convert::to_string(msg->parameters)); });
-                      CBEAM_LOG("Message " + msg->name + " to handler" + std::to_string(receiver) + " was " + (sending ? "sent" : "received") + " with parameters\n" + cbeam::convert::to_string(msg->parameters)); });
+                _mailbox->AddHandler(this, [this](std::span<std::shared_ptr<Message>> messages)
+                                     {
+                    for (const auto& message : messages)
+                    {
+                        CBEAM_LOG("Message " + message->name + " to handler" + std::to_string(_agent->GetId()) + " was received with parameters\n" + cbeam::convert::to_string(message->parameters));
+                    }
+                    dispatch(messages); },
+                                     _tName,
+                                     std::move(first));
+            }
+            else
+            {
+                _mailbox->AddHandler(this, [this](std::span<std::shared_ptr<Message>> messages)
+                                     { dispatch(messages); },
+                                     _tName,
+                                     std::move(first));
             }
         }
 
@@ -88,9 +100,118 @@ namespace nexuslua
         AgentThread& operator=(const AgentThread&) = delete;
 
     protected:
-        std::shared_ptr<message_manager_type> _message_manager;
+        /// stops delivering messages to this instance and waits until it finished the current message
+        void removeHandler()
+        {
+            _mailbox->RemoveHandler(this);
+        }
+
+        /// like removeHandler, but only if this instance does not process a message and idle returns true, see Mailbox::RemoveHandlerIfIdle
+        bool removeHandlerIfIdle(const std::function<bool()>& idle)
+        {
+            return _mailbox->RemoveHandlerIfIdle(this, idle);
+        }
+
+        /// lets the mailbox pass queued messages with names accepted by batched to handleBatch, see Configuration::messageBatchSize
+        void enableBatching(Mailbox::BatchSelection batched)
+        {
+            auto&           configuration = _agent->GetConfiguration();
+            const long long size          = configuration.GetInternal<long long>(Configuration::messageBatchSize);
+            const double    linger        = configuration.GetInternal<double>(Configuration::messageBatchLinger);
+
+            _mailbox->SetBatching(size > 1 ? (std::size_t)size : 1, std::chrono::duration<double>(linger > 0 ? linger : 0), std::move(batched));
+        }
+
+        /// enables batching for the messages that the Lua script of the agent registered with `batch=true`, see \ref addmessage
+        void enableBatchedMessages()
+        {
+            // the messages of the agent have been registered by its script via addmessage; replicas share the mailbox of the agent
+            std::vector<int> batched; // AgentMessage::GetMessageId() of the few batched messages of the agent
+
+            for (const auto& message : _agent->GetMessages())
+            {
+                if (message.second.IsBatched())
+                {
+                    batched.push_back(message.second.GetMessageId());
+                }
+            }
+
+            if (!batched.empty())
+            {
+                enableBatching([batched](const Message& message)
+                               { return message.message_id >= 0 && std::find(batched.begin(), batched.end(), message.message_id) != batched.end(); });
+            }
+        }
+
+        /// sends the result of a message handler to the `reply_to` of the incoming message, if any
+        void reply(const std::shared_ptr<Message>& incoming_message, LuaTable& result)
+        {
+            const long long call = incoming_message->parameters.GetReplyToCallOrZero();
+
+            if (call != 0)
+            {
+                PendingCalls::Complete(call, std::move(result)); // the caller waits for the result, see \ref call
+                return;
+            }
+
+            const std::string& reply_to_agent = incoming_message->parameters.GetReplyToAgentNameOrEmpty();
+
+            if (!reply_to_agent.empty())
+            {
+                const std::string& reply_to_message = incoming_message->parameters.GetReplyToMessageNameOrEmpty();
+
+                if (!reply_to_message.empty())
+                {
+                    const AgentMessage& message = _agent->GetAgents()->GetMessage(reply_to_agent, reply_to_message);
+                    const LuaTableBase  merge   = incoming_message->parameters.GetTableToMergeWhenReplyingOrEmpty();
+
+                    // The handler is done with the incoming message, so its parameters are moved into the reply instead of being
+                    // copied. The handler of a lazy message may have kept views of them (see lua_pushtableproxy), which must
+                    // stay valid as long as Lua holds them, so these parameters are copied.
+                    const AgentMessage* incoming = _agent->FindMessage(incoming_message->message_id);
+
+                    if (incoming && incoming->IsLazy())
+                    {
+                        result.SetOriginalMessage(incoming_message);
+                    }
+                    else
+                    {
+                        result.SetOriginalMessage(incoming_message->name, std::move(incoming_message->parameters));
+                    }
+                    result.merge(merge);
+
+                    message.Send(std::move(result));
+                }
+            }
+        }
+
+        std::shared_ptr<Mailbox> _mailbox; ///< the message queue of the agent, shared with its replicas
 
     private:
+        void dispatch(std::span<std::shared_ptr<Message>> messages)
+        {
+            // a function that accepts batches also receives a single queued message as a batch
+            if (messages.size() == 1 && !(_batched && _batched(*messages.front())))
+            {
+                handleMessage(messages.front());
+            }
+            else
+            {
+                handleBatch(messages);
+            }
+        }
+
         virtual void handleMessage(std::shared_ptr<Message> message) = 0;
+
+        /// called instead of handleMessage with several messages of the same name, if batching is enabled for it (see Mailbox::SetBatching)
+        virtual void handleBatch(std::span<std::shared_ptr<Message>> messages)
+        {
+            for (const auto& message : messages)
+            {
+                handleMessage(message);
+            }
+        }
+
+        Mailbox::BatchSelection _batched; ///< see Mailbox::SetBatching
     };
-}
\ No newline at end of file
+}
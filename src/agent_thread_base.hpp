@@ -49,6 +49,11 @@ namespace nexuslua
             return _agent;
         }
 
+        virtual std::size_t GetReplicatedCount() ///< number of replicas that currently process messages in addition to this instance
+        {
+            return 0;
+        }
+
         virtual void addHandler()                              = 0;
         agent_thread_base(const agent_thread_base&)            = delete;
         agent_thread_base& operator=(const agent_thread_base&) = delete;
@@ -0,0 +1,202 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "agent_thread_coroutine.hpp"
+
+#include "lua_extension.hpp"
+
+#include <cbeam/logging/log_manager.hpp>
+
+extern "C"
+{
+#include "lauxlib.h"
+#include "lualib.h"
+}
+
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace nexuslua
+{
+    AgentThreadCoroutine::AgentThreadCoroutine(const std::filesystem::path&   luaFilePath,
+                                               const std::string&             luaCode,
+                                               Agent*                         agent,
+                                               std::shared_ptr<Mailbox>       mailbox,
+                                               std::shared_ptr<AgentLoad>     load,
+                                               std::shared_ptr<CoroutineHost> host)
+        : AgentThread{agent, mailbox, "c_" + luaFilePath.stem().string()}
+        , _host{host}
+        , _load{load ? load : std::make_shared<AgentLoad>()}
+        , _luaFilePath{luaFilePath}
+    {
+        CBEAM_LOG_DEBUG("            " + get_instance_description() + ": New coroutine agent for Lua " + (luaCode.empty() ? "script '" : "code contained in script '") + _luaFilePath.string() + "'");
+
+        // the Lua state of the host may only be used by its thread
+        _host->Execute([this, &luaFilePath, &luaCode, agent, mailbox]()
+                       {
+            run_lua_script(luaFilePath, luaCode, agent);
+
+            _handlers = std::make_unique<HandlerCoroutines>(_host->GetState(), _environment, agent, _luaFilePath.string(), false, mailbox, this, _load,
+                                                            [this](const std::shared_ptr<Message>& message, LuaTable& result)
+                                                            { reply(message, result); }); });
+
+        enableBatchedMessages();
+    }
+
+    AgentThreadCoroutine::~AgentThreadCoroutine()
+    {
+        removeHandler();
+
+        _host->Execute(
+            [this]()
+            {
+                _handlers.reset(); // suspended handlers are discarded together with their messages
+                luaL_unref(_host->GetState(), LUA_REGISTRYINDEX, _environment);
+            });
+    }
+
+    std::string AgentThreadCoroutine::get_instance_description()
+    {
+        return "AgentThreadCoroutine<MessageToAgent<" + std::to_string(GetAgent()->GetId()) + ">> ('" + GetAgent()->GetName() + "')";
+    }
+
+    void AgentThreadCoroutine::run_lua_script(const std::filesystem::path& luaFilePath, const std::string& luaCode, Agent* agent)
+    {
+        lua_State* L = _host->GetState();
+
+        // the global variables of the agent; others are looked up in the globals of the host, which provide the Lua libraries and nexuslua functions
+        lua_newtable(L);
+        lua_createtable(L, 0, 1);
+        lua_pushglobaltable(L);
+        lua_setfield(L, -2, "__index");
+        lua_setmetatable(L, -2);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, -2, "_G");
+        _environment = luaL_ref(L, LUA_REGISTRYINDEX);
+
+        lua_State* thread    = lua_newthread(L);
+        const int  threadRef = luaL_ref(L, LUA_REGISTRYINDEX);
+
+        LuaExtension::StoreAgentOfLuaState(thread, agent, luaFilePath.string(), false);
+
+        std::string error;
+        bool        failed = false;
+
+        try
+        {
+            int status = luaCode.empty() ? luaL_loadfile(thread, luaFilePath.string().c_str())
+                                         : luaL_loadstring(thread, luaCode.c_str());
+
+            if (status == LUA_OK)
+            {
+                lua_rawgeti(thread, LUA_REGISTRYINDEX, _environment);
+                LuaExtension::PushRegisteredTables(thread, -1);
+                lua_setupvalue(thread, -2, 1); // the first upvalue of a chunk is its _ENV
+
+                if (!luaFilePath.empty())
+                {
+                    LuaExtension::StoreDirectoryOfDlls(luaFilePath.parent_path());
+                }
+
+                int results = 0;
+                status      = lua_resume(thread, nullptr, 0, &results);
+
+                if (status == LUA_YIELD)
+                {
+                    lua_settop(thread, 0);
+                    lua_pushstring(thread, "the script of a coroutine agent must not yield outside of message handlers");
+                }
+            }
+
+            if (status != LUA_OK)
+            {
+                const char* message = lua_tostring(thread, -1);
+                error               = message ? message : "(error object is not a string)";
+                failed              = true;
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            // e. g. thrown by a nexuslua function, which Lua cannot catch
+            error  = ex.what();
+            failed = true;
+        }
+        catch (...)
+        {
+            error  = "unknown exception";
+            failed = true;
+        }
+
+        LuaExtension::RemoveAgentOfLuaState(thread);
+        luaL_unref(L, LUA_REGISTRYINDEX, threadRef);
+
+        if (failed)
+        {
+            luaL_unref(L, LUA_REGISTRYINDEX, _environment);
+            _environment = LUA_NOREF;
+            throw std::runtime_error(get_instance_description() + ": Exception during execution of " + luaFilePath.string() + ": " + error);
+        }
+    }
+
+    void AgentThreadCoroutine::handleMessage(std::shared_ptr<Message> incoming_message)
+    {
+        _load->MessageDequeued();
+
+        try
+        {
+            _handlers->Start({incoming_message}, false); // replies, also if the function fails
+        }
+        catch (const std::exception& ex)
+        {
+            CBEAM_LOG("            " + get_instance_description() + ": handleMessage: "s + ex.what());
+        }
+        catch (...)
+        {
+            CBEAM_LOG("            " + get_instance_description() + ": handleMessage: unknown exception");
+        }
+    }
+
+    void AgentThreadCoroutine::handleBatch(std::span<std::shared_ptr<Message>> incoming_messages)
+    {
+        for (std::size_t i = 0; i < incoming_messages.size(); ++i)
+        {
+            _load->MessageDequeued();
+        }
+
+        try
+        {
+            _handlers->Start({incoming_messages.begin(), incoming_messages.end()}, true);
+        }
+        catch (const std::exception& ex)
+        {
+            CBEAM_LOG("            " + get_instance_description() + ": handleBatch: "s + ex.what());
+        }
+        catch (...)
+        {
+            CBEAM_LOG("            " + get_instance_description() + ": handleBatch: unknown exception");
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "agent.hpp"
+#include "agent_thread.hpp"
+#include "coroutine_host.hpp"
+#include "handler_coroutines.hpp"
+#include "replication_policy.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace nexuslua
+{
+    /// \brief a Lua agent that is a coroutine inside the Lua state of a CoroutineHost, see Configuration::schedulerCoroutines
+    /// \details The script of the agent runs with its own table of global variables, whose missing entries are looked
+    /// up in the globals of the host, so that the nexuslua functions and the Lua libraries are available. Each message
+    /// is handled in a coroutine that calls the function of the message (see HandlerCoroutines). If the function yields
+    /// or waits for the reply of \ref call, the host continues with the messages of other agents and resumes the function
+    /// later. Coroutine agents do not replicate.
+    class AgentThreadCoroutine
+        : public AgentThread
+    {
+    public:
+        AgentThreadCoroutine(const std::filesystem::path&   luaFilePath,
+                             const std::string&             luaCode,
+                             Agent*                         agent,
+                             std::shared_ptr<Mailbox>       mailbox,
+                             std::shared_ptr<AgentLoad>     load,
+                             std::shared_ptr<CoroutineHost> host);
+        virtual ~AgentThreadCoroutine();
+
+        AgentThreadCoroutine(const AgentThreadCoroutine&)            = delete;
+        AgentThreadCoroutine& operator=(const AgentThreadCoroutine&) = delete;
+
+    private:
+        void        run_lua_script(const std::filesystem::path& luaFilePath, const std::string& luaCode, Agent* agent);
+        void        handleMessage(std::shared_ptr<Message> message) override;
+        void        handleBatch(std::span<std::shared_ptr<Message>> messages) override;
+        std::string get_instance_description();
+
+        const std::shared_ptr<CoroutineHost> _host;
+        const std::shared_ptr<AgentLoad>     _load;
+        const std::filesystem::path          _luaFilePath;
+        int                                  _environment{0}; ///< registry reference of the table with the global variables of the agent
+        std::unique_ptr<HandlerCoroutines>   _handlers;       ///< only accessed by the thread of _host
+    };
+}
@@ -26,26 +26,114 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 #include "agent_thread_cpp.hpp"
 #include "agents.hpp"
 #include "message_counter.hpp"
+#include "pending_calls.hpp"
 
 #include <cbeam/logging/log_manager.hpp>
 #include <cbeam/serialization/xpod.hpp>
 
 namespace nexuslua
 {
-    AgentThreadCpp::AgentThreadCpp(const CppHandler& cppHandler, Agent* agent, std::shared_ptr<message_manager_type> message_manager)
-        : AgentThread{agent, message_manager}
+    namespace
+    {
+        void completeCall(const std::shared_ptr<Message>& message, const std::string& error = {})
+        {
+            // C++ handlers have no return value; a Lua function that waits in `call` for the message continues with an empty table,
+            // or with the error if the handler threw
+            const long long call = message->parameters.GetReplyToCallOrZero();
+
+            if (call != 0)
+            {
+                LuaTable reply;
+
+                if (!error.empty())
+                {
+                    reply.data["error"] = error;
+                }
+
+                PendingCalls::Complete(call, std::move(reply));
+            }
+        }
+    }
+
+    AgentThreadCpp::AgentThreadCpp(const CppHandler& cppHandler, Agent* agent, std::shared_ptr<Mailbox> mailbox)
+        : AgentThread{agent, mailbox}
         , _cppHandler{cppHandler}
     {
         CBEAM_LOG_DEBUG("            New agent '" + agent->GetName() + "' for C++ handler");
     }
 
+    AgentThreadCpp::AgentThreadCpp(const CppBatchHandler& cppBatchHandler, Agent* agent, std::shared_ptr<Mailbox> mailbox)
+        : AgentThread{agent, mailbox}
+        , _cppBatchHandler{cppBatchHandler}
+    {
+        CBEAM_LOG_DEBUG("            New agent '" + agent->GetName() + "' for C++ batch handler");
+        enableBatching([](const Message&)
+                       { return true; });
+    }
+
     AgentThreadCpp::~AgentThreadCpp()
     {
     }
 
     void AgentThreadCpp::handleMessage(std::shared_ptr<Message> incoming_message)
     {
-        _cppHandler(incoming_message);
+        if (_cppBatchHandler)
+        {
+            handleBatch(std::span<std::shared_ptr<Message>>(&incoming_message, 1));
+            return;
+        }
+
+        std::string error;
+
+        try
+        {
+            _cppHandler(incoming_message);
+        }
+        catch (const std::exception& ex)
+        {
+            error = ex.what();
+        }
+        catch (...)
+        {
+            error = "unknown exception";
+        }
+
+        if (!error.empty())
+        {
+            CBEAM_LOG("            C++ agent '" + _agent->GetName() + "': handleMessage: " + error);
+        }
+
+        completeCall(incoming_message, error);
         message_counter::get()->decrease();
     }
+
+    void AgentThreadCpp::handleBatch(std::span<std::shared_ptr<Message>> incoming_messages)
+    {
+        std::string error;
+
+        try
+        {
+            _cppBatchHandler(incoming_messages);
+        }
+        catch (const std::exception& ex)
+        {
+            error = ex.what();
+        }
+        catch (...)
+        {
+            error = "unknown exception";
+        }
+
+        if (!error.empty())
+        {
+            CBEAM_LOG("            C++ agent '" + _agent->GetName() + "': handleBatch: " + error);
+        }
+
+        for (const auto& message : incoming_messages)
+        {
+            completeCall(message, error);
+        }
+
+        message_counter::get()->decrease((int64_t)incoming_messages.size());
+    }
 }
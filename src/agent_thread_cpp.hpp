@@ -35,9 +35,8 @@ namespace nexuslua
     class AgentThreadCpp : public AgentThread
     {
     public:
-        using message_manager_type = cbeam::concurrency::message_manager<std::shared_ptr<Message>>;
-
-        AgentThreadCpp(const CppHandler& cppHandler, Agent* agent, std::shared_ptr<message_manager_type> message_manager);
+        AgentThreadCpp(const CppHandler& cppHandler, Agent* agent, std::shared_ptr<Mailbox> mailbox);
+        AgentThreadCpp(const CppBatchHandler& cppBatchHandler, Agent* agent, std::shared_ptr<Mailbox> mailbox);
         virtual ~AgentThreadCpp();
 
         AgentThreadCpp(const AgentThreadCpp&)            = delete;
@@ -45,7 +44,9 @@ namespace nexuslua
 
     private:
         void handleMessage(std::shared_ptr<Message> message) override;
+        void handleBatch(std::span<std::shared_ptr<Message>> messages) override;
 
-        CppHandler _cppHandler;
+        CppHandler      _cppHandler;
+        CppBatchHandler _cppBatchHandler; ///< set instead of _cppHandler if the agent was added via agents::AddBatched
     };
 }
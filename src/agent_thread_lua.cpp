@@ -29,17 +29,24 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 #include "agents.hpp"
 #include "configuration.hpp"
 #include "lua_extension.hpp"
-#include "message_counter.hpp"
 #include "platform_specific.hpp"
 
 #include <cbeam/convert/xpod.hpp>
 
+#include <cbeam/concurrency/thread.hpp>
 #include <cbeam/container/find.hpp>
 #include <cbeam/convert/nested_map.hpp>
 #include <cbeam/logging/log_manager.hpp>
 
 #include "lua_table.hpp"
 
+extern "C"
+{
+#include "lauxlib.h"
+}
+
+#include <vector>
+
 using namespace std::string_literals;
 
 namespace nexuslua
@@ -48,18 +55,23 @@ namespace nexuslua
         const std::filesystem::path&                                                        luaFilePath,
         const std::string&                                                                  luaCode,
         Agent*                                                                              agent,
-        std::shared_ptr<message_manager_type>                                               message_manager,
-        std::shared_ptr<Message>                                                            incoming_message,
-        std::shared_ptr<cbeam::container::thread_safe_set<std::shared_ptr<AgentThreadLua>>> replicated)
-        : AgentThread{agent, message_manager, "h_" + luaFilePath.stem().string()}
+        std::shared_ptr<Mailbox>                                                            mailbox,
+        std::shared_ptr<AgentLoad>                                                          load,
+        std::shared_ptr<cbeam::container::thread_safe_set<std::shared_ptr<AgentThreadLua>>> replicated,
+        std::shared_ptr<ReplicaPool>                                                        replicaPool)
+        : AgentThread{agent, mailbox, "h_" + luaFilePath.stem().string()}
         , _lua{agent}
         , _luaFilePath{luaFilePath}
         , _luaCode{luaCode}
-        , _isReplicated{incoming_message != nullptr}
+        , _isReplicated{replicated != nullptr}
         , _replicated{replicated ? replicated : std::make_shared<cbeam::container::thread_safe_set<std::shared_ptr<AgentThreadLua>>>()}
+        , _replicaPool{replicaPool}
+        , _load{load ? load : std::make_shared<AgentLoad>()}
+        , _replicationPolicy{ReplicationPolicy::Create(agent->GetConfiguration())}
+        , _handlers{_lua.GetState(), LUA_NOREF, agent, luaFilePath.string(), _isReplicated, mailbox, this, _load,
+                    [this](const std::shared_ptr<Message>& message, LuaTable& result)
+                    { reply(message, result); }}
     {
-        assert((replicated != nullptr) == (incoming_message != nullptr));
-
         std::string threadName = _isReplicated ? "RL" : "L";
         if (!luaCode.empty())
         {
@@ -81,22 +93,166 @@ namespace nexuslua
 
         CBEAM_LOG_DEBUG("            " + get_instance_description() + ": adding handler");
 
-        if (incoming_message)
+        if (!_isReplicated)
         {
-            auto modified_message = incoming_message->clone();
-            modified_message->parameters.data.erase("threads");
-            handleMessage(modified_message);
+            enableBatchedMessages();
+            createReplicaPool();
+            startRetiringReplicas();
         }
     }
 
     AgentThreadLua::~AgentThreadLua()
     {
+        removeHandler(); // before the Lua state is closed
+
         if (!_isReplicated)
         {
+            stopRetiringReplicas();
+
+            if (_replicaPool)
+            {
+                _replicaPool->Stop();
+            }
+            ReplicationPolicy::ReplicasStopped(_replicated->size());
             _replicated->clear();
         }
     }
 
+    void AgentThreadLua::createReplicaPool()
+    {
+        auto&           configuration = GetAgent()->GetConfiguration();
+        const long long size          = configuration.GetInternal<long long>(Configuration::luaReplicaPoolSize);
+
+        if (size <= 0)
+        {
+            return;
+        }
+
+        const std::string warmup = configuration.GetInternal<std::string>(Configuration::luaReplicaWarmup);
+
+        if (warmup != Configuration::luaReplicaWarmupEager && warmup != Configuration::luaReplicaWarmupOnDemand)
+        {
+            throw std::runtime_error(get_instance_description() + ": unknown value '" + warmup + "' of configuration entry '" + std::string(Configuration::luaReplicaWarmup) + "'");
+        }
+
+        _replicaPool = std::make_shared<ReplicaPool>(
+            (std::size_t)size,
+            [this]()
+            {
+                return std::make_shared<AgentThreadLua>(
+                    _luaFilePath,
+                    _luaCode,
+                    AgentThread::GetAgent(),
+                    _mailbox,
+                    _load,
+                    _replicated,
+                    _replicaPool);
+            },
+            "P" + GetAgent()->GetName());
+
+        if (warmup == Configuration::luaReplicaWarmupEager)
+        {
+            _replicaPool->Fill();
+        }
+    }
+
+    void AgentThreadLua::startRetiringReplicas()
+    {
+        const double idleTimeout = GetAgent()->GetConfiguration().GetInternal<double>(Configuration::luaReplicaIdleTimeout);
+
+        if (idleTimeout <= 0)
+        {
+            return;
+        }
+
+        _retireThread = std::thread(
+            [this, idleTimeout]()
+            {
+                const std::chrono::duration<double> interval{idleTimeout / 2};
+
+                std::unique_lock lock(_mtxRetire);
+                while (!_cvRetire.wait_for(lock, interval, [this]
+                                           { return _stopRetiring; }))
+                {
+                    lock.unlock();
+                    retireIdleReplicas(idleTimeout);
+                    lock.lock();
+                }
+            });
+    }
+
+    void AgentThreadLua::stopRetiringReplicas()
+    {
+        {
+            std::lock_guard lock(_mtxRetire);
+            _stopRetiring = true;
+        }
+        _cvRetire.notify_one();
+
+        if (_retireThread.joinable())
+        {
+            _retireThread.join();
+        }
+    }
+
+    void AgentThreadLua::retireIdleReplicas(const double idleTimeout)
+    {
+        std::vector<std::shared_ptr<AgentThreadLua>> retired;
+        std::size_t                                  remaining;
+        {
+            auto lock = _replicated->get_lock_guard();
+
+            for (const auto& replica : *_replicated)
+            {
+                // checked while the mailbox is locked, so that the replica cannot take a message before it is removed
+                if (replica->removeHandlerIfIdle([&replica, idleTimeout]()
+                                                 { return replica->isIdleFor(idleTimeout); }))
+                {
+                    retired.push_back(replica);
+                }
+            }
+
+            for (const auto& replica : retired)
+            {
+                _replicated->erase(replica);
+            }
+
+            remaining = _replicated->size();
+        }
+
+        ReplicationPolicy::ReplicasStopped(retired.size());
+
+        if (retired.empty())
+        {
+            return;
+        }
+
+        auto agent = AgentThread::GetAgent();
+
+        if (agent->GetConfiguration().template GetInternal<bool>(Configuration::logReplication))
+        {
+            CBEAM_LOG("Agent '" + agent->GetName() + "' retired " + std::to_string(retired.size()) + " idle replicas, " + std::to_string(remaining + 1) + " threads remaining (Lua script '" + _luaFilePath.string() + "')");
+        }
+    }
+
+    bool AgentThreadLua::isIdleFor(const double seconds)
+    {
+        if (_handlingMessage || _handlers.GetPendingCount() > 0)
+        {
+            return false;
+        }
+
+        std::lock_guard lock(_mtxTimeOfLastMessage);
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - _timeOfLastMessage).count() > seconds;
+    }
+
+    void AgentThreadLua::handleFirstMessage(std::shared_ptr<Message> incoming_message)
+    {
+        // the message has been passed on by the agent, so it can be modified without a copy
+        incoming_message->parameters.data.erase("threads");
+        handle(incoming_message);
+    }
+
     std::string AgentThreadLua::get_instance_description()
     {
         static std::string description = "AgentThreadLua<MessageToAgent<" + std::to_string(GetAgent()->GetId()) + ">> ('" + AgentThread::GetAgent()->GetName() + "')";
@@ -130,56 +286,72 @@ namespace nexuslua
 
     void AgentThreadLua::handleMessage(std::shared_ptr<Message> incoming_message)
     {
+        _load->MessageDequeued();
+        handle(incoming_message);
+    }
+
+    void AgentThreadLua::handle(std::shared_ptr<Message> incoming_message)
+    {
+        _handlingMessage = true;
+
         const auto currentTime = std::chrono::high_resolution_clock::now();
 
-        bool idle;
+        ReplicationState state{_load->GetQueuedMessages(), _replicated->size() + 1, 0, _load->GetAverageHandlingTime()};
         {
             std::lock_guard lock(_mtxTimeOfLastMessage);
-            idle = std::chrono::duration<double>(currentTime - _timeOfLastMessage).count() > AgentThread::GetAgent()->GetConfiguration().template GetInternal<double>(Configuration::luaStartNewThreadTime);
+            state.secondsSinceLastMessage = std::chrono::duration<double>(currentTime - _timeOfLastMessage).count();
         }
 
-        bool handled = false;
-        if (!idle)
+        bool handled   = false;
+        auto replicate = incoming_message->parameters.data.find("threads");
+        if (replicate != incoming_message->parameters.data.end() && _replicationPolicy->Replicate(state))
         {
-            auto replicate = incoming_message->parameters.data.find("threads");
-            if (replicate != incoming_message->parameters.data.end())
+            const std::size_t requested_threads = cbeam::container::get_value_or_default<cbeam::container::xpod::type_index::integer>(
+                replicate->second);
+
+            auto lock = _replicated->get_lock_guard();
+            if (_replicated->size() + 1 < requested_threads)
             {
-                const std::size_t requested_threads = cbeam::container::get_value_or_default<cbeam::container::xpod::type_index::integer>(
-                    replicate->second);
+                std::shared_ptr<AgentThreadLua> replicated_thread = _replicaPool ? _replicaPool->Take() : nullptr;
 
-                auto lock = _replicated->get_lock_guard();
-                if (_replicated->size() + 1 < requested_threads)
+                if (!replicated_thread)
                 {
-                    auto replicated_thread = std::make_shared<AgentThreadLua>(
+                    replicated_thread = std::make_shared<AgentThreadLua>(
                         _luaFilePath,
                         _luaCode,
                         AgentThread::GetAgent(),
-                        _message_manager,
-                        incoming_message,
-                        _replicated);
-
-                    replicated_thread->addHandler();
-                    _replicated->emplace(replicated_thread);
+                        _mailbox,
+                        _load,
+                        _replicated,
+                        _replicaPool);
+                }
 
-                    handled = true;
+                // the replica handles the message on its own thread, which also resumes the handler if it is suspended, and
+                // before any message that is queued meanwhile
+                replicated_thread->_handlingMessage = true; // not idle before it handled the message, see isIdleFor
+                replicated_thread->addHandler([replica = replicated_thread.get(), incoming_message]()
+                                              { replica->handleFirstMessage(incoming_message); });
+                _replicated->emplace(replicated_thread);
+                ReplicationPolicy::ReplicasStarted();
 
-                    auto agent = AgentThread::GetAgent();
+                handled = true;
 
-                    if (agent->GetConfiguration().template GetInternal<bool>(Configuration::logReplication))
-                    {
-                        const std::string logPart1 = _replicated->size() == 1 ? "Agent '" + agent->GetName() + "' is"
-                                                                              : "All agents '" + agent->GetName() + "' are";
-                        const std::string logPart2 = _luaCode.empty() ? ""
-                                                                      : "code contained in ";
+                auto agent = AgentThread::GetAgent();
 
-                        CBEAM_LOG(logPart1 + " busy => replicating to " + std::to_string(_replicated->size() + 1) + " threads to process incoming message '" + incoming_message->name + "' (Lua " + logPart2 + "script '" + _luaFilePath.string() + "')");
-                    }
-                }
-                else
+                if (agent->GetConfiguration().template GetInternal<bool>(Configuration::logReplication))
                 {
-                    CBEAM_LOG_DEBUG("            " + get_instance_description() + ": All " + std::to_string(requested_threads) + " replicated threads for " + incoming_message->name + " are busy, Lua script '" + _luaFilePath.string() + "'");
+                    const std::string logPart1 = _replicated->size() == 1 ? "Agent '" + agent->GetName() + "' is"
+                                                                          : "All agents '" + agent->GetName() + "' are";
+                    const std::string logPart2 = _luaCode.empty() ? ""
+                                                                  : "code contained in ";
+
+                    CBEAM_LOG(logPart1 + " busy => replicating to " + std::to_string(_replicated->size() + 1) + " threads to process incoming message '" + incoming_message->name + "' (Lua " + logPart2 + "script '" + _luaFilePath.string() + "')");
                 }
             }
+            else
+            {
+                CBEAM_LOG_DEBUG("            " + get_instance_description() + ": All " + std::to_string(requested_threads) + " replicated threads for " + incoming_message->name + " are busy, Lua script '" + _luaFilePath.string() + "'");
+            }
         }
 
         if (!handled)
@@ -203,25 +375,7 @@ namespace nexuslua
             // that might be thrown.
             try
             {
-                LuaTable result = _lua.RunPlugin(*incoming_message);
-
-                const std::string& reply_to_agent = incoming_message->parameters.GetReplyToAgentNameOrEmpty();
-
-                if (!reply_to_agent.empty())
-                {
-                    const std::string& reply_to_message = incoming_message->parameters.GetReplyToMessageNameOrEmpty();
-
-                    if (!reply_to_message.empty())
-                    {
-                        const AgentMessage& message = AgentThread::GetAgent()->GetAgents()->GetMessage(reply_to_agent, reply_to_message);
-
-                        result.SetOriginalMessage(incoming_message);
-                        result.merge(incoming_message->parameters.GetTableToMergeWhenReplyingOrEmpty());
-
-                        message.Send(result);
-                    }
-                }
-                message_counter::get()->decrease();
+                _handlers.Start({incoming_message}, false); // replies when the function returned, which may be after this call if it is suspended
             }
             catch (const std::exception& ex)
             {
@@ -233,12 +387,54 @@ namespace nexuslua
             }
         }
 
-        std::lock_guard lock(_mtxTimeOfLastMessage);
-        _timeOfLastMessage = std::chrono::high_resolution_clock::now();
+        {
+            std::lock_guard lock(_mtxTimeOfLastMessage);
+            _timeOfLastMessage = std::chrono::high_resolution_clock::now();
+        }
+
+        _handlingMessage = false;
+    }
+
+    void AgentThreadLua::handleBatch(std::span<std::shared_ptr<Message>> incoming_messages)
+    {
+        // replication is left to messages of functions that do not accept batches
+        _handlingMessage = true;
+
+        for (std::size_t i = 0; i < incoming_messages.size(); ++i)
+        {
+            _load->MessageDequeued();
+        }
+
+        CBEAM_LOG_DEBUG("            " + get_instance_description() + ": handling batch of " + std::to_string(incoming_messages.size()) + " messages '" + incoming_messages.front()->name + "' for Lua script '" + _luaFilePath.string() + "'");
+
+        try
+        {
+            _handlers.Start({incoming_messages.begin(), incoming_messages.end()}, true);
+        }
+        catch (const std::exception& ex)
+        {
+            CBEAM_LOG("            " + get_instance_description() + ": handleBatch: "s + ex.what());
+        }
+        catch (...)
+        {
+            CBEAM_LOG("            " + get_instance_description() + ": handleBatch: unknown exception");
+        }
+
+        {
+            std::lock_guard lock(_mtxTimeOfLastMessage);
+            _timeOfLastMessage = std::chrono::high_resolution_clock::now();
+        }
+
+        _handlingMessage = false;
     }
 
     std::size_t AgentThreadLua::GetReplicatedCount()
     {
         return _replicated->size();
     }
+
+    std::size_t AgentThreadLua::GetPreparedReplicaCount()
+    {
+        return _replicaPool ? _replicaPool->GetWarmCount() : 0;
+    }
 }
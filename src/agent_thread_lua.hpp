@@ -27,16 +27,21 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 
 #include "agent.hpp"
 #include "agent_thread.hpp"
+#include "handler_coroutines.hpp"
 #include "lua.hpp"
+#include "replica_pool.hpp"
+#include "replication_policy.hpp"
 
 #include <cbeam/container/thread_safe_set.hpp>
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
 #include <filesystem>
 #include <memory>
 #include <set>
+#include <span>
 #include <thread>
 
 namespace nexuslua
@@ -45,18 +50,19 @@ namespace nexuslua
         : public AgentThread
     {
     public:
-        using replication          = cbeam::container::thread_safe_set<std::shared_ptr<AgentThreadLua>>;
-        using message_manager_type = cbeam::concurrency::message_manager<std::shared_ptr<Message>>;
-
-        AgentThreadLua(const std::filesystem::path&          luaFilePath,
-                       const std::string&                    luaCode,
-                       Agent*                                agent,
-                       std::shared_ptr<message_manager_type> message_manager,
-                       std::shared_ptr<Message>              incoming_message = nullptr,
-                       std::shared_ptr<replication>          replicated       = nullptr);
+        using replication = cbeam::container::thread_safe_set<std::shared_ptr<AgentThreadLua>>;
+
+        AgentThreadLua(const std::filesystem::path& luaFilePath,
+                       const std::string&           luaCode,
+                       Agent*                       agent,
+                       std::shared_ptr<Mailbox>     mailbox,
+                       std::shared_ptr<AgentLoad>   load        = nullptr,
+                       std::shared_ptr<replication> replicated  = nullptr,
+                       std::shared_ptr<ReplicaPool> replicaPool = nullptr);
         virtual ~AgentThreadLua();
 
-        std::size_t GetReplicatedCount();
+        std::size_t GetReplicatedCount() override;
+        std::size_t GetPreparedReplicaCount(); ///< number of replicas that are initialized in advance, see Configuration::luaReplicaPoolSize
 
         AgentThreadLua(const AgentThreadLua&)            = delete;
         AgentThreadLua& operator=(const AgentThreadLua&) = delete;
@@ -64,6 +70,14 @@ namespace nexuslua
     private:
         void        run_lua_script(const std::filesystem::path& luaFilePath, const std::string& luaCode, Agent* agent);
         void        handleMessage(std::shared_ptr<Message> message) override;
+        void        handleBatch(std::span<std::shared_ptr<Message>> messages) override;
+        void        handle(std::shared_ptr<Message> message);
+        void        handleFirstMessage(std::shared_ptr<Message> incoming_message);
+        void        createReplicaPool();
+        void        startRetiringReplicas();
+        void        stopRetiringReplicas();
+        void        retireIdleReplicas(double idleTimeout);
+        bool        isIdleFor(double seconds);
         std::string get_instance_description();
 
         using HandleMessageFunction = std::function<void(std::shared_ptr<Message> message)>;
@@ -75,8 +89,19 @@ namespace nexuslua
         const bool                  _isReplicated;
 
         std::shared_ptr<replication> _replicated;
+        std::shared_ptr<ReplicaPool> _replicaPool; ///< nullptr, unless Configuration::luaReplicaPoolSize is greater than 0
+
+        std::shared_ptr<AgentLoad>         _load; ///< shared by the agent and its replicas
+        std::unique_ptr<ReplicationPolicy> _replicationPolicy;
+        HandlerCoroutines                  _handlers; ///< runs the message functions, so that they can be suspended by `coroutine.yield` or \ref call
 
         std::chrono::time_point<std::chrono::high_resolution_clock> _timeOfLastMessage;
         std::mutex                                                  _mtxTimeOfLastMessage;
+        std::atomic<bool>                                           _handlingMessage{false};
+
+        std::thread             _retireThread; ///< only running if Configuration::luaReplicaIdleTimeout is greater than 0
+        bool                    _stopRetiring{false};
+        std::mutex              _mtxRetire;
+        std::condition_variable _cvRetire;
     };
 }
@@ -33,6 +33,7 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 #include "agent_cpp.hpp"
 #include "agent_lua.hpp"
 #include "agent_plugin.hpp"
+#include "configuration.hpp"
 #include "description.hpp"
 #include "lua.hpp"
 #include "lua_extension.hpp"
@@ -46,8 +47,11 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 #include <cbeam/platform/system_folders.hpp>
 #include <cbeam/serialization/xpod.hpp>
 
+#include <shared_mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace nexuslua
 {
@@ -58,6 +62,24 @@ namespace nexuslua
         std::unique_ptr<std::map<std::string, std::shared_ptr<const Agent>>> _plugins{std::make_unique<std::map<std::string, std::shared_ptr<const Agent>>>()}; // TODO integrate into _agents
         std::unique_ptr<std::map<std::string, std::shared_ptr<Agent>>>       _agents{std::make_unique<std::map<std::string, std::shared_ptr<Agent>>>()};
         bool                                                                 _scannedPlugins = false;
+        Configuration                                                        _configuration;
+
+        std::shared_mutex                       _mtxAgentsByName;
+        std::unordered_map<std::string, Agent*> _agentsByName; ///< entries of _agents in a hash table, used to route messages; unlike _agents, it may be read while agents are added
+
+        void IndexAgent(const std::string& agentName, Agent* agent)
+        {
+            std::unique_lock lock(_mtxAgentsByName);
+            _agentsByName[agentName] = agent;
+        }
+
+        /// returns nullptr if the agent or its message is unknown
+        const AgentMessage* FindMessage(const std::string& agentName, const std::string& messageName)
+        {
+            std::shared_lock lock(_mtxAgentsByName);
+            const auto       it = _agentsByName.find(agentName);
+            return it == _agentsByName.end() ? nullptr : it->second->FindMessage(messageName);
+        }
     };
 
     agents::agents()
@@ -75,6 +97,10 @@ namespace nexuslua
         try
         {
             CBEAM_LOG_DEBUG("Destructing all nexuslua agents..."s);
+            {
+                std::unique_lock lock(_impl->_mtxAgentsByName);
+                _impl->_agentsByName.clear();
+            }
             _impl->_plugins.reset();
             _impl->_agents.reset();
             LuaExtension::DeregisterTablesOfAgents();
@@ -124,6 +150,12 @@ namespace nexuslua
 
     const AgentMessage& agents::GetMessage(const std::string& agentName, const std::string& messageName)
     {
+        // this is called for each reply, so the messages of agents (except plugins) are found with two hash lookups
+        if (const AgentMessage* message = _impl->FindMessage(agentName, messageName))
+        {
+            return *message;
+        }
+
         const auto& itPlugin = GetPlugins().find(agentName);
         if (itPlugin == GetPlugins().end())
         {
@@ -142,6 +174,50 @@ namespace nexuslua
         }
     }
 
+    Configuration& agents::GetConfiguration()
+    {
+        return _impl->_configuration;
+    }
+
+    std::vector<std::size_t> agents::GetQueueDepths(const std::string& agentName)
+    {
+        auto agent = GetAgent(agentName);
+
+        if (!agent)
+        {
+            throw std::runtime_error("nexuslua::agents::GetQueueDepths: Unknown agent '" + agentName + "'");
+        }
+
+        auto thread_pool_ptr = ThreadPool::Get();
+        return thread_pool_ptr ? thread_pool_ptr->GetQueueDepths(agent->GetId()) : std::vector<std::size_t>{};
+    }
+
+    std::size_t agents::GetQueueHighWaterMark(const std::string& agentName)
+    {
+        auto agent = GetAgent(agentName);
+
+        if (!agent)
+        {
+            throw std::runtime_error("nexuslua::agents::GetQueueHighWaterMark: Unknown agent '" + agentName + "'");
+        }
+
+        auto thread_pool_ptr = ThreadPool::Get();
+        return thread_pool_ptr ? thread_pool_ptr->GetQueueHighWaterMark(agent->GetId()) : 0;
+    }
+
+    std::size_t agents::GetQueueOverflowCount(const std::string& agentName)
+    {
+        auto agent = GetAgent(agentName);
+
+        if (!agent)
+        {
+            throw std::runtime_error("nexuslua::agents::GetQueueOverflowCount: Unknown agent '" + agentName + "'");
+        }
+
+        auto thread_pool_ptr = ThreadPool::Get();
+        return thread_pool_ptr ? thread_pool_ptr->GetQueueOverflowCount(agent->GetId()) : 0;
+    }
+
     void agents::AddMessageForCppAgent(const std::string& agentName, const std::string& messageName)
     {
         auto it = _impl->_agents->find(agentName);
@@ -170,6 +246,7 @@ namespace nexuslua
 
         auto agentCpp                = std::make_shared<AgentCpp>(shared_from_this(), agentName);
         (*_impl->_agents)[agentName] = agentCpp;
+        _impl->IndexAgent(agentName, agentCpp.get());
 
         LuaExtension::RegisterTableForAgent(agentCpp.get(), predefinedTable);
 
@@ -177,6 +254,23 @@ namespace nexuslua
         return agentCpp;
     }
 
+    std::shared_ptr<AgentCpp> agents::AddBatched(const std::string& agentName, const CppBatchHandler& cppBatchHandler, const LuaTable& predefinedTable)
+    {
+        if (_impl->_agents->count(agentName) == 1)
+        {
+            throw std::runtime_error("nexuslua::agents: cpp agent '" + agentName + "' already exists.");
+        }
+
+        auto agentCpp                = std::make_shared<AgentCpp>(shared_from_this(), agentName);
+        (*_impl->_agents)[agentName] = agentCpp;
+        _impl->IndexAgent(agentName, agentCpp.get());
+
+        LuaExtension::RegisterTableForAgent(agentCpp.get(), predefinedTable);
+
+        agentCpp->Start(cppBatchHandler);
+        return agentCpp;
+    }
+
     std::shared_ptr<AgentLua> agents::Add(const std::string& agentName, const std::filesystem::path& pathToLuaFile, const std::string& luaCode, const LuaTable& predefinedTable)
     {
         if (_impl->_agents->count(agentName) == 1)
@@ -186,6 +280,7 @@ namespace nexuslua
 
         auto agentLua                = std::make_shared<AgentLua>(shared_from_this(), agentName);
         (*_impl->_agents)[agentName] = agentLua;
+        _impl->IndexAgent(agentName, agentLua.get());
 
         LuaExtension::RegisterTableForAgent(agentLua.get(), predefinedTable);
 
@@ -0,0 +1,123 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include "nexuslua/agent_message.hpp"
+#include "nexuslua/agents.hpp"
+#include "nexuslua/configuration.hpp"
+#include "nexuslua/lua_table.hpp"
+#include "nexuslua/message.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace nexuslua
+{
+    using namespace std::string_literals;
+
+    /// many small messages to a Lua agent that replies to each of them, with and without batched delivery (see addmessage.md)
+    class BatchingBenchmark : public ::testing::Test
+    {
+    protected:
+        static constexpr int messageCount = 200000;
+
+        static constexpr const char singleCode[] = R"(
+            function Square(parameters)
+                return {square=parameters.value*parameters.value}
+            end
+
+            addmessage("Square")
+        )";
+
+        static constexpr const char batchCode[] = R"(
+            function Square(batch)
+                local results = {}
+                for i, parameters in ipairs(batch) do
+                    results[i] = {square=parameters.value*parameters.value}
+                end
+                return results
+            end
+
+            addmessage("Square", {batch=true})
+        )";
+
+        static void SetUpTestSuite()
+        {
+            _agents = std::make_shared<agents>();
+        }
+
+        static void TearDownTestSuite()
+        {
+            _agents->ShutdownAgents();
+            _agents.reset();
+        }
+
+        void Run(const std::string& name, const char* code)
+        {
+            std::atomic<long long> replies{0};
+
+            const std::string collectorName = "collector_" + name;
+
+            _agents->Add(name, "", code);
+            _agents->Add(collectorName, [&replies](std::shared_ptr<Message>)
+                         { ++replies; });
+            _agents->AddMessageForCppAgent(collectorName, "Result");
+
+            const auto& square = _agents->GetMessage(name, "Square");
+            const auto  start  = std::chrono::high_resolution_clock::now();
+
+            for (int i = 0; i < messageCount; ++i)
+            {
+                LuaTable parameters;
+                parameters.data["value"s] = (long long)i;
+                parameters.SetReplyTo(collectorName, "Result");
+                square.Send(parameters);
+            }
+
+            _agents->WaitUntilMessageQueueIsEmpty();
+
+            const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            EXPECT_EQ(replies, messageCount);
+            std::cout << "agent '" << name << "': " << messageCount / seconds << " messages/s" << std::endl;
+        }
+
+        inline static std::shared_ptr<agents> _agents;
+    };
+
+    TEST_F(BatchingBenchmark, Single)
+    {
+        Run("single", singleCode);
+    }
+
+    TEST_F(BatchingBenchmark, Batched)
+    {
+        _agents->GetConfiguration().SetInternal(Configuration::messageBatchSize, 64LL);
+        Run("batched", batchCode);
+    }
+}
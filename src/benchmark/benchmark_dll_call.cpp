@@ -0,0 +1,249 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "nexuslua/lua_table.hpp"
+#include "nexuslua/numeric_array.hpp"
+#include "nexuslua/table_view.h"
+
+#include "generic_dll_call.hpp"
+#include "lua_find_signature.hpp"
+
+#include "lua.hpp"
+
+#include <cbeam/serialization/nested_map.hpp>
+
+extern "C"
+{
+#include "lauxlib.h"
+#include "lualib.h"
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+extern "C"
+{
+    long long nexuslua_benchmark_add(long long a, double b)
+    {
+        return a + (long long)b;
+    }
+
+    double nexuslua_benchmark_mixed(double a, long long b, const char* c, double d)
+    {
+        return a * (double)b + (double)std::strlen(c) - d;
+    }
+
+    /// returns {values = parameters.values * parameters.factor}, receiving and returning serialized copies of the tables
+    cbeam::serialization::serialized_object nexuslua_benchmark_scale_serialized(cbeam::serialization::serialized_object serializedParameters)
+    {
+        using namespace std::string_literals;
+
+        nexuslua::LuaTable parameters(serializedParameters);
+        const double       factor = std::get<double>(parameters.data.at("factor"s));
+
+        for (double& value : nexuslua::NumericArray::Get<double>(parameters.sub_tables.at("values"s)))
+        {
+            value *= factor;
+        }
+
+        nexuslua::LuaTable result;
+        result.sub_tables["values"s] = parameters.sub_tables.at("values"s);
+        return cbeam::serialization::serialize<nexuslua::LuaTableBase>(result).safe_get();
+    }
+
+    /// like nexuslua_benchmark_scale_serialized, but accesses the tables in place via table_view.h
+    void nexuslua_benchmark_scale_view(const nexuslua_table_view* parameters, const nexuslua_table_builder* result)
+    {
+        const nexuslua_value factorKey = nexuslua_string_value("factor");
+        const nexuslua_value valuesKey = nexuslua_string_value("values");
+        nexuslua_value       factor;
+        nexuslua_value       values;
+
+        if (!parameters->api->get(parameters, &factorKey, &factor) || !parameters->api->get(parameters, &valuesKey, &values) || values.type != NEXUSLUA_ARRAY)
+        {
+            return;
+        }
+
+        const double* in  = static_cast<const double*>(values.as.array.data);
+        double*       out = static_cast<double*>(result->api->add_array(result, &valuesKey, NEXUSLUA_FLOAT64, values.as.array.length));
+
+        for (size_t i = 0; i < values.as.array.length; ++i)
+        {
+            out[i] = in[i] * factor.as.number;
+        }
+    }
+}
+
+namespace nexuslua
+{
+#ifdef NEXUSLUA_GENERIC_DLL_CALL
+    /// calls a function with the generated code found by FindCallDllFunction and with GenericDllCall
+    class DllCallBenchmark : public ::testing::Test
+    {
+    protected:
+        static constexpr int iterations = 1000000;
+
+        void SetUp() override
+        {
+            _L = luaL_newstate();
+            luaL_openlibs(_L);
+        }
+
+        void TearDown() override
+        {
+            lua_close(_L);
+        }
+
+        /// returns the nanoseconds per call of function with the arguments 3 and 4.0
+        template <typename Call>
+        double Measure(const Call& call, const DllFunction function)
+        {
+            long long  checksum = 0;
+            const auto start    = std::chrono::high_resolution_clock::now();
+
+            for (int i = 0; i < iterations; ++i)
+            {
+                lua_pushinteger(_L, 3);
+                lua_pushnumber(_L, 4.0);
+                call(_L, function);
+                checksum += (long long)lua_tointeger(_L, -1);
+                lua_settop(_L, 0);
+            }
+
+            const double result = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+            EXPECT_EQ(checksum, 7LL * iterations);
+            return result;
+        }
+
+        lua_State* _L{nullptr};
+    };
+
+    TEST_F(DllCallBenchmark, GeneratedVsGeneric)
+    {
+        const auto           generated = FindCallDllFunction("long long(long long,double)");
+        const GenericDllCall generic("long long(long long, double)");
+        const DllFunction    function = reinterpret_cast<DllFunction>(&nexuslua_benchmark_add);
+        ASSERT_NE(generated, nullptr);
+
+        const double generatedNs = Measure(generated, function);
+        const double genericNs   = Measure(generic, function);
+
+        std::cout << "generated " << generatedNs << " ns, generic " << genericNs << " ns per call" << std::endl;
+    }
+
+    TEST_F(DllCallBenchmark, GenericMixedOrder)
+    {
+        ASSERT_EQ(FindCallDllFunction("double(double,long long,const char*,double)"), nullptr);
+
+        const GenericDllCall generic("double(double,long long,const char*,double)");
+        lua_pushnumber(_L, 1.5);
+        lua_pushinteger(_L, 4);
+        lua_pushstring(_L, "abc");
+        lua_pushnumber(_L, 0.5);
+        generic(_L, reinterpret_cast<DllFunction>(&nexuslua_benchmark_mixed));
+
+        EXPECT_DOUBLE_EQ(lua_tonumber(_L, -1), 1.5 * 4 + 3 - 0.5);
+    }
+#endif
+
+    /// passes a table with a numeric array to functions of shared libraries as `table` (serialized) and as `table_view`
+    class TableViewBenchmark : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            _L = luaL_newstate();
+            luaL_openlibs(_L);
+        }
+
+        void TearDown() override
+        {
+            lua_close(_L);
+        }
+
+        /// pushes {factor = 2.0, values = newarray("float64", {0, 1, ..., length - 1})}
+        void PushParameters(const std::size_t length)
+        {
+            lua_newtable(_L);
+            lua_pushnumber(_L, 2.0);
+            lua_setfield(_L, -2, "factor");
+
+            auto* values = static_cast<double*>(lua_newnumericarray(_L, NumericArray::ElementType::Float64, length));
+
+            for (std::size_t i = 0; i < length; ++i)
+            {
+                values[i] = (double)i;
+            }
+
+            lua_setfield(_L, -2, "values");
+        }
+
+        /// returns the nanoseconds per call of the function with the given signature and the parameters of PushParameters
+        double Measure(const char* signature, const DllFunction function, const std::size_t length, const int iterations)
+        {
+            const CallDllFunctionType call = FindCallDllFunction(signature);
+            EXPECT_NE(call, nullptr);
+
+            PushParameters(length);
+            const auto start = std::chrono::high_resolution_clock::now();
+
+            for (int i = 0; i < iterations; ++i)
+            {
+                call(_L, function);
+
+                lua_getfield(_L, -1, "values");
+                NumericArray::ElementType type;
+                std::size_t               resultLength = 0;
+                const auto*               result       = static_cast<const double*>(lua_tonumericarraydata(_L, -1, type, resultLength));
+                EXPECT_TRUE(result && resultLength == length && result[length - 1] == 2.0 * (double)(length - 1));
+                lua_settop(_L, 1);
+            }
+
+            const double result = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+            lua_settop(_L, 0);
+            lua_gc(_L, LUA_GCCOLLECT);
+            return result;
+        }
+
+        lua_State* _L{nullptr};
+    };
+
+    TEST_F(TableViewBenchmark, SerializedVsView)
+    {
+        for (const std::size_t length : {1000, 100000, 1000000})
+        {
+            const int    iterations = (int)std::max<std::size_t>(10, 10000000 / length);
+            const double serialized = Measure("table(table)", reinterpret_cast<DllFunction>(&nexuslua_benchmark_scale_serialized), length, iterations);
+            const double view       = Measure("void(table_view,table_builder)", reinterpret_cast<DllFunction>(&nexuslua_benchmark_scale_view), length, iterations);
+
+            std::cout << "scale " << length << " doubles: table " << serialized << " ns, table_view " << view << " ns per call" << std::endl;
+        }
+    }
+}
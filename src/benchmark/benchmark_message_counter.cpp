@@ -0,0 +1,108 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <gtest/gtest.h>
+
+#include "message_counter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nexuslua
+{
+    /// increase/decrease pairs of the message_counter from a growing number of threads, compared to a single mutex protected counter
+    class MessageCounterBenchmark : public ::testing::Test
+    {
+    protected:
+        static constexpr int operationsPerThread = 1000000;
+
+        /// the previous design of message_counter: one mutex for all threads
+        struct MutexCounter
+        {
+            void increase()
+            {
+                std::lock_guard lock(_mtx);
+                ++_size;
+            }
+
+            void decrease()
+            {
+                std::lock_guard lock(_mtx);
+                --_size;
+            }
+
+            std::mutex _mtx;
+            int64_t    _size{0};
+        };
+
+        /// returns the number of increase/decrease pairs per second
+        template <typename Counter>
+        static double Run(Counter* counter, const unsigned threadCount)
+        {
+            std::vector<std::thread> threads;
+            const auto               start = std::chrono::high_resolution_clock::now();
+
+            for (unsigned t = 0; t < threadCount; ++t)
+            {
+                threads.emplace_back([counter]
+                                     {
+                    for (int i = 0; i < operationsPerThread; ++i)
+                    {
+                        counter->increase();
+                        counter->decrease();
+                    } });
+            }
+
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            return (double)threadCount * operationsPerThread / seconds;
+        }
+    };
+
+    TEST_F(MessageCounterBenchmark, Scaling)
+    {
+        const unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+        for (unsigned threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+        {
+            MutexCounter mutexCounter;
+
+            const double mutexRate   = Run(&mutexCounter, threadCount);
+            const double shardedRate = Run(message_counter::get(), threadCount);
+
+            EXPECT_EQ(message_counter::get()->size(), 0);
+            std::cout << threadCount << " threads: mutex " << mutexRate << " ops/s, sharded " << shardedRate << " ops/s" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,180 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "nexuslua/agent_message.hpp"
+#include "nexuslua/agents.hpp"
+#include "nexuslua/lua_table.hpp"
+#include "nexuslua/message.hpp"
+
+#include "message_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+
+namespace
+{
+    // counts all allocations of the benchmark executable; the other benchmarks are affected only by an additional atomic increment
+    std::atomic<long long> allocationCount{0};
+}
+
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace nexuslua
+{
+    using namespace std::string_literals;
+
+    /// allocations per message of the previous send path (copied parameters, std::make_shared) compared to moved parameters and MessagePool
+    class MessagePoolBenchmark : public ::testing::Test
+    {
+    protected:
+        static constexpr int messageCount = 200000;
+
+        static void SetUpTestSuite()
+        {
+            _agents = std::make_shared<agents>();
+        }
+
+        static void TearDownTestSuite()
+        {
+            _agents->ShutdownAgents();
+            _agents.reset();
+        }
+
+        static LuaTable CreateParameters(const int i)
+        {
+            LuaTable parameters;
+            parameters.data["value"s] = (long long)i;
+            parameters.data["text"s]  = "a text that does not fit into the small string buffer"s;
+            return parameters;
+        }
+
+        static void Print(const std::string& label, const long long allocations, const std::chrono::high_resolution_clock::time_point& start)
+        {
+            const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            std::cout << label << ": " << (double)allocations / messageCount << " allocations/message, " << messageCount / seconds << " messages/s" << std::endl;
+        }
+
+        /// sends messageCount messages to a C++ agent and returns the number of allocations, including those for the parameters
+        static long long Send(const std::string& agentName, const bool move)
+        {
+            _agents->Add(agentName, [](std::shared_ptr<Message>) {});
+            _agents->AddMessageForCppAgent(agentName, "ping");
+
+            const auto&     ping  = _agents->GetMessage(agentName, "ping");
+            const long long start = allocationCount.load();
+
+            for (int i = 0; i < messageCount; ++i)
+            {
+                LuaTable parameters = CreateParameters(i);
+
+                if (move)
+                {
+                    ping.Send(std::move(parameters));
+                }
+                else
+                {
+                    ping.Send(parameters);
+                }
+            }
+
+            _agents->WaitUntilMessageQueueIsEmpty();
+
+            return allocationCount.load() - start;
+        }
+
+        inline static std::shared_ptr<agents> _agents;
+    };
+
+    TEST_F(MessagePoolBenchmark, Construction)
+    {
+        long long  copied = 0;
+        const auto start  = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < messageCount; ++i)
+        {
+            const LuaTable  parameters  = CreateParameters(i);
+            const long long allocations = allocationCount.load();
+            auto            message     = std::make_shared<Message>(0, "ping"s, parameters);
+            copied += allocationCount.load() - allocations;
+        }
+
+        Print("copied parameters, make_shared", copied, start);
+
+        long long  pooled    = 0;
+        const auto poolStart = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < messageCount; ++i)
+        {
+            LuaTable        parameters  = CreateParameters(i);
+            const long long allocations = allocationCount.load();
+            auto            message     = MessagePool::Make(0, -1, "ping"s, std::move(parameters));
+            pooled += allocationCount.load() - allocations;
+        }
+
+        Print("moved parameters, MessagePool", pooled, poolStart);
+
+        EXPECT_LT(pooled, copied);
+    }
+
+    TEST_F(MessagePoolBenchmark, Send)
+    {
+        auto            start  = std::chrono::high_resolution_clock::now();
+        const long long copied = Send("copy", false);
+        Print("Send(const LuaTable&)", copied, start);
+
+        start                 = std::chrono::high_resolution_clock::now();
+        const long long moved = Send("move", true);
+        Print("Send(LuaTable&&)", moved, start);
+
+        EXPECT_LT(moved, copied);
+    }
+}
@@ -0,0 +1,153 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "nexuslua/agent.hpp"
+#include "nexuslua/agent_message.hpp"
+#include "nexuslua/agents.hpp"
+#include "nexuslua/configuration.hpp"
+#include "nexuslua/lua_table.hpp"
+#include "nexuslua/message.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nexuslua
+{
+    using namespace std::string_literals;
+
+    /// fan-out of the IsPrime example (see isreplicated.md) with each replication policy, measuring the latency of each request
+    class ReplicationBenchmark : public ::testing::Test
+    {
+    protected:
+        static constexpr int       requestCount = 2000;
+        static constexpr long long firstNumber  = 100000000001LL;
+
+        static constexpr const char numbersCode[] = R"(
+            function IsPrime(parameters)
+                local number = tonumber(parameters.number)
+                q=math.sqrt(number)
+                found=true
+                for k=3,q,2 do
+                    d = number/k
+                    di = math.floor(d)
+                    if d==di then
+                        found=false
+                        break
+                    end
+                end
+
+                return {isPrime=found}
+            end
+
+            addmessage("IsPrime")
+        )";
+
+        static void SetUpTestSuite()
+        {
+            _agents = std::make_shared<agents>();
+        }
+
+        static void TearDownTestSuite()
+        {
+            _agents->ShutdownAgents();
+            _agents.reset();
+        }
+
+        static double Now()
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        void Run(const std::string_view& policy)
+        {
+            _agents->GetConfiguration().SetInternal(Configuration::luaReplicationPolicy, (std::string)policy);
+
+            std::vector<double> latencies;
+            std::mutex          mtxLatencies;
+
+            const std::string numbersName   = "numbers_" + (std::string)policy;
+            const std::string collectorName = "collector_" + (std::string)policy;
+
+            _agents->Add(numbersName, "", numbersCode);
+            _agents->Add(collectorName, [&](std::shared_ptr<Message> message)
+                         {
+                const auto& original = message->parameters.sub_tables[(std::string)Message::originalMessageTableId].sub_tables[(std::string)Message::originalMessageParametersId];
+                const double sent = original.get_mapped_value_or_default<double>("sent"s);
+                std::lock_guard lock(mtxLatencies);
+                latencies.push_back(Now() - sent); });
+            _agents->AddMessageForCppAgent(collectorName, "CountPrime");
+
+            const long long threads = std::max(1u, std::thread::hardware_concurrency());
+            const auto&     isPrime = _agents->GetMessage(numbersName, "IsPrime");
+            const double    start   = Now();
+
+            for (int i = 0; i < requestCount; ++i)
+            {
+                LuaTable parameters;
+                parameters.data["number"s]  = firstNumber + 2 * i;
+                parameters.data["threads"s] = threads;
+                parameters.data["sent"s]    = Now();
+                parameters.SetReplyTo(collectorName, "CountPrime");
+                isPrime.Send(parameters);
+            }
+
+            _agents->WaitUntilMessageQueueIsEmpty();
+
+            const double seconds = Now() - start;
+
+            ASSERT_EQ(latencies.size(), (std::size_t)requestCount);
+            std::sort(latencies.begin(), latencies.end());
+
+            auto percentile = [&latencies](const double p)
+            {
+                return latencies[std::min(latencies.size() - 1, (std::size_t)(p * latencies.size()))] * 1000;
+            };
+
+            std::cout << "replication policy '" << policy << "': " << requestCount << " requests in " << seconds << " s, replicas: "
+                      << _agents->GetAgent(numbersName)->GetReplicaCount() << ", latency ms p50: " << percentile(0.5)
+                      << ", p99: " << percentile(0.99) << ", max: " << latencies.back() * 1000 << std::endl;
+        }
+
+        inline static std::shared_ptr<agents> _agents;
+    };
+
+    TEST_F(ReplicationBenchmark, IdleTime)
+    {
+        Run(Configuration::luaReplicationPolicyIdleTime);
+    }
+
+    TEST_F(ReplicationBenchmark, QueueDepth)
+    {
+        Run(Configuration::luaReplicationPolicyQueueDepth);
+    }
+}
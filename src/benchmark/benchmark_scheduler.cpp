@@ -0,0 +1,108 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "nexuslua/agent_message.hpp"
+#include "nexuslua/agents.hpp"
+#include "nexuslua/configuration.hpp"
+#include "nexuslua/message.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace nexuslua
+{
+    using namespace std::string_literals;
+
+    class SchedulerBenchmark : public ::testing::Test
+    {
+    protected:
+        static constexpr int agentCount       = 300;
+        static constexpr int messagesPerAgent = 1000;
+
+        static void SetUpTestSuite()
+        {
+            _agents = std::make_shared<agents>();
+        }
+
+        static void TearDownTestSuite()
+        {
+            _agents->ShutdownAgents();
+            _agents.reset();
+        }
+
+        /// adds agentCount C++ agents with the given scheduler and returns the seconds it took them to process messagesPerAgent messages each
+        double Run(const std::string_view& scheduler)
+        {
+            _agents->GetConfiguration().SetInternal(Configuration::scheduler, (std::string)scheduler);
+
+            std::atomic<long long> handled{0};
+
+            for (int i = 0; i < agentCount; ++i)
+            {
+                const std::string agentName = (std::string)scheduler + std::to_string(i);
+                _agents->Add(agentName, [&handled](std::shared_ptr<Message>)
+                             { ++handled; });
+                _agents->AddMessageForCppAgent(agentName, "ping");
+            }
+
+            const auto start = std::chrono::high_resolution_clock::now();
+
+            for (int m = 0; m < messagesPerAgent; ++m)
+            {
+                for (int i = 0; i < agentCount; ++i)
+                {
+                    _agents->GetMessage((std::string)scheduler + std::to_string(i), "ping").Send({});
+                }
+            }
+
+            _agents->WaitUntilMessageQueueIsEmpty();
+
+            const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            EXPECT_EQ(handled, (long long)agentCount * messagesPerAgent);
+            std::cout << "scheduler '" << scheduler << "': " << agentCount << " agents, "
+                      << (long long)agentCount * messagesPerAgent / seconds << " messages/s" << std::endl;
+
+            return seconds;
+        }
+
+        inline static std::shared_ptr<agents> _agents;
+    };
+
+    TEST_F(SchedulerBenchmark, ThreadPerAgent)
+    {
+        Run(Configuration::schedulerThreads);
+    }
+
+    TEST_F(SchedulerBenchmark, WorkStealingPool)
+    {
+        Run(Configuration::schedulerPool);
+    }
+}
@@ -0,0 +1,169 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "nexuslua/lua_table.hpp"
+
+#include "lua.hpp"
+
+extern "C"
+{
+#include "lauxlib.h"
+#include "lualib.h"
+}
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace nexuslua
+{
+    using namespace std::string_literals;
+
+    /// passes wide and deep tables to Lua functions, converted eagerly by lua_pushtable or viewed by lua_pushtableproxy
+    class TableProxyBenchmark : public ::testing::Test
+    {
+    protected:
+        static constexpr int iterations = 20000;
+
+        void SetUp() override
+        {
+            _L = luaL_newstate();
+            luaL_openlibs(_L);
+            ASSERT_EQ(luaL_dostring(_L, R"(
+                function ReadTwo(p)
+                    return p.field0 + p.field1
+                end
+
+                function ReadLeaf(p)
+                    local t = p
+                    while t.next do t = t.next end
+                    return t.field0
+                end
+
+                function ReadAll(p)
+                    local sum = 0
+                    for k, v in pairs(p) do
+                        if type(v) == "number" then sum = sum + v end
+                    end
+                    return sum
+                end
+            )"),
+                      LUA_OK);
+        }
+
+        void TearDown() override
+        {
+            lua_close(_L);
+        }
+
+        static LuaTable Wide(const int fieldCount)
+        {
+            LuaTable table;
+
+            for (int i = 0; i < fieldCount; ++i)
+            {
+                table.data["field" + std::to_string(i)] = (long long)i;
+            }
+
+            return table;
+        }
+
+        /// a chain of depth tables linked by the key "next", each with 10 fields
+        static LuaTable Deep(const int depth)
+        {
+            LuaTable table = Wide(10);
+
+            if (depth > 1)
+            {
+                table.sub_tables["next"s] = Deep(depth - 1);
+            }
+
+            return table;
+        }
+
+        /// returns the nanoseconds per call of the Lua function with the given table as parameter
+        double Measure(const char* function, const std::shared_ptr<const LuaTableBase>& table, const bool proxy)
+        {
+            long long  checksum = 0;
+            const auto start    = std::chrono::high_resolution_clock::now();
+
+            for (int i = 0; i < iterations; ++i)
+            {
+                lua_getglobal(_L, function);
+
+                if (proxy)
+                {
+                    lua_pushtableproxy(_L, table);
+                }
+                else
+                {
+                    lua_pushtable(_L, *table);
+                }
+
+                lua_call(_L, 1, 1);
+                checksum += (long long)lua_tointeger(_L, -1);
+                lua_pop(_L, 1);
+            }
+
+            const double result = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+            EXPECT_GE(checksum, 0);
+            lua_gc(_L, LUA_GCCOLLECT);
+            return result;
+        }
+
+        void Run(const std::string& label, const char* function, const LuaTable& table)
+        {
+            const auto   shared = std::make_shared<const LuaTableBase>(table);
+            const double eager  = Measure(function, shared, false);
+            const double lazy   = Measure(function, shared, true);
+
+            std::cout << label << ": eager " << eager << " ns, lazy " << lazy << " ns" << std::endl;
+        }
+
+        lua_State* _L{nullptr};
+    };
+
+    TEST_F(TableProxyBenchmark, Wide)
+    {
+        for (const int fieldCount : {10, 100, 1000})
+        {
+            const LuaTable table = Wide(fieldCount);
+
+            Run("read 2 of " + std::to_string(fieldCount) + " fields", "ReadTwo", table);
+            Run("read all " + std::to_string(fieldCount) + " fields", "ReadAll", table);
+        }
+    }
+
+    TEST_F(TableProxyBenchmark, Deep)
+    {
+        for (const int depth : {2, 8, 32})
+        {
+            Run("read leaf of depth " + std::to_string(depth), "ReadLeaf", Deep(depth));
+        }
+    }
+}
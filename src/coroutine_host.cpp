@@ -0,0 +1,87 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "coroutine_host.hpp"
+
+#include <cbeam/logging/log_manager.hpp>
+
+#include <exception>
+#include <future>
+
+namespace nexuslua
+{
+    CoroutineHost::CoroutineHost()
+        : _lua{nullptr} // the state is not bound to an agent, each agent runs in its own coroutine
+    {
+        _scheduler.Submit([this]()
+                          { _current = this; });
+
+        CBEAM_LOG_DEBUG("CoroutineHost: started host for coroutine agents");
+    }
+
+    CoroutineHost::~CoroutineHost()
+    {
+    }
+
+    Scheduler* CoroutineHost::GetScheduler()
+    {
+        return &_scheduler;
+    }
+
+    lua_State* CoroutineHost::GetState() const
+    {
+        return _lua.GetState();
+    }
+
+    void CoroutineHost::Execute(const std::function<void()>& task)
+    {
+        if (_current == this)
+        {
+            task();
+            return;
+        }
+
+        std::promise<void> done;
+
+        _scheduler.Submit([&task, &done]()
+                          {
+            try
+            {
+                task();
+                done.set_value();
+            }
+            catch (...)
+            {
+                done.set_exception(std::current_exception());
+            } });
+
+        done.get_future().get();
+    }
+
+    CoroutineHost* CoroutineHost::GetCurrent()
+    {
+        return _current;
+    }
+}
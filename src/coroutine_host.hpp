@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "lua.hpp"
+#include "scheduler.hpp"
+
+#include <functional>
+
+struct lua_State;
+
+namespace nexuslua
+{
+    /// \brief a thread with a Lua state that is shared by the agents of Configuration::schedulerCoroutines
+    /// \details Each agent of a host is a Lua coroutine with its own global environment inside the state of the host
+    /// (see AgentThreadCoroutine). All of them are executed by the single worker thread of the host's Scheduler, which
+    /// processes the mailboxes of the agents one message at a time. Therefore the Lua state needs no locking, but it
+    /// must not be accessed by any other thread; use Execute to run code on the host thread.
+    class CoroutineHost
+    {
+    public:
+        CoroutineHost();
+        virtual ~CoroutineHost();
+
+        Scheduler* GetScheduler();                            ///< executes the mailboxes of the agents of this host
+        lua_State* GetState() const;                          ///< the Lua state shared by the agents of this host; may only be used by its thread
+        void       Execute(const std::function<void()>& task); ///< runs task on the thread of this host and waits for it; exceptions are passed on to the caller
+
+        static CoroutineHost* GetCurrent(); ///< the host whose thread calls this function, or nullptr
+
+        CoroutineHost(const CoroutineHost&)            = delete;
+        CoroutineHost& operator=(const CoroutineHost&) = delete;
+
+    private:
+        Lua       _lua; ///< declared before _scheduler, so that the host thread is stopped before the Lua state is closed
+        Scheduler _scheduler{1};
+
+        inline static thread_local CoroutineHost* _current{nullptr};
+    };
+}
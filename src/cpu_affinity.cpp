@@ -0,0 +1,264 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "cpu_affinity.hpp"
+
+#include "configuration.hpp"
+
+#include <cbeam/logging/log_manager.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#elif defined(__linux__)
+    #ifndef _GNU_SOURCE
+        #define _GNU_SOURCE
+    #endif
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace nexuslua
+{
+    CpuAffinity::CpuAffinity(const Policy policy, const std::vector<std::size_t>& cores)
+        : _policy{policy}
+        , _cores{cores}
+    {
+        if (_policy == Policy::Isolate)
+        {
+            std::lock_guard lock(_mtxIsolated);
+            for (const auto core : selectCores())
+            {
+                _isolated.insert(core);
+            }
+        }
+    }
+
+    CpuAffinity::~CpuAffinity()
+    {
+        if (_policy == Policy::Isolate)
+        {
+            std::lock_guard lock(_mtxIsolated);
+            for (const auto core : selectCores())
+            {
+                _isolated.erase(_isolated.find(core));
+            }
+        }
+    }
+
+    std::shared_ptr<CpuAffinity> CpuAffinity::Create(Configuration& configuration)
+    {
+        const std::string policy = configuration.GetInternal<std::string>(Configuration::cpuAffinity);
+        const std::string cores  = configuration.GetInternal<std::string>(Configuration::cpuAffinityCores);
+
+        if (policy == Configuration::cpuAffinityNone)
+        {
+            return std::make_shared<CpuAffinity>(Policy::None, std::vector<std::size_t>{});
+        }
+        if (policy == Configuration::cpuAffinityPin)
+        {
+            return std::make_shared<CpuAffinity>(Policy::Pin, ParseCores(cores));
+        }
+        if (policy == Configuration::cpuAffinitySpread)
+        {
+            return std::make_shared<CpuAffinity>(Policy::Spread, ParseCores(cores));
+        }
+        if (policy == Configuration::cpuAffinityIsolate)
+        {
+            if (cores.empty())
+            {
+                throw std::runtime_error("nexuslua::CpuAffinity: configuration entry '" + std::string(Configuration::cpuAffinity) + "' is '" + policy + "', which requires the cores in '" + std::string(Configuration::cpuAffinityCores) + "'");
+            }
+            return std::make_shared<CpuAffinity>(Policy::Isolate, ParseCores(cores));
+        }
+
+        throw std::runtime_error("nexuslua::CpuAffinity: unknown value '" + policy + "' of configuration entry '" + std::string(Configuration::cpuAffinity) + "'");
+    }
+
+    std::vector<std::size_t> CpuAffinity::ParseCores(const std::string& cores, const std::size_t coreCount)
+    {
+        std::set<std::size_t> result;
+        std::stringstream     list(cores);
+        std::string           range;
+
+        while (std::getline(list, range, ','))
+        {
+            range.erase(std::remove_if(range.begin(), range.end(), [](const char c)
+                                       { return c == ' '; }),
+                        range.end());
+
+            if (range.empty())
+            {
+                continue;
+            }
+
+            std::size_t first;
+            std::size_t last;
+            const auto  dash = range.find('-');
+
+            try
+            {
+                std::size_t parsed = 0;
+                first              = std::stoul(range.substr(0, dash), &parsed);
+                last               = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1), &parsed);
+
+                if (parsed != (dash == std::string::npos ? range.size() : range.size() - dash - 1))
+                {
+                    throw std::invalid_argument(range);
+                }
+            }
+            catch (const std::logic_error&)
+            {
+                throw std::runtime_error("nexuslua::CpuAffinity: invalid core range '" + range + "' in '" + cores + "', expected a list like \"0-3,6\"");
+            }
+
+            if (first > last || last >= coreCount)
+            {
+                throw std::runtime_error("nexuslua::CpuAffinity: core range '" + range + "' in '" + cores + "' is not within the " + std::to_string(coreCount) + " cores of this system");
+            }
+
+            for (std::size_t core = first; core <= last; ++core)
+            {
+                result.insert(core);
+            }
+        }
+
+        return {result.begin(), result.end()};
+    }
+
+    std::size_t CpuAffinity::GetCoreCount()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    CpuAffinity::Policy CpuAffinity::GetPolicy() const
+    {
+        return _policy;
+    }
+
+    std::vector<std::size_t> CpuAffinity::selectCores()
+    {
+        std::vector<std::size_t> cores = _cores;
+
+        if (cores.empty())
+        {
+            for (std::size_t core = 0; core < GetCoreCount(); ++core)
+            {
+                cores.push_back(core);
+            }
+        }
+
+        return cores;
+    }
+
+    std::vector<std::size_t> CpuAffinity::SelectCoresOfNextThread()
+    {
+        std::vector<std::size_t> cores = selectCores();
+
+        if (_policy != Policy::Isolate)
+        {
+            std::lock_guard          lock(_mtxIsolated);
+            std::vector<std::size_t> available;
+
+            std::copy_if(cores.begin(), cores.end(), std::back_inserter(available), [](const std::size_t core)
+                         { return _isolated.count(core) == 0; });
+
+            if (available.empty())
+            {
+                CBEAM_LOG("nexuslua::CpuAffinity: all configured cores are isolated by other agents, ignoring the isolation");
+            }
+            else if (available.size() < cores.size())
+            {
+                cores.swap(available);
+            }
+            else if (_policy == Policy::None)
+            {
+                return {}; // nothing isolated, leave the thread to the operating system
+            }
+        }
+
+        if (_policy == Policy::Spread)
+        {
+            cores = {cores[_nextCore++ % cores.size()]};
+        }
+
+        return cores;
+    }
+
+    void CpuAffinity::ApplyToCurrentThread()
+    {
+        const std::vector<std::size_t> cores = SelectCoresOfNextThread();
+
+        if (cores.empty())
+        {
+            return;
+        }
+
+        if (!setCurrentThreadAffinity(cores))
+        {
+            CBEAM_LOG_DEBUG("nexuslua::CpuAffinity: could not set the affinity of the current thread");
+        }
+    }
+
+    bool CpuAffinity::setCurrentThreadAffinity(const std::vector<std::size_t>& cores)
+    {
+#ifdef _WIN32
+        DWORD_PTR mask = 0;
+        for (const auto core : cores)
+        {
+            if (core < sizeof(DWORD_PTR) * 8) // only the first processor group is supported
+            {
+                mask |= (DWORD_PTR)1 << core;
+            }
+        }
+        return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (const auto core : cores)
+        {
+            if (core < CPU_SETSIZE)
+            {
+                CPU_SET(core, &set);
+            }
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        // macOS does not support binding threads to cores
+        (void)cores;
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,80 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace nexuslua
+{
+    class Configuration;
+
+    /// \brief restricts the handler threads of an agent to a set of cores, see Configuration::cpuAffinity
+    /// \details Applied by the Mailbox of the agent whenever it starts a thread for a handler, i. e. for the agent
+    /// itself and for each of its replicas. Cores of agents with Policy::Isolate are avoided by the threads of all
+    /// other agents that are started afterwards, as long as at least one core remains for them.
+    class CpuAffinity
+    {
+    public:
+        enum class Policy
+        {
+            None,   ///< the operating system places the threads, apart from isolated cores
+            Pin,    ///< each thread may run on any of the configured cores
+            Spread, ///< each thread is pinned to a single core, taking the configured cores round robin
+            Isolate ///< like Pin, and the cores are reserved for this agent
+        };
+
+        CpuAffinity(Policy policy, const std::vector<std::size_t>& cores); ///< empty cores means all cores
+        virtual ~CpuAffinity();
+
+        static std::shared_ptr<CpuAffinity> Create(Configuration& configuration); ///< throws if Configuration::cpuAffinity or Configuration::cpuAffinityCores is invalid
+        static std::vector<std::size_t>     ParseCores(const std::string& cores, std::size_t coreCount = GetCoreCount()); ///< parses a list like "0-3,6" into sorted, unique core indices below coreCount
+        static std::size_t                  GetCoreCount();
+
+        std::vector<std::size_t> SelectCoresOfNextThread(); ///< returns the cores that ApplyToCurrentThread restricts the next thread to, or an empty list if it leaves the thread to the operating system
+        void                     ApplyToCurrentThread();    ///< restricts the calling thread according to the policy
+        Policy                   GetPolicy() const;
+
+        CpuAffinity(const CpuAffinity&)            = delete;
+        CpuAffinity& operator=(const CpuAffinity&) = delete;
+
+    private:
+        std::vector<std::size_t> selectCores();
+        static bool              setCurrentThreadAffinity(const std::vector<std::size_t>& cores);
+
+        const Policy                   _policy;
+        const std::vector<std::size_t> _cores;
+        std::atomic<std::size_t>       _nextCore{0}; ///< for Policy::Spread
+
+        inline static std::mutex                 _mtxIsolated;
+        inline static std::multiset<std::size_t> _isolated; ///< cores of all agents with Policy::Isolate
+    };
+}
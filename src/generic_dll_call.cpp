@@ -0,0 +1,244 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "generic_dll_call.hpp"
+
+#include "lua.hpp"
+#include "lua_table.hpp"
+#include "table_view.h"
+
+#include <cbeam/serialization/nested_map.hpp>
+
+extern "C"
+{
+#include "lauxlib.h"
+#include "lualib.h"
+}
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nexuslua
+{
+    namespace
+    {
+        /// returns the type of the given name, ignoring white space, e. g. `"long long"` or `"const char *"`
+        GenericDllCall::Type parseType(const std::string_view name, const std::string_view signature)
+        {
+            std::string compact;
+
+            for (const char c : name)
+            {
+                if (c != ' ' && c != '\t')
+                {
+                    compact += c;
+                }
+            }
+
+            if (compact == "void") return GenericDllCall::Type::Void;
+            if (compact == "table") return GenericDllCall::Type::Table;
+            if (compact == "longlong") return GenericDllCall::Type::LongLong; // needs to match lua_Integer, see lua.h and test/test_lua.cpp
+            if (compact == "double") return GenericDllCall::Type::Double;     // needs to match lua_Number, see lua.h and test/test_lua.cpp
+            if (compact == "bool") return GenericDllCall::Type::Bool;
+            if (compact == "constchar*") return GenericDllCall::Type::String;
+            if (compact == "void*") return GenericDllCall::Type::VoidPtr;
+            if (compact == "table_view") return GenericDllCall::Type::TableView;
+            if (compact == "table_builder") return GenericDllCall::Type::TableBuilder;
+
+            throw std::runtime_error("Import: unsupported type '" + std::string(name) + "' in signature '" + std::string(signature) + "'. Supported types are void (only as return type), table, table_view, table_builder (only as parameter), long long, double, bool, const char* and void*.");
+        }
+
+#ifdef NEXUSLUA_GENERIC_DLL_CALL
+        using Integers = std::array<std::intptr_t, GenericDllCall::integerRegisters>;
+        using Doubles  = std::array<double, GenericDllCall::doubleRegisters>;
+
+        /// calls function with all argument registers filled, see GenericDllCall
+        template <typename R>
+        R invoke(const DllFunction function, const Integers& i, const Doubles& d)
+        {
+    #if defined(__aarch64__)
+            using Function = R (*)(std::intptr_t, std::intptr_t, std::intptr_t, std::intptr_t, std::intptr_t, std::intptr_t, std::intptr_t, std::intptr_t,
+                                   double, double, double, double, double, double, double, double);
+            return reinterpret_cast<Function>(function)(i[0], i[1], i[2], i[3], i[4], i[5], i[6], i[7], d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+    #else
+            using Function = R (*)(std::intptr_t, std::intptr_t, std::intptr_t, std::intptr_t, std::intptr_t, std::intptr_t,
+                                   double, double, double, double, double, double, double, double);
+            return reinterpret_cast<Function>(function)(i[0], i[1], i[2], i[3], i[4], i[5], d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7]);
+    #endif
+        }
+#endif
+    }
+
+    GenericDllCall::GenericDllCall(const std::string_view signature)
+    {
+#ifndef NEXUSLUA_GENERIC_DLL_CALL
+        throw std::runtime_error("Import: signature '" + std::string(signature) + "' has no generated function, and calling functions with other signatures is not supported on this platform.");
+#else
+        const std::size_t open  = signature.find('(');
+        const std::size_t close = signature.rfind(')');
+
+        if (open == std::string_view::npos || close == std::string_view::npos || close < open)
+        {
+            throw std::runtime_error("Import: invalid signature '" + std::string(signature) + "', expected e. g. 'double(long long,double)'");
+        }
+
+        _returnType = parseType(signature.substr(0, open), signature);
+
+        if (_returnType == Type::TableView || _returnType == Type::TableBuilder)
+        {
+            throw std::runtime_error("Import: table_view and table_builder are not supported as return type in signature '" + std::string(signature) + "', use a table_builder parameter instead");
+        }
+
+        std::size_t integers = 0;
+        std::size_t doubles  = 0;
+        std::size_t begin    = open + 1;
+
+        while (begin < close)
+        {
+            const std::size_t end = std::min(signature.find(',', begin), close);
+            const Type        type = parseType(signature.substr(begin, end - begin), signature);
+
+            if (type == Type::Void)
+            {
+                throw std::runtime_error("Import: parameters of type void are not supported in signature '" + std::string(signature) + "'");
+            }
+
+            ++(type == Type::Double ? doubles : integers);
+
+            if (integers > integerRegisters || doubles > doubleRegisters)
+            {
+                throw std::runtime_error("Import: signature '" + std::string(signature) + "' has more than " + std::to_string(integerRegisters) + " integer or pointer parameters or more than " + std::to_string(doubleRegisters) + " double parameters");
+            }
+
+            _arguments[_argumentCount++] = type;
+            begin                        = end + 1;
+        }
+
+        for (std::size_t a = 0; a < _argumentCount; ++a)
+        {
+            if (_arguments[a] == Type::TableBuilder && (a + 1 != _argumentCount || _returnType != Type::Void))
+            {
+                throw std::runtime_error("Import: table_builder must be the last parameter of a function returning void in signature '" + std::string(signature) + "'");
+            }
+        }
+#endif
+    }
+
+    void GenericDllCall::operator()(lua_State* L, const DllFunction function) const
+    {
+#ifdef NEXUSLUA_GENERIC_DLL_CALL
+        Integers                                          integers{};
+        Doubles                                           doubles{};
+        std::size_t                                       nIntegers = 0;
+        std::size_t                                       nDoubles  = 0;
+        std::array<nexuslua_table_view, integerRegisters> views{};
+        nexuslua_table_builder                            builder{};
+
+        // serialized tables must stay alive until the function returns
+        std::vector<decltype(cbeam::serialization::serialize<LuaTableBase>(std::declval<const LuaTableBase&>()))> tables;
+        tables.reserve(_argumentCount);
+
+        for (std::size_t a = 0; a < _argumentCount; ++a)
+        {
+            const int idx = (int)a + 1;
+
+            switch (_arguments[a])
+            {
+            case Type::Table:
+                tables.push_back(cbeam::serialization::serialize<LuaTableBase>((LuaTableBase)lua_totable(L, idx)));
+                integers[nIntegers++] = (std::intptr_t)tables.back().safe_get();
+                break;
+            case Type::LongLong:
+                integers[nIntegers++] = (std::intptr_t)lua_tointeger(L, idx);
+                break;
+            case Type::Double:
+                doubles[nDoubles++] = (double)lua_tonumber(L, idx);
+                break;
+            case Type::Bool:
+                integers[nIntegers++] = lua_toboolean(L, idx) ? 1 : 0;
+                break;
+            case Type::String:
+                integers[nIntegers++] = (std::intptr_t)lua_tostring(L, idx);
+                break;
+            case Type::VoidPtr:
+                integers[nIntegers++] = (std::intptr_t)lua_touserdata(L, idx);
+                break;
+            case Type::TableView:
+                views[nIntegers]    = lua_totableview(L, idx);
+                integers[nIntegers] = (std::intptr_t)&views[nIntegers];
+                ++nIntegers;
+                break;
+            case Type::TableBuilder:
+                builder               = lua_newtablebuilder(L); // last parameter, so the arguments above have been read
+                integers[nIntegers++] = (std::intptr_t)&builder;
+                break;
+            case Type::Void:
+                break;
+            }
+        }
+
+        switch (_returnType)
+        {
+        case Type::Void:
+            invoke<void>(function, integers, doubles);
+
+            if (builder.api)
+            {
+                lua_settop(L, builder.index); // the built table is the result, above it may be sub tables accessed via views
+            }
+            break;
+        case Type::Table:
+            lua_pushtable(L, LuaTable(invoke<cbeam::serialization::serialized_object>(function, integers, doubles))); // deserialize the table returned by the shared library
+            break;
+        case Type::LongLong:
+            lua_pushinteger(L, invoke<long long>(function, integers, doubles));
+            break;
+        case Type::Double:
+            lua_pushnumber(L, invoke<double>(function, integers, doubles));
+            break;
+        case Type::Bool:
+            lua_pushboolean(L, invoke<bool>(function, integers, doubles));
+            break;
+        case Type::String:
+            lua_pushstring(L, invoke<const char*>(function, integers, doubles));
+            break;
+        case Type::VoidPtr:
+            lua_pushlightuserdata(L, invoke<void*>(function, integers, doubles));
+            break;
+        case Type::TableView:
+        case Type::TableBuilder:
+            break; // rejected by the constructor
+        }
+#else
+        (void)L;
+        (void)function;
+        throw std::logic_error("GenericDllCall: not supported on this platform");
+#endif
+    }
+}
@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "lua_call_info.hpp"
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+struct lua_State;
+
+#if (defined(__x86_64__) && !defined(_WIN32)) || defined(__aarch64__)
+    #define NEXUSLUA_GENERIC_DLL_CALL ///< the calling convention passes integer and floating point arguments in separate registers, see GenericDllCall
+#endif
+
+namespace nexuslua
+{
+    /// \brief calls functions of shared libraries whose signatures have no generated function (see FindCallDllFunction)
+    /// \details The System V AMD64 and AArch64 calling conventions pass integer and pointer arguments in one set of registers
+    /// and floating point arguments in another, each in the order of the parameters. A function is therefore called with
+    /// all registers of both sets filled, by means of a function pointer type with that many `intptr_t` and `double`
+    /// parameters; the function reads those that belong to its parameters. This supports any order of parameter types
+    /// without generating code for each of them, as long as all arguments fit into registers. On other platforms (e. g.
+    /// Windows, which assigns registers by the position of a parameter), only the generated functions are available.
+    class GenericDllCall
+    {
+    public:
+        enum class Type : unsigned char
+        {
+            Void,
+            Table,
+            LongLong,
+            Double,
+            Bool,
+            String,
+            VoidPtr,
+            TableView,   ///< see table_view.h
+            TableBuilder ///< see table_view.h; only as last parameter of functions returning void
+        };
+
+#if defined(__aarch64__)
+        static constexpr std::size_t integerRegisters = 8;
+#else
+        static constexpr std::size_t integerRegisters = 6;
+#endif
+        static constexpr std::size_t doubleRegisters = 8;
+        static constexpr std::size_t maxArguments    = integerRegisters + doubleRegisters;
+
+        /// parses a signature like `"double(double,long long,const char*)"`; throws std::runtime_error if it cannot be called on this platform
+        explicit GenericDllCall(std::string_view signature);
+
+        void operator()(lua_State* L, DllFunction function) const; ///< calls function with the arguments on the Lua stack and pushes its result, if any
+
+    private:
+        Type                           _returnType{Type::Void};
+        std::array<Type, maxArguments> _arguments{};
+        std::size_t                    _argumentCount{0};
+    };
+}
@@ -0,0 +1,482 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "handler_coroutines.hpp"
+
+#include "agent.hpp"
+#include "agents.hpp"
+#include "lua.hpp"
+#include "lua_extension.hpp"
+#include "mailbox.hpp"
+#include "message_counter.hpp"
+#include "pending_calls.hpp"
+#include "replication_policy.hpp"
+
+#include <cbeam/container/stable_reference_buffer.hpp>
+#include <cbeam/convert/nested_map.hpp>
+#include <cbeam/logging/log_manager.hpp>
+
+extern "C"
+{
+#include "lauxlib.h"
+#include "lualib.h"
+}
+
+#include <chrono>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace nexuslua
+{
+    HandlerCoroutines::HandlerCoroutines(lua_State*                 L,
+                                         const int                  environment,
+                                         Agent*                     agent,
+                                         const std::string&         luaPath,
+                                         const bool                 isReplicated,
+                                         std::shared_ptr<Mailbox>   mailbox,
+                                         const void*                owner,
+                                         std::shared_ptr<AgentLoad> load,
+                                         Reply                      reply)
+        : _L{L}
+        , _environment{environment}
+        , _agent{agent}
+        , _luaPath{luaPath}
+        , _isReplicated{isReplicated}
+        , _mailbox{mailbox}
+        , _owner{owner}
+        , _load{load}
+        , _reply{std::move(reply)}
+        , _alive{std::make_shared<bool>(true)}
+    {
+    }
+
+    HandlerCoroutines::~HandlerCoroutines()
+    {
+        // the instance no longer receives posted tasks (see Mailbox::RemoveHandler), so suspended handlers would never be resumed
+        for (auto& call : _calls)
+        {
+            if (call.second.waiting != 0)
+            {
+                PendingCalls::Cancel(call.second.waiting);
+            }
+
+            message_counter::get()->decrease((int64_t)call.second.messages.size());
+            LuaExtension::RemoveAgentOfLuaState(call.first);
+            luaL_unref(_L, LUA_REGISTRYINDEX, call.second.ref);
+        }
+
+        for (const auto& idle : _idle)
+        {
+            LuaExtension::RemoveAgentOfLuaState(idle.first);
+            luaL_unref(_L, LUA_REGISTRYINDEX, idle.second);
+        }
+
+        for (const auto& function : _functions)
+        {
+            luaL_unref(_L, LUA_REGISTRYINDEX, function.second.name);
+            luaL_unref(_L, LUA_REGISTRYINDEX, function.second.function);
+        }
+    }
+
+    std::size_t HandlerCoroutines::GetPendingCount() const
+    {
+        return _pending;
+    }
+
+    void HandlerCoroutines::Start(std::vector<std::shared_ptr<Message>> messages, const bool batched)
+    {
+        lua_State* coroutine;
+        int        ref;
+
+        if (_idle.empty())
+        {
+            coroutine = lua_newthread(_L);
+            ref       = luaL_ref(_L, LUA_REGISTRYINDEX);
+            LuaExtension::StoreAgentOfLuaState(coroutine, _agent, _luaPath, _isReplicated);
+        }
+        else
+        {
+            coroutine = _idle.back().first;
+            ref       = _idle.back().second;
+            _idle.pop_back();
+        }
+
+        Call call;
+        call.ref      = ref;
+        call.messages = std::move(messages);
+        call.batched  = batched;
+
+        auto it  = _calls.emplace(coroutine, std::move(call)).first;
+        _pending = _calls.size();
+
+        const auto& callMessages = it->second.messages;
+
+        try
+        {
+            pushFunction(coroutine, *callMessages.front());
+
+            // with `lazy=true` (see addmessage), the function gets views that share ownership of the messages, so that only the
+            // parameters it reads are converted
+            const AgentMessage* agentMessage = _agent->FindMessage(callMessages.front()->message_id);
+            const bool          lazy         = agentMessage && agentMessage->IsLazy();
+
+            const auto pushParameters = [coroutine, lazy](const std::shared_ptr<Message>& message)
+            {
+                if (lazy)
+                {
+                    lua_pushtableproxy(coroutine, std::shared_ptr<const LuaTableBase>(message, &message->parameters));
+                }
+                else
+                {
+                    lua_pushtable(coroutine, message->parameters);
+                }
+            };
+
+            if (batched)
+            {
+                lua_createtable(coroutine, (int)callMessages.size(), 0); // array of the message parameters as single argument
+
+                for (std::size_t i = 0; i < callMessages.size(); ++i)
+                {
+                    pushParameters(callMessages[i]);
+                    lua_rawseti(coroutine, -2, (lua_Integer)i + 1);
+                }
+            }
+            else
+            {
+                pushParameters(callMessages.front());
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            fail(it, ex.what());
+            return;
+        }
+
+        resume(coroutine, 1);
+    }
+
+    void HandlerCoroutines::pushFunction(lua_State* coroutine, const Message& message)
+    {
+        if (_environment == LUA_NOREF)
+        {
+            lua_pushglobaltable(coroutine);
+        }
+        else
+        {
+            lua_rawgeti(coroutine, LUA_REGISTRYINDEX, _environment);
+        }
+
+        if (message.message_id >= 0)
+        {
+            // The function is resolved with the first message of its name and called via its registry reference. A script may
+            // assign a different function to the name at any time, e. g. when it is loaded again, so the reference is checked
+            // against the current value, which is looked up with the name kept as Lua string. This neither hashes the name
+            // nor invokes metamethods.
+            auto [it, inserted] = _functions.try_emplace(message.message_id, Function{LUA_NOREF, LUA_NOREF});
+            Function& function  = it->second;
+
+            if (inserted)
+            {
+                lua_pushlstring(_L, message.name.data(), message.name.size());
+                function.name = luaL_ref(_L, LUA_REGISTRYINDEX);
+            }
+
+            lua_rawgeti(coroutine, LUA_REGISTRYINDEX, function.function);
+            lua_rawgeti(coroutine, LUA_REGISTRYINDEX, function.name);
+            lua_rawget(coroutine, -3);
+
+            if (lua_rawequal(coroutine, -1, -2) && lua_isfunction(coroutine, -1))
+            {
+                lua_pop(coroutine, 1);
+                lua_remove(coroutine, -2);
+                return;
+            }
+
+            if (lua_isfunction(coroutine, -1))
+            {
+                // resolved for the first time, or the script assigned another function to the name
+                lua_pushvalue(coroutine, -1);
+
+                if (function.function == LUA_NOREF)
+                {
+                    function.function = luaL_ref(coroutine, LUA_REGISTRYINDEX);
+                }
+                else
+                {
+                    lua_rawseti(coroutine, LUA_REGISTRYINDEX, function.function);
+                }
+
+                lua_remove(coroutine, -2);
+                lua_remove(coroutine, -2);
+                return;
+            }
+
+            lua_pop(coroutine, 2);
+        }
+
+        // e. g. a function that is provided via the metatable of the environment
+        lua_getfield(coroutine, -1, message.name.c_str());
+        lua_remove(coroutine, -2);
+    }
+
+    void HandlerCoroutines::resume(lua_State* coroutine, int arguments)
+    {
+        auto it = _calls.find(coroutine);
+
+        if (it == _calls.end())
+        {
+            return;
+        }
+
+        Call& call = it->second;
+
+        // Reference counting of class cbeam::stable_reference_buffer does not count references held by pure Lua because a pointer in this context
+        // is represented by a string (see cbeam::convert::to_string). To ensure that memory allocated via shared libraries loaded with
+        // nexuslua’s `import` (LuaExtension::Import) isn't prematurely deallocated before the end of this block, we make an instance of
+        // stable_reference_buffer::delay_deallocation. At that end of this block, the memory is held by managed cbeam::memory::pointer instances inside
+        // the result tables. Shared libraries that were loaded via nexuslua’s `import` are automatically unloaded when the last Lua state that
+        // imported them is closed (LuaCallInfo::OpenSharedLibrary), so memory that needs to persist (because it’s accessed by other nexuslua
+        // plugins) must be allocated by cbeam::stable_reference_buffer.
+        cbeam::container::stable_reference_buffer::delay_deallocation delayDeallocation;
+
+        while (true)
+        {
+            const auto start   = std::chrono::high_resolution_clock::now();
+            int        results = 0;
+            int        status;
+
+            try
+            {
+                status = lua_resume(coroutine, nullptr, arguments, &results);
+            }
+            catch (const std::exception& ex)
+            {
+                // e. g. thrown by a nexuslua function, which Lua cannot catch
+                fail(it, ex.what());
+                return;
+            }
+            catch (...)
+            {
+                fail(it, "unknown exception");
+                return;
+            }
+
+            call.seconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            if (status != LUA_YIELD)
+            {
+                finish(coroutine, call, status, results);
+                release(it, status == LUA_OK);
+                return;
+            }
+
+            if (LuaExtension::YieldedByCall(coroutine, results))
+            {
+                if (send(coroutine, call))
+                {
+                    return; // suspended until the reply arrives
+                }
+
+                arguments = 1; // the message could not be sent; `call` returns the error at once
+                continue;
+            }
+
+            lua_pop(coroutine, results); // values passed to coroutine.yield are ignored
+
+            // the handler gives way to the next messages; it continues behind the tasks that are currently queued
+            if (auto mailbox = _mailbox.lock())
+            {
+                mailbox->Post(_owner, [this, coroutine]()
+                              { resume(coroutine, 0); });
+            }
+            return;
+        }
+    }
+
+    bool HandlerCoroutines::send(lua_State* coroutine, Call& call)
+    {
+        // the arguments of `call` are on top of the stack, see LuaExtension::Call
+        const std::string agentName   = lua_tostring(coroutine, -3);
+        const std::string messageName = lua_tostring(coroutine, -2);
+        LuaTable          parameters  = lua_totable(coroutine, -1);
+        lua_pop(coroutine, 4);
+
+        // the reply may arrive on any thread; the handler is resumed on the thread of this instance
+        call.waiting = PendingCalls::Add(
+            [this, coroutine, mailbox = _mailbox, owner = _owner, alive = std::weak_ptr<bool>(_alive)](LuaTable reply)
+            {
+                if (auto locked = mailbox.lock())
+                {
+                    locked->Post(owner, [this, coroutine, alive, reply = std::move(reply)]()
+                                 {
+                        if (alive.lock())
+                        {
+                            deliver(coroutine, reply);
+                        } });
+                }
+            });
+        parameters.SetReplyToCall(call.waiting);
+
+        std::string error;
+
+        try
+        {
+            if (_agent->GetAgents()->GetMessage(agentName, messageName).Send(std::move(parameters)))
+            {
+                return true;
+            }
+
+            error = "the mailbox of the agent is full";
+        }
+        catch (const std::exception& ex)
+        {
+            error = ex.what();
+        }
+
+        PendingCalls::Cancel(call.waiting);
+        call.waiting = 0;
+
+        LuaTable reply;
+        reply.data["error"] = "call of message '" + messageName + "' of agent '" + agentName + "' failed: " + error;
+        lua_pushtable(coroutine, reply);
+
+        return false;
+    }
+
+    void HandlerCoroutines::deliver(lua_State* coroutine, const LuaTable& reply)
+    {
+        auto it = _calls.find(coroutine);
+
+        if (it == _calls.end())
+        {
+            return;
+        }
+
+        it->second.waiting = 0;
+        lua_pushtable(coroutine, reply); // the return value of `call`
+        resume(coroutine, 1);
+    }
+
+    void HandlerCoroutines::finish(lua_State* coroutine, Call& call, const int status, const int results)
+    {
+        const std::string&    functionName = call.messages.front()->name;
+        std::vector<LuaTable> tables(call.messages.size());
+
+        try
+        {
+            if (status != LUA_OK)
+            {
+                const char* message = lua_tostring(coroutine, -1);
+                throw std::runtime_error("Error running function '"s + functionName + "': " + (message ? message : "(error object is not a string)"));
+            }
+
+            if (results > 0 && (lua_istable(coroutine, -results) || (!call.batched && lua_totableproxy(coroutine, -results))))
+            {
+                if (call.batched)
+                {
+                    // the function returns an array with one result table per message; missing entries result in empty replies
+                    for (std::size_t i = 0; i < tables.size(); ++i)
+                    {
+                        if (lua_rawgeti(coroutine, -results, (lua_Integer)i + 1) == LUA_TTABLE || lua_totableproxy(coroutine, -1))
+                        {
+                            tables[i] = lua_totable(coroutine, -1);
+                        }
+                        lua_pop(coroutine, 1);
+                    }
+                }
+                else
+                {
+                    tables.front() = lua_totable(coroutine, -results);
+                }
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            for (auto& table : tables)
+            {
+                table.data["error"] = functionName + ": " + ex.what();
+            }
+        }
+
+        lua_settop(coroutine, 0);
+        _load->AddHandlingTime(call.seconds / (double)call.messages.size());
+
+        for (std::size_t i = 0; i < tables.size(); ++i)
+        {
+            auto error = tables[i].data.find("error");
+
+            if (error != tables[i].data.end() && std::get_if<std::string>(&error->second))
+            {
+                CBEAM_LOG(_luaPath + ": Error running function '" + functionName + "': " + std::get<std::string>(error->second) + "\n" + cbeam::convert::to_string(call.messages[i]->parameters));
+            }
+            else
+            {
+                CBEAM_LOG_DEBUG(_luaPath + " -> " + functionName + ": success");
+            }
+
+            try
+            {
+                _reply(call.messages[i], tables[i]);
+            }
+            catch (const std::exception& ex)
+            {
+                CBEAM_LOG(_luaPath + ": reply to '"s + functionName + "': " + ex.what());
+            }
+        }
+
+        message_counter::get()->decrease((int64_t)call.messages.size());
+    }
+
+    void HandlerCoroutines::fail(Calls::iterator it, const std::string& error)
+    {
+        // replies with the error like for an error raised by Lua, but the coroutine is not reused, because the exception may
+        // have left it in the middle of a function
+        lua_settop(it->first, 0);
+        lua_pushstring(it->first, error.c_str());
+        finish(it->first, it->second, LUA_ERRRUN, 1);
+        release(it, false);
+    }
+
+    void HandlerCoroutines::release(Calls::iterator it, const bool reusable)
+    {
+        lua_State* coroutine = it->first;
+
+        // a coroutine that returned normally can run the next handler; one that raised an error is dead
+        if (reusable && _idle.size() < maxIdleCoroutines)
+        {
+            _idle.emplace_back(coroutine, it->second.ref);
+        }
+        else
+        {
+            LuaExtension::RemoveAgentOfLuaState(coroutine);
+            luaL_unref(_L, LUA_REGISTRYINDEX, it->second.ref);
+        }
+
+        _calls.erase(it);
+        _pending = _calls.size();
+    }
+}
@@ -0,0 +1,124 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "lua_table.hpp"
+#include "message.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct lua_State;
+
+namespace nexuslua
+{
+    class Agent;
+    class AgentLoad;
+    class Mailbox;
+
+    /// \brief runs the message handlers of a Lua agent in coroutines, so that they can be suspended
+    /// \details A handler is suspended if it calls `coroutine.yield` or waits for the reply of \ref call. Meanwhile the
+    /// instance of the agent continues with its next messages. The handler is resumed by a task that is posted to the
+    /// Mailbox of the agent (see Mailbox::Post), so that it always runs on the thread that executes the instance. Except
+    /// for the destructor and GetPendingCount, the methods must only be called on that thread.
+    class HandlerCoroutines
+    {
+    public:
+        using Reply = std::function<void(const std::shared_ptr<Message>& message, LuaTable& result)>; ///< passes the result of a handler to the sender of the message
+
+        /// \param L the Lua state that contains the message functions
+        /// \param environment registry reference of the table that contains the message functions, or LUA_NOREF for the globals of L
+        /// \param owner the instance of the agent, as registered by Mailbox::AddHandler
+        HandlerCoroutines(lua_State*                 L,
+                          int                        environment,
+                          Agent*                     agent,
+                          const std::string&         luaPath,
+                          bool                       isReplicated,
+                          std::shared_ptr<Mailbox>   mailbox,
+                          const void*                owner,
+                          std::shared_ptr<AgentLoad> load,
+                          Reply                      reply);
+        ~HandlerCoroutines(); ///< discards suspended handlers together with their messages
+
+        void        Start(std::vector<std::shared_ptr<Message>> messages, bool batched); ///< calls the function of the messages with a single message, or with an array of them if batched is true
+        std::size_t GetPendingCount() const;                                             ///< number of handlers that have been started, but not finished yet
+
+        HandlerCoroutines(const HandlerCoroutines&)            = delete;
+        HandlerCoroutines& operator=(const HandlerCoroutines&) = delete;
+
+        static constexpr std::size_t maxIdleCoroutines = 8; ///< coroutines of handlers that returned are reused up to this number
+
+    private:
+        /// a call of a message handler in its own coroutine, which is either running or suspended
+        struct Call
+        {
+            int                                   ref{0};         ///< keeps the coroutine in the registry of the Lua state
+            std::vector<std::shared_ptr<Message>> messages;       ///< a single message, unless the function accepts batches
+            bool                                  batched{false}; ///< true if the function is called with an array of messages
+            double                                seconds{0};     ///< time spent running, excluding suspensions
+            long long                             waiting{0};     ///< id of the PendingCalls entry whose reply the handler waits for, or 0
+        };
+
+        using Calls = std::map<lua_State*, Call>;
+
+        /// the function that handles the messages of one name
+        struct Function
+        {
+            int name;     ///< registry reference of the message name as Lua string
+            int function; ///< registry reference of the function found under that name, or LUA_NOREF
+        };
+
+        void pushFunction(lua_State* coroutine, const Message& message); ///< pushes the function that handles message
+        void resume(lua_State* coroutine, int arguments);
+        void deliver(lua_State* coroutine, const LuaTable& reply);
+        bool send(lua_State* coroutine, Call& call);
+        void finish(lua_State* coroutine, Call& call, int status, int results);
+        void fail(Calls::iterator it, const std::string& error); ///< finishes the call with error after a C++ exception and discards its coroutine
+        void release(Calls::iterator it, bool reusable);
+
+        lua_State* const                        _L;
+        const int                               _environment;
+        Agent* const                            _agent;
+        const std::string                       _luaPath;
+        const bool                              _isReplicated;
+        const std::weak_ptr<Mailbox>            _mailbox;
+        const void* const                       _owner;
+        const std::shared_ptr<AgentLoad>        _load;
+        const Reply                             _reply;
+        Calls                                   _calls;
+        std::vector<std::pair<lua_State*, int>> _idle;          ///< coroutines of handlers that returned, with their registry references
+        std::unordered_map<int, Function>       _functions;     ///< by Message::message_id
+        std::atomic<std::size_t>                _pending{0};
+        std::shared_ptr<bool>                   _alive; ///< expires when this instance is destroyed, so that a late reply to a cancelled call is ignored
+    };
+}
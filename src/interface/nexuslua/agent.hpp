@@ -65,20 +65,23 @@ namespace nexuslua
         Agent(const std::shared_ptr<agents>& agents);
         virtual ~Agent();
 
-        virtual std::string                                GetName() const = 0;                              ///< return the name of the agent
-        virtual std::filesystem::path                      GetInstallFolder() const;                         ///< if this agent is installed as a plugin, return its installation folder, otherwise an empty string
-        virtual std::filesystem::path                      GetPersistentFolder() const;                      ///< if this agent is installed as a plugin, return the sub folder inside the installation folder that persists during updates, otherwise an empty string
-        virtual std::string                                GetVersionOnline() const;                         ///< if this agent is installed as a plugin, return the online version, otherwise an empty string
-        virtual std::string                                GetVersionInstalled() const;                      ///< if this agent is installed as a plugin, return its installed version, otherwise an empty string
-        virtual bool                                       IsFreeware() const;                               ///< if this agent is installed as a plugin, return if it is freeware, otherwise `false`
-        virtual std::string                                GetUrlHelp() const;                               ///< if this agent is installed as a plugin, return the URL that contains help about it, otherwise an empty string
-        virtual std::string                                GetUrlDownload() const;                           ///< if this agent is installed as a plugin, return its download URL, otherwise an empty string
-        virtual std::string                                GetUrlLicense() const;                            ///< if this agent is installed as a plugin, return an URL with license information, otherwise an empty string
-        virtual std::string                                GetUrlPurchase() const;                           ///< if this agent is installed as a plugin, return an URL where you can purchase a license, otherwise an empty string
-        virtual std::string                                GetLicensee() const;                              ///< if this agent is installed as a plugin and a license file has been installed, return the licensee, otherwise an empty string
-        virtual const std::map<std::string, AgentMessage>& GetMessages() const;                              ///< return a reference to all of the messages this agent supports, using the message name as key
-        virtual const AgentMessage&                        GetMessage(const std::string& messageName) const; ///< return the message with the given name that this agent accepts
-        int                                                GetId() const;                                    ///< returns a unique ID of this agent
+        virtual std::string                                GetName() const = 0;                               ///< return the name of the agent
+        virtual std::filesystem::path                      GetInstallFolder() const;                          ///< if this agent is installed as a plugin, return its installation folder, otherwise an empty string
+        virtual std::filesystem::path                      GetPersistentFolder() const;                       ///< if this agent is installed as a plugin, return the sub folder inside the installation folder that persists during updates, otherwise an empty string
+        virtual std::string                                GetVersionOnline() const;                          ///< if this agent is installed as a plugin, return the online version, otherwise an empty string
+        virtual std::string                                GetVersionInstalled() const;                       ///< if this agent is installed as a plugin, return its installed version, otherwise an empty string
+        virtual bool                                       IsFreeware() const;                                ///< if this agent is installed as a plugin, return if it is freeware, otherwise `false`
+        virtual std::string                                GetUrlHelp() const;                                ///< if this agent is installed as a plugin, return the URL that contains help about it, otherwise an empty string
+        virtual std::string                                GetUrlDownload() const;                            ///< if this agent is installed as a plugin, return its download URL, otherwise an empty string
+        virtual std::string                                GetUrlLicense() const;                             ///< if this agent is installed as a plugin, return an URL with license information, otherwise an empty string
+        virtual std::string                                GetUrlPurchase() const;                            ///< if this agent is installed as a plugin, return an URL where you can purchase a license, otherwise an empty string
+        virtual std::string                                GetLicensee() const;                               ///< if this agent is installed as a plugin and a license file has been installed, return the licensee, otherwise an empty string
+        virtual const std::map<std::string, AgentMessage>& GetMessages() const;                               ///< return a reference to all of the messages this agent supports, using the message name as key
+        virtual const AgentMessage&                        GetMessage(const std::string& messageName) const;  ///< return the message with the given name that this agent accepts
+        const AgentMessage*                                FindMessage(int messageId) const;                  ///< return the message with the given AgentMessage::GetMessageId() that this agent accepts, or nullptr
+        const AgentMessage*                                FindMessage(const std::string& messageName) const; ///< like GetMessage, but returns nullptr for an unknown message and may be called while messages are added
+        int                                                GetId() const;                                     ///< returns a unique ID of this agent
+        std::size_t                                        GetReplicaCount() const;                           ///< returns the number of replicas that currently process messages of this agent in addition to the agent itself (see \ref Configuration::luaReplicaIdleTimeout)
 
         Configuration&          GetConfiguration();
         std::shared_ptr<agents> GetAgents();
@@ -86,7 +89,9 @@ namespace nexuslua
     protected:
         void         Start(const std::filesystem::path& luaPath, const std::string& luaCode);
         void         Start(const CppHandler& cppHandler);
-        virtual void AddMessage(const std::string& messageName, const LuaTable::nested_tables& parameterDescriptions, const std::string& displayName, const std::string& description, const std::string& icon);
+        void         Start(const CppBatchHandler& cppBatchHandler);
+        virtual void AddMessage(const std::string& messageName, const LuaTable::nested_tables& parameterDescriptions, const std::string& displayName, const std::string& description, const std::string& icon, bool batched, bool lazy);
+        void         IndexMessage(const AgentMessage& message); ///< makes a message of _messages available to the FindMessage overloads
 
         std::map<std::string, AgentMessage> _messages;
         friend void ::nexuslua::LuaExtension::AddMessage(Agent* agent, const std::string& luaPath, const std::string& messageName, const LuaTable& parameters);
@@ -30,6 +30,8 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 #include "nexuslua_export.h"
 
 #include <atomic>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 
@@ -44,7 +46,7 @@ namespace nexuslua
         Cpp       = 1
     };
 
-    /// \brief This class describes a message that can be sent via nexuslua \ref send or AgentMessage::Send.
+    /// \brief This class describes a message that can be sent via nexuslua \ref send or AgentMessage::Send, or called via \ref call or AgentMessage::Call.
     /// \details An instance of this class can be created via \ref addmessage or nexuslua::agents::AddMessageForCppAgent. Please note that the actual data that is sent is composed of AgentMessage::GetMessageName() along with the cbeam::serialization::serialized_object that is passed to the AgentMessage::Send method.
     class NEXUSLUA_EXPORT AgentMessage
     {
@@ -52,31 +54,53 @@ namespace nexuslua
         AgentType               GetAgentType() const;                                                    ///< return the type of the agent that accepts this message (Lua or C++)
         std::string             GetAgentName() const;                                                    ///< return the name of the agent that accepts this message
         std::string             GetMessageName() const;                                                  ///< this message name is used by AgentMessage::Send
+        int                     GetMessageId() const;                                                    ///< return the message name interned to a dense ID, which is passed to the receiving agent along with the name (see Message::message_id)
         std::string             GetDisplayName() const;                                                  ///< return a display name of this message (may be empty, usually set for agents that are used as plugins, see PluginsOnline::Get)
         std::string             GetDescription() const;                                                  ///< return a description of this message (may be empty, usually set for agents that are used as plugins, see PluginsOnline::Get)
         LuaTable::nested_tables GetParameterDescriptions() const;                                        ///< return descriptions for each of the parameters of this message (may be empty, usually set for agents that are used as plugins, see PluginsOnline::Get)
         LuaTable::nested_tables GetDescriptionsOfUnsetParameters(const LuaTable& parameterValues) const; ///< convenience method. Returns only those descriptions of parameters that are not part of the given parameter values  (may be empty, usually set for agents that are used as plugins, see PluginsOnline::Get)
         std::string             GetIconPath() const;                                                     ///< return the path to an icon that can be shown in a graphical user interface for this message (may be empty, usually set for agents that are used as plugins, see PluginsOnline::Get)
-        void                    Send(const LuaTable& parameters) const;                                  ///< completes values that are missing in parameters based on GetParameterDescriptions() with their default values and sends the message (named GetMessageName()).
+        bool                    IsBatched() const;                                                       ///< return if the agent receives queued messages of this name in batches, see \ref addmessage and nexuslua::CppBatchHandler
+        bool                    IsLazy() const;                                                          ///< return if the Lua function of this message receives its parameters as read-only view instead of a Lua table, see \ref addmessage and lua_pushtableproxy
+        bool                    Send(const LuaTable& parameters) const;                                  ///< completes values that are missing in parameters based on GetParameterDescriptions() with their default values and sends the message (named GetMessageName()). Returns false if the message was discarded because the mailbox of the receiving agent is full, see Configuration::mailboxOverflow.
+        bool                    TrySend(const LuaTable& parameters) const;                               ///< like Send, but never waits for space in a full mailbox of the receiving agent (Configuration::mailboxOverflowBlock); returns false instead
+        bool                    Send(LuaTable&& parameters) const;                                       ///< like Send(const LuaTable&), but moves parameters into the message instead of copying them
+        bool                    TrySend(LuaTable&& parameters) const;                                    ///< like TrySend(const LuaTable&), but moves parameters into the message instead of copying them
+
+        /// like Send, but returns the table that the function of the message returns, or an empty table for C++ agents
+        /// \details The reply is not sent as a message, but passed directly to the future, see \ref call. If the message
+        /// could not be sent, the future throws std::runtime_error. If the message is discarded later, because a newer one
+        /// arrived at the full mailbox of the receiving agent (Configuration::mailboxOverflowDropOldest), the returned table
+        /// contains an entry `error` instead.
+        std::future<LuaTable> Call(const LuaTable& parameters) const;
+
+        /// like Call, but passes the reply to callback, which is invoked by the thread of the receiving agent and should return quickly
+        /// \details Returns false if the message could not be sent; callback is not invoked in this case. If the message is
+        /// discarded later, callback is invoked by the sender of the newer message with a table that contains an entry `error`.
+        bool Call(const LuaTable& parameters, std::function<void(LuaTable reply)> callback) const;
 
     private:
         friend class Agent;
         friend class AgentCpp;
 
-        AgentMessage(const int agentN, const AgentType& agentType, const std::string& agentName, const std::string& messageName, const LuaTable::nested_tables& parameterDescriptions, const std::string& displayName, const std::string& description, const std::string& icon);
-        AgentMessage(const int agentN, const AgentType& agentType, const std::string& agentName, const std::string& messageName);
+        AgentMessage(const int agentN, const AgentType& agentType, const std::string& agentName, const std::string& messageName, const LuaTable::nested_tables& parameterDescriptions, const std::string& displayName, const std::string& description, const std::string& icon, const bool batched, const bool lazy);
+        AgentMessage(const int agentN, const AgentType& agentType, const std::string& agentName, const std::string& messageName, const bool batched);
 
         int                     _agentN;
         AgentType               _agentType;
         std::string             _agentName;
         std::string             _messageName;
+        int                     _messageId;
         LuaTable::nested_tables _parameterDescriptions;
         std::string             _displayName;
         std::string             _description;
         std::string             _svgIcon;
+        bool                    _batched;
+        bool                    _lazy;
         std::shared_ptr<Lua>    _lua;
 
-        void     Validate(const LuaTable& parameterValues) const;
-        LuaTable AddDefaultParameterValues(const LuaTable& parameterValues) const;
+        bool Send(LuaTable parameterValues, bool mayBlock) const;
+        void Validate(const LuaTable& parameterValues) const;
+        void AddDefaultParameterValues(LuaTable& parameterValues) const;
     };
 }
@@ -35,6 +35,7 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace nexuslua
 {
@@ -43,6 +44,7 @@ namespace nexuslua
     class AgentLua;
     class PluginSpec;
     class AgentMessage;
+    class Configuration;
 
     /// \brief Functions related to agents or plugins, which are (un-)installable agents with meta data like a version, see class nexuslua::Agent
     class NEXUSLUA_EXPORT agents : public std::enable_shared_from_this<agents>
@@ -62,6 +64,10 @@ namespace nexuslua
         PluginUninstallResult                                      UninstallPlugin(const std::string& name);                                                                                          ///< the name is identical with AgentPlugin::GetName()
         void                                                       RestorePersistentPluginFolder(const std::shared_ptr<::nexuslua::Agent>& plugin, const std::filesystem::path& srcFolder);           ///< copy the persistent subfolder from the given directory to the plugin folder
         const AgentMessage&                                        GetMessage(const std::string& agentName, const std::string& messageName);                                                          ///< return the given message
+        Configuration&                                             GetConfiguration();                                                                                                                ///< return the configuration that agents added afterwards start with, e. g. to select Configuration::schedulerPool before calling agents::Add
+        std::vector<std::size_t>                                   GetQueueDepths(const std::string& agentName);                                                                                      ///< return the number of messages waiting for the given agent, per priority lane (see Configuration::mailboxLanes)
+        std::size_t                                                GetQueueHighWaterMark(const std::string& agentName);                                                                               ///< return the maximum number of messages that have been waiting for the given agent at the same time
+        std::size_t                                                GetQueueOverflowCount(const std::string& agentName);                                                                               ///< return the number of messages to the given agent that have been discarded because its mailbox was full (see Configuration::mailboxCapacity)
 
         /// \brief creates a new hardware thread that calls cppHandler as soon as a message is sent to it via either nexuslua send, or nexuslua::AgentMessage::Send
         /// @param agentName the name of the agent to be added
@@ -70,6 +76,13 @@ namespace nexuslua
         /// @return a shared pointer to the newly added agent
         std::shared_ptr<AgentCpp> Add(const std::string& agentName, const CppHandler& cppHandler, const LuaTable& predefinedTable = {});
 
+        /// \brief like agents::Add, but cppBatchHandler receives all queued messages of the same name at once, see \link nexuslua::CppBatchHandler CppBatchHandler \endlink
+        /// @param agentName the name of the agent to be added
+        /// @param cppBatchHandler the handler for the agent, which needs to have the signature \link nexuslua::CppBatchHandler CppBatchHandler \endlink
+        /// @param predefinedTable can be used to predefine arbitrary Lua tables, e. g. the default table arg containing command line arguments of the Lua executable
+        /// @return a shared pointer to the newly added agent
+        std::shared_ptr<AgentCpp> AddBatched(const std::string& agentName, const CppBatchHandler& cppBatchHandler, const LuaTable& predefinedTable = {});
+
         /// \brief creates a new hardware thread that calls luaCode, if not empty, otherwise the given lua file
         /// @param agentName the name of the agent to be added
         /// @param pathToLuaFile either the path of the Lua file that shall be used to handle messages, or the path to the Lua file that contains the luaCode given in the third parameter
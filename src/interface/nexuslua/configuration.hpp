@@ -43,7 +43,24 @@ namespace nexuslua
     public:
         Configuration()
         {
-            _t.sub_tables[(std::string)internal].data[(std::string)luaStartNewThreadTime] = 0.01;
+            _t.sub_tables[(std::string)internal].data[(std::string)luaStartNewThreadTime]       = 0.01;
+            _t.sub_tables[(std::string)internal].data[(std::string)scheduler]                   = (std::string)schedulerThreads;
+            _t.sub_tables[(std::string)internal].data[(std::string)schedulerWorkers]            = 0LL;
+            _t.sub_tables[(std::string)internal].data[(std::string)schedulerHosts]              = 0LL;
+            _t.sub_tables[(std::string)internal].data[(std::string)mailboxLanes]                = 4LL;
+            _t.sub_tables[(std::string)internal].data[(std::string)mailboxDequeue]              = (std::string)mailboxDequeueStrict;
+            _t.sub_tables[(std::string)internal].data[(std::string)mailboxCapacity]             = 0LL;
+            _t.sub_tables[(std::string)internal].data[(std::string)mailboxOverflow]             = (std::string)mailboxOverflowBlock;
+            _t.sub_tables[(std::string)internal].data[(std::string)messageBatchSize]            = 64LL;
+            _t.sub_tables[(std::string)internal].data[(std::string)messageBatchLinger]          = 0.0;
+            _t.sub_tables[(std::string)internal].data[(std::string)luaReplicaPoolSize]          = 0LL;
+            _t.sub_tables[(std::string)internal].data[(std::string)luaReplicaWarmup]            = (std::string)luaReplicaWarmupEager;
+            _t.sub_tables[(std::string)internal].data[(std::string)luaReplicaIdleTimeout]       = 0.0;
+            _t.sub_tables[(std::string)internal].data[(std::string)luaReplicationPolicy]        = (std::string)luaReplicationPolicyIdleTime;
+            _t.sub_tables[(std::string)internal].data[(std::string)luaReplicationTargetLatency] = 0.01;
+            _t.sub_tables[(std::string)internal].data[(std::string)luaReplicationCoreBudget]    = 0LL;
+            _t.sub_tables[(std::string)internal].data[(std::string)cpuAffinity]                 = (std::string)cpuAffinityNone;
+            _t.sub_tables[(std::string)internal].data[(std::string)cpuAffinityCores]            = std::string();
 
 #if CBEAM_DEBUG_LOGGING
             _t.sub_tables[(std::string)internal].data[(std::string)logMessages]    = true;
@@ -63,6 +80,13 @@ namespace nexuslua
             return _t.sub_tables[(std::string)internal].get_mapped_value_or_throw<T>((std::string)key);
         }
 
+        template <typename T>
+        void SetInternal(const std::string_view& key, const T& value) ///< set the given configuration value
+        {
+            std::lock_guard lock(_mtx);
+            _t.sub_tables[(std::string)internal].data[(std::string)key] = value;
+        }
+
         LuaTable GetTable() ///< get the whole configuration table, including internal configuration
         {
             std::lock_guard lock(_mtx);
@@ -75,10 +99,43 @@ namespace nexuslua
             _t = t;
         }
 
-        static constexpr std::string_view internal{"internal"};                           ///< the name of the SubTable the contains the list of internal values, like the following
-        static constexpr std::string_view luaStartNewThreadTime{"luaStartNewThreadTime"}; ///< stores a double value in seconds that is used to decide after which non-idle time an agent replicates, i. e. creates another hardware thread to distribute work load.
-        static constexpr std::string_view logMessages{"logMessages"};                     ///< stores a bool value (default false); if true, all nexuslua messages are logged to "nexuslua.log" in the user folder (see cbeam::filesystem::get_user_data_dir)
-        static constexpr std::string_view logReplication{"logReplication"};               ///< stores a bool value (default false); if true, each time an agent is replicated a corresponding log entry is created in file "nexuslua.log" in the user folder (see cbeam::filesystem::get_user_data_dir)
+        static constexpr std::string_view internal{"internal"};                                       ///< the name of the SubTable the contains the list of internal values, like the following
+        static constexpr std::string_view luaStartNewThreadTime{"luaStartNewThreadTime"};             ///< stores a double value in seconds that is used to decide after which non-idle time an agent replicates, i. e. creates another hardware thread to distribute work load.
+        static constexpr std::string_view logMessages{"logMessages"};                                 ///< stores a bool value (default false); if true, all nexuslua messages are logged to "nexuslua.log" in the user folder (see cbeam::filesystem::get_user_data_dir)
+        static constexpr std::string_view logReplication{"logReplication"};                           ///< stores a bool value (default false); if true, each time an agent is replicated a corresponding log entry is created in file "nexuslua.log" in the user folder (see cbeam::filesystem::get_user_data_dir)
+        static constexpr std::string_view scheduler{"scheduler"};                                     ///< stores a string value (default \ref schedulerThreads) that selects how newly started agents are executed, either \ref schedulerThreads, \ref schedulerPool or \ref schedulerCoroutines
+        static constexpr std::string_view schedulerWorkers{"schedulerWorkers"};                       ///< stores an integer value (default 0) with the number of worker threads of the pool used by \ref schedulerPool; 0 means one worker per core. Only evaluated when the pool is created by the first agent that uses it.
+        static constexpr std::string_view schedulerThreads{"threads"};                                ///< value of \ref scheduler: each agent (and each replica) gets its own operating system thread
+        static constexpr std::string_view schedulerPool{"pool"};                                      ///< value of \ref scheduler: the agent's messages are processed by a fixed pool of work-stealing worker threads shared by all agents with this setting
+        static constexpr std::string_view schedulerCoroutines{"coroutines"};                          ///< value of \ref scheduler: a Lua agent is a coroutine with its own global environment inside the Lua state of one of \ref schedulerHosts host threads, which process the messages of all their agents one at a time. This allows for many thousands of agents. C++ agents with this setting are executed by the host threads, too.
+        static constexpr std::string_view schedulerHosts{"schedulerHosts"};                           ///< stores an integer value (default 0) with the number of host threads used by \ref schedulerCoroutines; 0 means one host per core. Only evaluated when the first agent with this setting is started.
+        static constexpr std::string_view mailboxLanes{"mailboxLanes"};                               ///< stores an integer value (default 4) with the number of priority lanes of the message queue of newly started agents (at most 16). The message entry `queue` selects the lane, 0 being the highest priority and the default.
+        static constexpr std::string_view mailboxDequeue{"mailboxDequeue"};                           ///< stores a string value (default \ref mailboxDequeueStrict) that selects in which order the priority lanes of newly started agents are processed
+        static constexpr std::string_view mailboxDequeueStrict{"strict"};                             ///< value of \ref mailboxDequeue: a message is only taken from a lane if all lanes with higher priority are empty
+        static constexpr std::string_view mailboxDequeueWeighted{"weighted"};                         ///< value of \ref mailboxDequeue: weighted round robin, each lane gets twice the share of the next lower priority lane, so that no lane is starved
+        static constexpr std::string_view mailboxCapacity{"mailboxCapacity"};                         ///< stores an integer value (default 0) with the maximum number of queued messages of newly started agents, summed over all lanes; 0 means unbounded. See \ref mailboxOverflow for what happens if it is reached.
+        static constexpr std::string_view mailboxOverflow{"mailboxOverflow"};                         ///< stores a string value (default \ref mailboxOverflowBlock) that selects what happens to a message sent to an agent whose mailbox holds \ref mailboxCapacity messages
+        static constexpr std::string_view mailboxOverflowBlock{"block"};                              ///< value of \ref mailboxOverflow: the sender waits until the agent took a message from its mailbox, unless it uses AgentMessage::TrySend. Agents executed by \ref schedulerPool or \ref schedulerCoroutines never wait, but exceed the capacity.
+        static constexpr std::string_view mailboxOverflowFail{"fail"};                                ///< value of \ref mailboxOverflow: the message is discarded and AgentMessage::Send returns false
+        static constexpr std::string_view mailboxOverflowDropOldest{"dropoldest"};                    ///< value of \ref mailboxOverflow: the oldest queued message of the lowest priority lane is discarded to make room for the new one
+        static constexpr std::string_view messageBatchSize{"messageBatchSize"};                       ///< stores an integer value (default 64) with the maximum number of messages that are passed in one call to a message handler that accepts batches, i. e. a Lua function registered with `batch=true` (see \ref addmessage) or a nexuslua::CppBatchHandler. Evaluated when the agent is started.
+        static constexpr std::string_view messageBatchLinger{"messageBatchLinger"};                   ///< stores a double value in seconds (default 0) that a handler accepting batches waits for further messages if fewer than \ref messageBatchSize are queued. 0 passes only the messages that are already queued.
+        static constexpr std::string_view luaReplicaPoolSize{"luaReplicaPoolSize"};                   ///< stores an integer value (default 0) with the number of replicas of a Lua agent that are initialized in the background before they are needed, so that replication does not have to wait for a new Lua state running the agent's script. 0 disables the pool.
+        static constexpr std::string_view luaReplicaWarmup{"luaReplicaWarmup"};                       ///< stores a string value (default \ref luaReplicaWarmupEager) that selects when the replicas of \ref luaReplicaPoolSize are created
+        static constexpr std::string_view luaReplicaWarmupEager{"eager"};                             ///< value of \ref luaReplicaWarmup: replicas are prepared as soon as the agent is started
+        static constexpr std::string_view luaReplicaWarmupOnDemand{"demand"};                         ///< value of \ref luaReplicaWarmup: replicas are prepared after the agent replicated for the first time, i. e. only for agents that actually get busy
+        static constexpr std::string_view luaReplicaIdleTimeout{"luaReplicaIdleTimeout"};             ///< stores a double value in seconds (default 0); replicas of a Lua agent that did not process a message for this time are removed again. 0 keeps all replicas until the agent is destroyed.
+        static constexpr std::string_view luaReplicationPolicy{"luaReplicationPolicy"};               ///< stores a string value (default \ref luaReplicationPolicyIdleTime) that selects how a Lua agent decides to replicate when it receives a message with a `threads` entry, see ReplicationPolicy. Evaluated when the agent is started.
+        static constexpr std::string_view luaReplicationPolicyIdleTime{"idletime"};                   ///< value of \ref luaReplicationPolicy: replicate if the previous message was finished less than \ref luaStartNewThreadTime ago
+        static constexpr std::string_view luaReplicationPolicyQueueDepth{"queuedepth"};               ///< value of \ref luaReplicationPolicy: replicate if the queued messages would wait longer than \ref luaReplicationTargetLatency, based on the average handling time of the agent
+        static constexpr std::string_view luaReplicationTargetLatency{"luaReplicationTargetLatency"}; ///< stores a double value in seconds (default 0.01) with the expected waiting time of queued messages above which \ref luaReplicationPolicyQueueDepth replicates
+        static constexpr std::string_view luaReplicationCoreBudget{"luaReplicationCoreBudget"};       ///< stores an integer value (default 0) with the maximum number of replicas of all agents together that \ref luaReplicationPolicyQueueDepth creates; 0 means the number of cores
+        static constexpr std::string_view cpuAffinity{"cpuAffinity"};                                 ///< stores a string value (default \ref cpuAffinityNone) that selects on which cores the handler threads of newly started agents and of their replicas run, see CpuAffinity. Only evaluated for \ref schedulerThreads; the worker threads of \ref schedulerPool are not bound.
+        static constexpr std::string_view cpuAffinityCores{"cpuAffinityCores"};                       ///< stores a string value (default empty, i. e. all cores) with the cores used by \ref cpuAffinity, as a list of core indices and ranges like "0-3,6"
+        static constexpr std::string_view cpuAffinityNone{"none"};                                    ///< value of \ref cpuAffinity: the operating system places the threads, only the cores of agents using \ref cpuAffinityIsolate are avoided
+        static constexpr std::string_view cpuAffinityPin{"pin"};                                      ///< value of \ref cpuAffinity: the threads may run on any of the \ref cpuAffinityCores
+        static constexpr std::string_view cpuAffinitySpread{"spread"};                                ///< value of \ref cpuAffinity: each thread, i. e. the agent and each of its replicas, is bound to a single core, taking the \ref cpuAffinityCores round robin
+        static constexpr std::string_view cpuAffinityIsolate{"isolate"};                              ///< value of \ref cpuAffinity: like \ref cpuAffinityPin, and the threads of agents started afterwards avoid these cores as long as other cores are left; requires \ref cpuAffinityCores
 
     private:
         LuaTable   _t;
@@ -27,6 +27,7 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 
 #include <functional>
 #include <memory>
+#include <span>
 
 namespace nexuslua
 {
@@ -36,4 +37,10 @@ namespace nexuslua
     /// \details The callback function is registered via nexuslua::agents::Add. All message names
     /// that will be sent must first be registered via nexuslua::agents::AddMessageForCppAgent.
     typedef std::function<void(std::shared_ptr<Message>)> CppHandler;
+
+    /// \brief the signature of a function that is called with several messages at once whenever a C++ nexuslua::agent receives messages
+    /// \details The callback function is registered via nexuslua::agents::AddBatched. All queued messages of the same name, up to
+    /// Configuration::messageBatchSize, are passed in one call, waiting at most Configuration::messageBatchLinger for more of them.
+    /// If only a single message is queued, the span has one element.
+    typedef std::function<void(std::span<std::shared_ptr<Message>>)> CppBatchHandler;
 }
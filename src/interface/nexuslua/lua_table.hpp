@@ -61,14 +61,17 @@ namespace nexuslua
         /// \brief construct LuaTable from an instance of its base class
         LuaTable(const cbeam::container::nested_map<cbeam::container::xpod::type, cbeam::container::xpod::type>& baseInstance);
 
-        void         SetOriginalMessage(const std::shared_ptr<Message> originalMessage);       ///< Copies the given message into a sub table (cbeam::container::nested_map::sub_tables) with name \ref nexuslua::Message::originalMessageTableId "\"original_message\"". Its name is copied to key \ref nexuslua::Message::originalMessageNameId "\"message_name\"" and its parameters into a cbeam::container::nested_map::sub_tables entry \ref nexuslua::Message::originalMessageParametersId "\"parameters\""
-        void         SetReplyTo(const std::string& agentName, const std::string& messageName); ///< Sets the entries \ref agentNameId "\"reply_to/agent\"" and \ref agentMessageId "\"reply_to/message\"" to the given strings, which will trigger an automatic reply-to message with the return value of a function.
-        void         SetReplyToAgentName(const std::string& agentName);                        ///< only sets the entry \ref agentNameId "\"reply_to/agent\"" to the given name, leaves the \ref agentMessageId "\"reply_to/message\"" unchanged
-        void         SetReplyToMessageName(const std::string& messageName);                    ///< only sets the entry \ref agentMessageId "\"reply_to/message\"" to the given message name, leaves the \ref agentNameId "\"reply_to/agent\"" unchanged
-        std::string  GetReplyToAgentNameOrEmpty() const;                                       ///< if there is an entry \ref agentNameId "\"reply_to/agent\"", returns it, otherwise returns the empty string
-        std::string  GetReplyToMessageNameOrEmpty() const;                                     ///< if there is an entry \ref agentMessageId "\"reply_to/message\"", returns it, otherwise returns the empty string
-        bool         RequestsUnreplicatedReceiver() const;                                     ///< return true if the table represents message parameters from a sender that requests that the message must be received by a non-replicated instance of the lua script that contains the message function
-        LuaTableBase GetTableToMergeWhenReplyingOrEmpty() const;                               ///< if there is a table entry \ref tableToMergeWhenReplyingId "\"reply_to/merge\"", return it, otherwise an empty \ref nexuslua::LuaTableBase
+        void         SetOriginalMessage(const std::shared_ptr<Message> originalMessage);                 ///< Copies the given message into a sub table (cbeam::container::nested_map::sub_tables) with name \ref nexuslua::Message::originalMessageTableId "\"original_message\"". Its name is copied to key \ref nexuslua::Message::originalMessageNameId "\"message_name\"" and its parameters into a cbeam::container::nested_map::sub_tables entry \ref nexuslua::Message::originalMessageParametersId "\"parameters\""
+        void         SetOriginalMessage(const std::string& originalName, LuaTable&& originalParameters); ///< like SetOriginalMessage(const std::shared_ptr<Message>), but moves the parameters of the original message instead of copying them
+        void         SetReplyTo(const std::string& agentName, const std::string& messageName);           ///< Sets the entries \ref agentNameId "\"reply_to/agent\"" and \ref agentMessageId "\"reply_to/message\"" to the given strings, which will trigger an automatic reply-to message with the return value of a function.
+        void         SetReplyToAgentName(const std::string& agentName);                                  ///< only sets the entry \ref agentNameId "\"reply_to/agent\"" to the given name, leaves the \ref agentMessageId "\"reply_to/message\"" unchanged
+        void         SetReplyToMessageName(const std::string& messageName);                              ///< only sets the entry \ref agentMessageId "\"reply_to/message\"" to the given message name, leaves the \ref agentNameId "\"reply_to/agent\"" unchanged
+        std::string  GetReplyToAgentNameOrEmpty() const;                                                 ///< if there is an entry \ref agentNameId "\"reply_to/agent\"", returns it, otherwise returns the empty string
+        std::string  GetReplyToMessageNameOrEmpty() const;                                               ///< if there is an entry \ref agentMessageId "\"reply_to/message\"", returns it, otherwise returns the empty string
+        void         SetReplyToCall(long long callId);                                                   ///< Sets the entry \ref callId "\"reply_to/call\"", which passes the return value of the function directly to the waiting caller instead of sending a reply-to message, see \ref call
+        long long    GetReplyToCallOrZero() const;                                                       ///< if there is an entry \ref callId "\"reply_to/call\"", returns it, otherwise returns 0
+        bool         RequestsUnreplicatedReceiver() const;                                               ///< return true if the table represents message parameters from a sender that requests that the message must be received by a non-replicated instance of the lua script that contains the message function
+        LuaTableBase GetTableToMergeWhenReplyingOrEmpty() const;                                         ///< if there is a table entry \ref tableToMergeWhenReplyingId "\"reply_to/merge\"", return it, otherwise an empty \ref nexuslua::LuaTableBase
 
     protected:
         static constexpr std::string_view replyToTableId{"reply_to"};          ///< name of a cbeam::container::nested_map::sub_tables entry that stores the agent that a message shall reply to
@@ -76,5 +79,6 @@ namespace nexuslua
         static constexpr std::string_view unreplicatedId{"unreplicated"};      ///< name of a data field that stores if the sender requests that the message must be received by a non-replicated instance of the lua script that contains the message function
         static constexpr std::string_view agentNameId{"agent"};                ///< name of an entry in cbeam::serialization::serialized_object::data that stores the name of the agent that a message shall reply to
         static constexpr std::string_view agentMessageId{"message"};           ///< name of an entry in cbeam::serialization::serialized_object::data that stores the name of the message that shall be sent in reply to a message
+        static constexpr std::string_view callId{"call"};                      ///< name of an entry in cbeam::serialization::serialized_object::data that stores the id of a pending call that waits for the reply to a message
     };
 }
\ No newline at end of file
@@ -29,8 +29,10 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 
 #include "nexuslua_export.h"
 
+#include <memory>
 #include <string>
 #include <string_view>
+#include <utility>
 
 namespace nexuslua
 {
@@ -50,8 +52,24 @@ namespace nexuslua
         {
         }
 
+        Message(int agent_n, const std::string& my_name, LuaTable&& my_parameters)
+            : agent_n{agent_n}
+            , name{my_name}
+            , parameters{std::move(my_parameters)}
+        {
+        }
+
+        Message(int agent_n, int message_id, const std::string& my_name, LuaTable&& my_parameters)
+            : agent_n{agent_n}
+            , message_id{message_id}
+            , name{my_name}
+            , parameters{std::move(my_parameters)}
+        {
+        }
+
         Message(int agent_n, const Message& message)
             : agent_n{agent_n}
+            , message_id{message.message_id}
             , name{message.name}
             , parameters{message.parameters}
         {
@@ -65,16 +83,19 @@ namespace nexuslua
         Message()          = default;
         virtual ~Message() = default;
 
-        int         agent_n = -1;
-        std::string name;       ///< name of the message; second parameter of \ref send
-        LuaTable    parameters; ///< parameter table of the message; third parameter of \ref send
+        int         agent_n    = -1;
+        int         message_id = -1; ///< the name of the message interned to a dense ID, or -1 if the message has not been sent via AgentMessage::Send
+        std::string name;            ///< name of the message; second parameter of \ref send
+        LuaTable    parameters;      ///< parameter table of the message; third parameter of \ref send
 
         std::string GetOriginalMessageNameOrEmpty() const;       ///< return the original message name, in case this message is a reply to a message that specified a \ref nexuslua::LuaTable::replyToTableId "reply_to" sub table
         LuaTable    GetOriginalMessageParametersOrEmpty() const; ///< return the original message parameters, in case this message is a reply to a message that specified a \ref nexuslua::LuaTable::replyToTableId "reply_to" sub table
 
         virtual std::shared_ptr<Message> clone() const
         {
-            return std::make_shared<Message>(agent_n, name, parameters);
+            auto message        = std::make_shared<Message>(agent_n, name, parameters);
+            message->message_id = message_id;
+            return message;
         }
 
         static constexpr std::string_view originalMessageTableId{"original_message"}; ///< name of the SubTable that stores the original message, in case this message is a reply to a message that specified a \ref nexuslua::LuaTable::replyToTableId "reply_to" sub table
@@ -0,0 +1,121 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "lua_table.hpp"
+
+#include "nexuslua_export.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace nexuslua
+{
+    /// \brief contiguous array of numbers of a single type that is carried by a LuaTable without an entry per element
+    /// \details A numeric array is a sub table with the entries \ref elementTypeKey (the element type), \ref lengthId "\"length\""
+    /// (the number of elements) and \ref bytesId "\"bytes\"" (the elements as a single string of bytes). It is therefore moved
+    /// along with the message parameters, serialized in one piece when it is passed to a function of a shared library imported
+    /// via \ref import, and converted to a userdata with indexing, `#` and bulk operations when it is passed to Lua (see
+    /// \ref newarray). Supported element types are double, int64_t and uint8_t.
+    /// The key of the element type is a boolean, which Lua tables never pass to C++ (see lua_totable), so a table of a script
+    /// with the same entries is not taken for a numeric array. The string of bytes is padded to at least sizeof(std::string)
+    /// bytes, so that it never fits into the small string buffer inside std::string, which need not be aligned for the elements.
+    /// It is allocated instead, with the alignment of operator new.
+    class NEXUSLUA_EXPORT NumericArray
+    {
+    public:
+        enum class ElementType
+        {
+            Float64 = 0,
+            Int64   = 1,
+            UInt8   = 2
+        };
+
+        template <typename T>
+        static constexpr ElementType ElementTypeOf()
+        {
+            static_assert(std::is_same_v<T, double> || std::is_same_v<T, int64_t> || std::is_same_v<T, uint8_t>, "nexuslua::NumericArray: element type must be double, int64_t or uint8_t");
+
+            if constexpr (std::is_same_v<T, double>)
+            {
+                return ElementType::Float64;
+            }
+            else if constexpr (std::is_same_v<T, int64_t>)
+            {
+                return ElementType::Int64;
+            }
+            else
+            {
+                return ElementType::UInt8;
+            }
+        }
+
+        static LuaTable         Create(ElementType type, std::size_t length);                      ///< returns a numeric array of the given length with all elements set to 0
+        static LuaTable         Create(ElementType type, const void* elements, std::size_t length); ///< returns a numeric array that contains a copy of the given elements
+        static bool             IsNumericArray(const LuaTableBase& table);                         ///< returns true if table has been created by NumericArray::Create
+        static ElementType      GetElementType(const LuaTableBase& table);                         ///< returns the element type of a numeric array; throws std::runtime_error if table is not a numeric array
+        static std::size_t      GetLength(const LuaTableBase& table);                              ///< returns the number of elements of a numeric array; throws std::runtime_error if table is not a numeric array
+        static std::size_t      GetElementSize(ElementType type);                                  ///< returns the number of bytes of an element of the given type
+        static std::string_view GetElementTypeName(ElementType type);                              ///< returns "float64", "int64" or "uint8"
+        static bool             ParseElementTypeName(std::string_view name, ElementType& type);    ///< inverse of GetElementTypeName; returns false for unknown names
+
+        /// returns a numeric array that contains a copy of the given values
+        template <typename T>
+        static LuaTable Create(std::span<const T> values)
+        {
+            return Create(ElementTypeOf<T>(), values.data(), values.size());
+        }
+
+        /// returns the elements of a numeric array, or an empty span if table is not a numeric array with elements of type T
+        template <typename T>
+        static std::span<const T> Get(const LuaTableBase& table)
+        {
+            std::size_t length   = 0;
+            const void* elements = GetElements(table, ElementTypeOf<T>(), length);
+            return elements ? std::span<const T>(static_cast<const T*>(elements), length) : std::span<const T>{};
+        }
+
+        /// like Get, but the elements can be modified in place
+        template <typename T>
+        static std::span<T> Get(LuaTableBase& table)
+        {
+            std::size_t length   = 0;
+            void*       elements = const_cast<void*>(GetElements(table, ElementTypeOf<T>(), length));
+            return elements ? std::span<T>(static_cast<T*>(elements), length) : std::span<T>{};
+        }
+
+        static constexpr bool             elementTypeKey{true}; ///< key of the entry that stores the element type as a string (see GetElementTypeName); a boolean, unlike the keys that Lua passes to C++
+        static constexpr std::string_view lengthId{"length"};   ///< name of the entry that stores the number of elements as an integer
+        static constexpr std::string_view bytesId{"bytes"};     ///< name of the entry that stores the elements as a string of bytes, padded to at least sizeof(std::string) bytes
+
+    private:
+        static const void* GetElements(const LuaTableBase& table, ElementType type, std::size_t& length); ///< returns nullptr if table is not a numeric array with elements of the given type
+    };
+}
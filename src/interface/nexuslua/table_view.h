@@ -0,0 +1,184 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/// \file table_view.h
+/// \brief C interface to read and build Lua tables in functions of shared libraries imported via \ref import
+/// \details A parameter of type `table` is serialized into a copy of the whole table on each call. A parameter of type
+/// `table_view` instead receives a `const nexuslua_table_view*`, which accesses the table where it lives, i. e. on the Lua
+/// stack of the caller, by the functions of its `api`. Likewise, a last parameter of type `table_builder` receives a
+/// `const nexuslua_table_builder*` to fill the table that becomes the result of the function (which must return void).
+/// Numeric arrays (see \ref newarray) are accessed and created as a pointer to their elements, without copying them.
+/// Shared libraries only need this header; the functions are provided by nexuslua via the `api` member.
+///
+/// All pointers (views, strings and elements of arrays) stay valid until the imported function returns, as long as
+/// the function does not replace the entries they refer to. Each sub table or string that is accessed occupies a slot
+/// of the Lua stack until then. The functions must only be called from the thread that called the imported function.
+
+#ifndef NEXUSLUA_TABLE_VIEW_H
+#define NEXUSLUA_TABLE_VIEW_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define NEXUSLUA_TABLE_API_VERSION 1 ///< incremented when functions are added to nexuslua_table_api
+
+    typedef enum nexuslua_value_type
+    {
+        NEXUSLUA_NIL     = 0,
+        NEXUSLUA_INTEGER = 1,
+        NEXUSLUA_NUMBER  = 2,
+        NEXUSLUA_BOOLEAN = 3,
+        NEXUSLUA_STRING  = 4,
+        NEXUSLUA_POINTER = 5, ///< light userdata, or a userdata other than a table or numeric array
+        NEXUSLUA_TABLE   = 6,
+        NEXUSLUA_ARRAY   = 7 ///< numeric array, see \ref newarray
+    } nexuslua_value_type;
+
+    typedef enum nexuslua_element_type ///< matches nexuslua::NumericArray::ElementType
+    {
+        NEXUSLUA_FLOAT64 = 0,
+        NEXUSLUA_INT64   = 1,
+        NEXUSLUA_UINT8   = 2
+    } nexuslua_element_type;
+
+    typedef struct nexuslua_table_api nexuslua_table_api;
+
+    typedef struct nexuslua_table_view
+    {
+        const nexuslua_table_api* api;
+        void*                     state; ///< the lua_State of the caller
+        int                       index; ///< absolute index of the table on the Lua stack
+    } nexuslua_table_view;
+
+    typedef struct nexuslua_table_builder
+    {
+        const nexuslua_table_api* api;
+        void*                     state; ///< the lua_State of the caller
+        int                       index; ///< absolute index of the table on the Lua stack
+    } nexuslua_table_builder;
+
+    typedef struct nexuslua_string
+    {
+        const char* data; ///< zero terminated, but may contain zeros
+        size_t      size;
+    } nexuslua_string;
+
+    typedef struct nexuslua_array
+    {
+        nexuslua_element_type type;
+        void*                 data; ///< the elements; they may be modified in place
+        size_t                length;
+    } nexuslua_array;
+
+    typedef struct nexuslua_value
+    {
+        nexuslua_value_type type;
+
+        union
+        {
+            long long           integer;
+            double              number;
+            int                 boolean;
+            nexuslua_string     string;
+            void*               pointer;
+            nexuslua_table_view table;
+            nexuslua_array      array;
+        } as;
+    } nexuslua_value;
+
+    typedef struct nexuslua_iterator
+    {
+        int state; ///< must be 0 before the first call of nexuslua_table_api::next
+    } nexuslua_iterator;
+
+    struct nexuslua_table_api
+    {
+        int version; ///< NEXUSLUA_TABLE_API_VERSION of the nexuslua library
+
+        /// returns the length of the sequence part of the table, like the Lua operator `#`
+        size_t (*length)(const nexuslua_table_view* view);
+
+        /// sets value to the entry of key and returns 1, or sets value to nil and returns 0 if there is none
+        int (*get)(const nexuslua_table_view* view, const nexuslua_value* key, nexuslua_value* value);
+
+        /// sets key and value to the next entry and returns 1, or returns 0 after the last entry; the order is unspecified
+        int (*next)(const nexuslua_table_view* view, nexuslua_iterator* iterator, nexuslua_value* key, nexuslua_value* value);
+
+        /// sets the entry of key to a copy of value, or removes it if value is nil; a table value is referenced, not copied, so
+        /// it may be a view of a parameter; returns 0 if key is nil, a table or an array
+        int (*set)(const nexuslua_table_builder* builder, const nexuslua_value* key, const nexuslua_value* value);
+
+        /// sets the entry of key to a new, empty table and returns a builder for it; returns a builder with api NULL if key is invalid
+        nexuslua_table_builder (*add_table)(const nexuslua_table_builder* builder, const nexuslua_value* key);
+
+        /// sets the entry of key to a new numeric array with all elements set to 0 and returns its elements to be filled, or NULL
+        /// if key is invalid
+        void* (*add_array)(const nexuslua_table_builder* builder, const nexuslua_value* key, nexuslua_element_type type, size_t length);
+    };
+
+    /// returns a key or value of type string, e. g. to call `view->api->get(view, &key, &value)` with `key = nexuslua_string_value("name")`
+    static inline nexuslua_value nexuslua_string_value(const char* string)
+    {
+        nexuslua_value value;
+        size_t         size = 0;
+
+        while (string[size] != '\0')
+        {
+            ++size;
+        }
+
+        value.type           = NEXUSLUA_STRING;
+        value.as.string.data = string;
+        value.as.string.size = size;
+        return value;
+    }
+
+    /// returns a key or value of type integer, e. g. a 1-based index of the sequence part of a table
+    static inline nexuslua_value nexuslua_integer_value(long long integer)
+    {
+        nexuslua_value value;
+        value.type       = NEXUSLUA_INTEGER;
+        value.as.integer = integer;
+        return value;
+    }
+
+    /// returns a value of type number
+    static inline nexuslua_value nexuslua_number_value(double number)
+    {
+        nexuslua_value value;
+        value.type      = NEXUSLUA_NUMBER;
+        value.as.number = number;
+        return value;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -31,16 +31,14 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 #include "lua.hpp"
 
 #include "agent.hpp"
-#include "configuration.hpp"
 #include "lua_extension.hpp"
-#include "message.hpp"
+#include "numeric_array.hpp"
 #include "platform_specific.hpp"
 #include "utility.hpp"
 
 #include <cbeam/container/stable_reference_buffer.hpp>
 #include <cbeam/convert/string.hpp>
 #include <cbeam/logging/log_manager.hpp>
-#include <cbeam/platform/runtime.hpp>
 
 extern "C"
 {
@@ -55,7 +53,6 @@ extern "C"
 #include <functional>
 #include <map>
 #include <mutex>
-#include <sstream>
 #include <thread>
 
 using namespace nexuslua;
@@ -104,6 +101,7 @@ namespace nexuslua
             RegisterLuaFunction("addagent", LuaExtension::AddAgent);
             RegisterLuaFunction("addmessage", LuaExtension::AddMessage);
             RegisterLuaFunction("addoffset", LuaExtension::AddOffset);
+            RegisterLuaFunction("call", LuaExtension::Call);
             RegisterLuaFunction("cores", LuaExtension::Cores);
             RegisterLuaFunction("currentdir", LuaExtension::CurrentDir);
             RegisterLuaFunction("env", LuaExtension::Env);
@@ -114,9 +112,11 @@ namespace nexuslua
             RegisterLuaFunction("log", LuaExtension::Log);
             RegisterLuaFunction("luastate", LuaExtension::LuaState);
             RegisterLuaFunction("mktemp", LuaExtension::MkTemp);
+            RegisterLuaFunction("newarray", LuaExtension::NewArray);
             RegisterLuaFunction("poke", LuaExtension::Poke);
             RegisterLuaFunction("peek", LuaExtension::Peek);
             RegisterLuaFunction("printtable", LuaExtension::PrintTable);
+            RegisterLuaFunction("queuedepth", LuaExtension::QueueDepth);
             RegisterLuaFunction("readfile", LuaExtension::ReadFile);
             RegisterLuaFunction("isreplicated", LuaExtension::IsReplicated);
             RegisterLuaFunction("scriptdir", LuaExtension::ScriptDir);
@@ -147,25 +147,7 @@ namespace nexuslua
 
             if (!_luaFilePath.empty())
             {
-                const std::filesystem::path directory = _luaFilePath.parent_path();
-                static const int            symbol_inside_runtime_binary{};
-                const std::string           dll_ext = cbeam::platform::get_path_to_runtime_binary(&symbol_inside_runtime_binary).extension().string().substr(1); // "so", "dylib" or "dll"
-
-                for (std::filesystem::path currentPath : std::filesystem::directory_iterator(directory))
-                {
-                    if (currentPath.extension().string() == "." + dll_ext)
-                    {
-                        std::string dll_name = currentPath.stem().string();
-#if defined(__linux__) || defined(__APPLE__)
-                        if (dll_name.find("lib") == 0)
-                        {
-                            dll_name = dll_name.substr(3);
-                        }
-#endif
-
-                        LuaExtension::StoreDirectoryOfDll(dll_name, directory);
-                    }
-                }
+                LuaExtension::StoreDirectoryOfDlls(_luaFilePath.parent_path());
             }
 
             int nArgs    = 0;
@@ -196,7 +178,6 @@ namespace nexuslua
         Agent* const          _agent;
         std::filesystem::path _luaFilePath;
         lua_State*            _luaState{nullptr};
-        mutable std::mutex    _luaStateMutex;
         static lua_State*     _luaStaticState;
         static std::mutex     _luaStaticStateMutex;
     };
@@ -271,8 +252,6 @@ namespace nexuslua
 
     std::string Lua::GetLicensee() const
     {
-        LuaExtension::ResetImportedFunctions();
-
         std::string functionName("IsLicensed");
         lua_getglobal(_impl->_luaState, functionName.c_str());
         std::string result;
@@ -284,110 +263,16 @@ namespace nexuslua
         {
             result = lua_tostring(_impl->_luaState, -1); // second return value
         }
-        LuaExtension::ResetImportedFunctions();
         return result;
     }
 
-    LuaTable Lua::RunPlugin(const Message& incomingMessage) const
+    LuaTable lua_totable(lua_State* L, int idx) // NOLINT(misc-no-recursion)
     {
-        LuaTable    result;
-        const char* functionName = incomingMessage.name.c_str();
-
-        try
-        {
-            const LuaTable& parameters = incomingMessage.parameters;
-
-#if CBEAM_DEBUG_LOGGING
-            {
-                std::stringstream log;
-                log << "Calling " << functionName << " with "
-                    << parameters.data.size() << " parameters and "
-                    << parameters.sub_tables.size() << " parameter tables.";
-
-                if (_impl->_agent->GetConfiguration().GetInternal<bool>(Configuration::logMessages))
-                {
-                    // only log the message content if the generic logging is active, too
-                    log << std::endl
-                        << cbeam::convert::to_string(parameters);
-                }
-
-                CBEAM_LOG_DEBUG(log.str());
-            }
-#endif
-
-            std::lock_guard<std::mutex> lock(_impl->_luaStateMutex);
-            LuaExtension::ResetImportedFunctions();
-
-            lua_getglobal(_impl->_luaState, functionName); // push function to be called
-            lua_pushtable(_impl->_luaState, parameters);   // push arguments
-
-            {
-                // Reference counting of class cbeam::stable_reference_buffer does not count references held by pure Lua because a pointer in this context
-                // is represented by a string (see cbeam::convert::to_string). To ensure that memory allocated via shared libraries loaded with
-                // nexuslua’s `import` (LuaExtension::Import) isn't prematurely deallocated before the end of this block, we make an instance of
-                // stable_reference_buffer::delay_deallocation. At that end of this block, the memory is held by managed cbeam::memory::pointer instances inside
-                // the table `result`. Shared libraries that were loaded via nexuslua’s `import` are automatically unloaded (LuaCallInfo::~LuaCallInfo),
-                // so memory that needs to persist (because it’s accessed by other nexuslua plugins) must be allocated by cbeam::stable_reference_buffer.
-                cbeam::container::stable_reference_buffer::delay_deallocation delayDeallocation;
-
-                if (lua_pcall(_impl->_luaState, 1 /*arguments*/, 1 /*results*/, 0) != 0)
-                {
-                    std::string errorMessage("Error running function '"s + functionName + "': " + lua_tostring(_impl->_luaState, -1));
-                    CBEAM_LOG(errorMessage);
-                    throw std::runtime_error(errorMessage);
-                }
-
-                if (lua_istable(_impl->_luaState, -1))
-                {
-                    result = lua_totable(_impl->_luaState, -1);
-                    lua_pop(_impl->_luaState, 1); // pop returned value
-                }
-            }
-
-            LuaExtension::ResetImportedFunctions();
-
-            auto error = result.data.find("error");
-
-            if (error != result.data.end() && std::get_if<std::string>(&error->second))
-            {
-                CBEAM_LOG(GetPath().string() + ": Error running function '" + functionName + "': " + std::get<std::string>(error->second) + "\n" + cbeam::convert::to_string(incomingMessage.parameters));
-            }
-            else
-            {
-                auto message = result.data.find("message");
-
-                if (message != result.data.end())
-                {
-                    CBEAM_LOG_DEBUG(GetPath().string() + " -> " + functionName + ": success (" + cbeam::container::get_value_or_default<std::string>(message->second) + ")");
-                }
-                else
-                {
-                    CBEAM_LOG_DEBUG(GetPath().string() + " -> " + functionName + ": success");
-                }
-            }
-        }
-        catch (const std::exception& ex)
-        {
-            std::stringstream errorText;
-            errorText << functionName << ": " << ex.what() << std::endl
-                      << cbeam::convert::to_string(incomingMessage.parameters);
-            CBEAM_LOG(errorText.str());
-            result.data["error"] = errorText.str();
-        }
-        catch (...)
+        if (const LuaTableBase* viewed = lua_totableproxy(L, idx))
         {
-            std::stringstream errorText;
-            errorText << functionName << ": fatal internal error" << std::endl
-                      << cbeam::convert::to_string(incomingMessage.parameters);
-            CBEAM_LOG(errorText.str());
-            result.data["error"] = errorText.str();
+            return *viewed;
         }
 
-        return result;
-    }
-
-    LuaTable lua_totable(lua_State* L, int idx) // NOLINT(misc-no-recursion)
-    {
         nexuslua::LuaTable t;
 
         lua_pushnil(L);
@@ -397,11 +282,13 @@ namespace nexuslua
         }
         while (lua_next(L, idx) != 0)
         {
-            std::string key;
+            cbeam::container::xpod::type key;
 
             if (lua_isinteger(L, -2))
             {
-                key = cbeam::convert::to_string(lua_tointeger(L, -2));
+                // Integer keys are kept as integers, so a sequence is carried as such and pushed back into the array part of a
+                // Lua table (see lua_pushtable). lua_next visits the array part in ascending order, so each element is appended.
+                key = (long long)lua_tointeger(L, -2);
             }
             else if (lua_isnumber(L, -2))
             {
@@ -409,27 +296,31 @@ namespace nexuslua
             }
             else if (lua_isboolean(L, -2))
             {
-                key = lua_toboolean(L, -2) ? "1" : "0";
+                key = lua_toboolean(L, -2) ? "1"s : "0"s;
             }
             else if (lua_isstring(L, -2)) // is actually 'lua_isstringornumber', see https://www.lua.org/manual/5.4/manual.html#lua_isstring
             {
-                key = lua_tostring(L, -2); // may be a representation of cbeam::memory::pointer, no need to check this here
+                key = std::string(lua_tostring(L, -2)); // may be a representation of cbeam::memory::pointer, no need to check this here
             }
             else
             {
                 throw std::runtime_error("keys must be strings, integers, numbers or booleans");
             }
 
-            if (lua_istable(L, -1))
+            if (lua_isnumericarray(L, -1))
+            {
+                t.sub_tables.insert_or_assign(t.sub_tables.end(), std::move(key), lua_tonumericarray(L, -1));
+            }
+            else if (lua_istable(L, -1) || lua_totableproxy(L, -1))
             {
                 // recursively scan all sub tables
-                t.sub_tables[key] = lua_totable(L, -1);
+                t.sub_tables.insert_or_assign(t.sub_tables.end(), std::move(key), lua_totable(L, -1));
             }
             else
             {
                 if (lua_isinteger(L, -1))
                 {
-                    t.data[key] = lua_tointeger(L, -1);
+                    t.data.insert_or_assign(t.data.end(), std::move(key), (long long)lua_tointeger(L, -1));
                 }
                 else if (lua_isstring(L, -1)) // is actually 'lua_isstringornumber', see https://www.lua.org/manual/5.4/manual.html#lua_isstring
                 {
@@ -450,21 +341,21 @@ namespace nexuslua
 
                         if (managed_memory_address)
                         {
-                            t.data[key] = cbeam::memory::pointer(managed_memory_address);
+                            t.data.insert_or_assign(t.data.end(), std::move(key), cbeam::memory::pointer(managed_memory_address));
                         }
                         else
                         {
-                            t.data[key] = lua_tonumber(L, -1); // double value (converted from either decimal or hex 0x... syntax)
+                            t.data.insert_or_assign(t.data.end(), std::move(key), (double)lua_tonumber(L, -1)); // double value (converted from either decimal or hex 0x... syntax)
                         }
                     }
                     else
                     {
-                        t.data[key] = lua_tostring(L, -1);
+                        t.data.insert_or_assign(t.data.end(), std::move(key), std::string(lua_tostring(L, -1)));
                     }
                 }
                 else if (lua_isboolean(L, -1))
                 {
-                    t.data[key] = static_cast<bool>(lua_toboolean(L, -1));
+                    t.data.insert_or_assign(t.data.end(), std::move(key), static_cast<bool>(lua_toboolean(L, -1)));
                 }
                 else
                 {
@@ -477,21 +368,59 @@ namespace nexuslua
         return t;
     }
 
-    void lua_pushtable(lua_State* L, const LuaTable& parameters) // NOLINT(misc-no-recursion)
+    void lua_pushtable(lua_State* L, const LuaTableBase& parameters) // NOLINT(misc-no-recursion)
     {
-        lua_newtable(L);
+        // integer keys 1..n form the array part of the new table; they are ordered before all other keys of the maps
+        const auto        total    = (long long)(parameters.data.size() + parameters.sub_tables.size());
+        const long long   first    = 1;
+        const long long   last     = total + 1;
+        const std::size_t sequence = (std::size_t)std::distance(parameters.data.lower_bound(first), parameters.data.lower_bound(last))
+                                   + (std::size_t)std::distance(parameters.sub_tables.lower_bound(first), parameters.sub_tables.lower_bound(last));
+
+        lua_createtable(L, (int)sequence, (int)(total - (long long)sequence));
+
+        // the table is new and has no metatable, so raw access is equivalent to lua_settable
         for (const auto& keyValue : parameters.data)
         {
-            lua_pushvalue(L, keyValue.first);
-            lua_pushvalue(L, keyValue.second);
-            lua_settable(L, -3);
+            if (keyValue.first.index() == cbeam::container::xpod::type_index::integer)
+            {
+                lua_pushvalue(L, keyValue.second);
+                lua_rawseti(L, -2, std::get<cbeam::container::xpod::type_index::integer>(keyValue.first));
+            }
+            else
+            {
+                lua_pushvalue(L, keyValue.first);
+                lua_pushvalue(L, keyValue.second);
+                lua_rawset(L, -3);
+            }
         }
 
-        for (auto& keyValue : parameters.sub_tables)
+        // numeric arrays (see NumericArray) are sub tables in C++, but userdata in Lua
+        const auto pushSubTable = [L](const LuaTableBase& subTable)
+        {
+            if (NumericArray::IsNumericArray(subTable))
+            {
+                lua_pushnumericarray(L, subTable);
+            }
+            else
+            {
+                lua_pushtable(L, subTable);
+            }
+        };
+
+        for (const auto& keyValue : parameters.sub_tables)
         {
-            lua_pushvalue(L, keyValue.first);
-            lua_pushtable(L, keyValue.second);
-            lua_settable(L, -3);
+            if (keyValue.first.index() == cbeam::container::xpod::type_index::integer)
+            {
+                pushSubTable(keyValue.second);
+                lua_rawseti(L, -2, std::get<cbeam::container::xpod::type_index::integer>(keyValue.first));
+            }
+            else
+            {
+                lua_pushvalue(L, keyValue.first);
+                pushSubTable(keyValue.second);
+                lua_rawset(L, -3);
+            }
         }
     }
 
@@ -26,6 +26,8 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
 #include "lua_table.hpp"
+#include "numeric_array.hpp"
+#include "table_view.h"
 
 #include <filesystem>
 #include <memory>
@@ -35,7 +37,6 @@ struct lua_State;
 
 namespace nexuslua
 {
-    struct Message;
     class Agent;
 
     class Lua
@@ -51,12 +52,31 @@ namespace nexuslua
         std::filesystem::path GetPath() const;
         lua_State*            GetState() const;
         std::string           GetLicensee() const;
-        LuaTable              RunPlugin(const Message& incomingMessage) const;
 
         static std::string GetVersion();
     };
 
     void     lua_pushvalue(lua_State* L, const cbeam::container::xpod::type& value); ///< push a \ref value onto the Lua stack; works analogous to [existing lua_push<xy> functions](https://www.lua.org/manual/5.4/manual.html#lua_pushboolean)
-    void     lua_pushtable(lua_State* L, const LuaTable& parameters);                ///< push a \ref table onto the Lua stack; works analogous to [existing lua_push<xy> functions](https://www.lua.org/manual/5.4/manual.html#lua_pushboolean)
+    void     lua_pushtable(lua_State* L, const LuaTableBase& parameters);            ///< push a \ref table onto the Lua stack; works analogous to [existing lua_push<xy> functions](https://www.lua.org/manual/5.4/manual.html#lua_pushboolean)
     LuaTable lua_totable(lua_State* L, int idx);                                     ///< get a \ref table from the Lua stack; works analogous to [existing lua_to<xy> functions](https://www.lua.org/manual/5.4/manual.html#lua_toboolean)
+    void     lua_pushnumericarray(lua_State* L, const LuaTableBase& array);          ///< push a NumericArray onto the Lua stack as userdata with element access, `#`, and the methods of \ref newarray
+    bool     lua_isnumericarray(lua_State* L, int idx);                              ///< returns true if the value at the given index has been pushed by lua_pushnumericarray or created by \ref newarray
+    LuaTable lua_tonumericarray(lua_State* L, int idx);                              ///< get a copy of the numeric array at the given index as NumericArray
+
+    void* lua_newnumericarray(lua_State* L, NumericArray::ElementType type, std::size_t length);                      ///< push a numeric array with all elements set to 0 and return its elements, e. g. to fill them
+    void* lua_tonumericarraydata(lua_State* L, int idx, NumericArray::ElementType& type, std::size_t& length); ///< return the elements of the numeric array at the given index without copying them, or nullptr if it is none
+
+    /// return a view of the table or table proxy at the given index for a function of a shared library, see table_view.h; throws std::runtime_error if the value is neither
+    nexuslua_table_view lua_totableview(lua_State* L, int idx);
+
+    nexuslua_table_builder lua_newtablebuilder(lua_State* L); ///< push a new table and return a builder for it for a function of a shared library, see table_view.h
+
+    /// push a read-only view of a \ref table onto the Lua stack, which converts entries to Lua values only when they are accessed
+    /// \details Unlike lua_pushtable, the cost does not depend on the size of the table, so a handler that reads only some of
+    /// its parameters (see `lazy` in \ref addmessage) saves converting the rest. The view is a userdata that supports indexing,
+    /// `#`, `pairs` and `ipairs`, and is converted by lua_totable like a Lua table. Sub tables are viewed in the same way when
+    /// they are accessed. The view shares ownership of table, e. g. by the aliasing constructor of std::shared_ptr.
+    void lua_pushtableproxy(lua_State* L, std::shared_ptr<const LuaTableBase> table);
+
+    const LuaTableBase* lua_totableproxy(lua_State* L, int idx); ///< returns the table viewed by the value at the given index if it has been pushed by lua_pushtableproxy, otherwise nullptr
 }
\ No newline at end of file
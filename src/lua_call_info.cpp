@@ -28,17 +28,38 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 
 #include <cbeam/logging/log_manager.hpp>
 
+#include <mutex>
+
 using namespace nexuslua;
 
 LuaCallInfo::LuaCallInfo(const std::filesystem::path& dllPath, const std::string& functionName, const std::string& signature)
     : dllPath(dllPath)
     , functionName(functionName)
     , signature(signature)
-    , dll(std::make_shared<boost::dll::shared_library>(dllPath.string(), boost::dll::load_mode::append_decorations | boost::dll::load_mode::load_with_altered_search_path))
+    , dll(OpenSharedLibrary(dllPath))
 {
     CBEAM_LOG_DEBUG("LuaCallInfo(" + functionName + "): Incrementing reference counter of " + dllPath.string());
 }
 
+std::shared_ptr<boost::dll::shared_library> LuaCallInfo::OpenSharedLibrary(const std::filesystem::path& dllPath)
+{
+    // weak references, so that a library is unloaded as soon as no Lua state imports functions from it anymore
+    static std::mutex                                                         mtx;
+    static std::map<std::string, std::weak_ptr<boost::dll::shared_library>> libraries;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    auto&                       library = libraries[dllPath.string()];
+
+    if (auto loaded = library.lock())
+    {
+        return loaded;
+    }
+
+    auto loaded = std::make_shared<boost::dll::shared_library>(dllPath.string(), boost::dll::load_mode::append_decorations | boost::dll::load_mode::load_with_altered_search_path);
+    library     = loaded;
+    return loaded;
+}
+
 LuaCallInfo::~LuaCallInfo()
 {
     if (dll.use_count() == 1)
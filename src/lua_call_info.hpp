@@ -23,6 +23,8 @@ You should have received a copy of the GNU Affero General Public License
 along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 */
 
+#pragma once
+
 #include <boost/dll.hpp>
 
 #include <filesystem>
@@ -31,8 +33,15 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 #include <memory>
 #include <string>
 
+struct lua_State;
+
 namespace nexuslua
 {
+    class GenericDllCall;
+
+    using DllFunction         = void (*)();                                   ///< a function of a shared library; converted to its actual type by a CallDllFunctionType
+    using CallDllFunctionType = void (*)(lua_State* L, DllFunction function); ///< calls function with the arguments on the Lua stack and pushes its result, if any
+
     struct LuaCallInfo
     {
         enum class ReturnType
@@ -51,10 +60,16 @@ namespace nexuslua
         LuaCallInfo(const std::filesystem::path& dllPath, const std::string& functionName, const std::string& signature);
         virtual ~LuaCallInfo();
 
+        /// returns the loaded library at dllPath, which is shared by all LuaCallInfo instances of the process that refer to it
+        static std::shared_ptr<boost::dll::shared_library> OpenSharedLibrary(const std::filesystem::path& dllPath);
+
         std::filesystem::path                       dllPath;
         std::string                                 functionName;
         std::string                                 signature;
         std::shared_ptr<boost::dll::shared_library> dll;
         ReturnType                                  returnType{ReturnType::INVALID};
+        DllFunction                                 function{nullptr}; ///< resolved once by `import`
+        CallDllFunctionType                         call{nullptr};     ///< generated for signature, see lua_code_generator_find_signature.lua
+        std::shared_ptr<const GenericDllCall>       genericCall;       ///< used instead of call if signature has no generated function
     };
 }
@@ -26,19 +26,21 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 --]]
 
 if #arg<2 then
-    print("Usage: lua_code_generator.lua ${CMAKE_CURRENT_BINARY_DIR}/LuaFindSignature_Map.cpp ${CMAKE_CURRENT_BINARY_DIR}/LuaFindSignature_IfChain.cpp")
+    print("Usage: lua_code_generator_find_signature.lua ${CMAKE_CURRENT_BINARY_DIR}/lua_find_signature_table.cpp ${CMAKE_CURRENT_BINARY_DIR}/lua_find_signature_thunks.cpp")
     os.exit(1)
 end
 
 local max_arguments = 3
-local n_use_map     = 1
 local cpp_argument_types = {
     {max_sequence=max_arguments, types={"table"}}, -- see cbeam::serialization::serialized_object
+    {max_sequence=1, types={"table_view"}}, -- see nexuslua_table_view in table_view.h
     {max_sequence=max_arguments, types={"void*"}},
     {max_sequence=max_arguments, types={"long long"}}, -- needs to match lua_Integer, see lua.h
     {max_sequence=max_arguments, types={"double"}},
     {max_sequence=max_arguments, types={"bool"}},
-    {max_sequence=max_arguments, types={"const char*"}}}
+    {max_sequence=max_arguments, types={"const char*"}},
+    {max_sequence=1, types={"table_builder"}}} -- see nexuslua_table_builder in table_view.h; only as last parameter of functions returning void
+local argument_only_types = {table_view=true, table_builder=true}
 
 local concat_tables = function(table1, table2)
     local result = table.move(table1, 1, #table1, 1, {})
@@ -46,34 +48,46 @@ local concat_tables = function(table1, table2)
     return result
 end
 
-local cpp_argument_type_list = concat_tables(cpp_argument_types[1].types, concat_tables(cpp_argument_types[2].types, concat_tables(cpp_argument_types[3].types, concat_tables(cpp_argument_types[4].types, concat_tables(cpp_argument_types[5].types, cpp_argument_types[6].types)))))
-local cpp_return_types = table.move(cpp_argument_type_list, 1, #cpp_argument_type_list, 2, {"void"})
+local cpp_return_types = {"void"}
+for _,group in ipairs(cpp_argument_types) do
+    for _,type in ipairs(group.types) do
+        if not argument_only_types[type] then table.insert(cpp_return_types, type) end
+    end
+end
+
+local tableCpp  = io.open(arg[1], "w")
+local thunksCpp = io.open(arg[2], "w")
+
+local signatures = {} -- in the order of their dense IDs
+local known      = {}
 
-local mapCpp     = io.open(arg[1], "w")
-local ifChainCpp = io.open(arg[2], "w")
+-- e. g. "long_long_from_double_bool" for "long long(double,bool)"
+local identifier = function(return_type, arguments)
+    local sanitize = function(type) return (type:gsub("%*","Ptr"):gsub(" ","_")) end
+    local names = {}
+    for i,argument in ipairs(arguments) do names[i] = sanitize(argument) end
+    return sanitize(return_type).."_from_"..(#names > 0 and table.concat(names, "_") or "void")
+end
 
 local create_code = function(return_type, arguments)
     local strSignature = return_type.."("..table.concat(arguments, ",")..")"
+    local strPointer   = return_type.."(*)("..table.concat(arguments, ",")..")"
 
-    local indentation
-    if #arguments <= n_use_map then
-        mapCpp    :write('  callDllFunction["',strSignature,'"]')
-        indentation = (n_use_map+1) * 12
-    else
-        ifChainCpp:write('  if (signature=="',strSignature,'")')
-        indentation = (max_arguments+1) * 12
+    if arguments[#arguments]=="table_builder" and return_type~="void" then
+        return -- the table built by the function is its result
     end
 
-    local spaces = ''
-    for i=1,indentation-#strSignature do spaces=spaces.." " end
-
-    if #arguments <= n_use_map then
-        mapCpp:write(spaces,' = [](lua_State* L, std::shared_ptr<boost::dll::shared_library> dll, std::string functionName)')
-    else
-        ifChainCpp:write(spaces)
+    if known[strSignature] then
+        return
     end
+    known[strSignature] = true
 
-    local cmd = " { "
+    local name = identifier(return_type, arguments)
+    table.insert(signatures, {signature=strSignature, name=name})
+
+    local cmd      = ""
+    local prologue = "" -- declarations of the views and builders whose addresses are passed
+    local epilogue = ""
 
     if return_type ~= "void" then
         cmd = cmd .. "lua_push"
@@ -91,8 +105,8 @@ local create_code = function(return_type, arguments)
         cmd=cmd.."LuaTable(" -- deserialize the type `cbeam::table` returned by the shared library
     end
 
-    cmd = cmd .. "boost::dll::import_symbol<" .. strSignature .. ">" .. spaces .. "(*dll, functionName)("
-    
+    cmd = cmd .. "reinterpret_cast<" .. strPointer .. ">(function)("
+
     local argument_list=""
     for i,argument in ipairs(arguments) do
         if argument_list~="" then argument_list=argument_list.."," end
@@ -101,27 +115,28 @@ local create_code = function(return_type, arguments)
         elseif argument=="double"      then argument_list=argument_list.."lua_tonumber(L,"..i..")"
         elseif argument=="void*"       then argument_list=argument_list.."lua_touserdata(L,"..i..")"
         elseif argument=="bool"        then argument_list=argument_list.."lua_toboolean(L,"..i..")"
+        elseif argument=="table_view"  then
+            prologue=prologue.."const nexuslua_table_view view"..i.."=lua_totableview(L,"..i.."); " -- access the table on the Lua stack without copying it
+            argument_list=argument_list.."&view"..i
+        elseif argument=="table_builder" then
+            prologue=prologue.."const nexuslua_table_builder builder=lua_newtablebuilder(L); "
+            argument_list=argument_list.."&builder"
+            epilogue=" lua_settop(L,builder.index);" -- the built table is the result, above it may be sub tables accessed via views
         elseif argument=="table"       then argument_list=argument_list.."cbeam::serialization::serialize<cbeam::container::nested_map<cbeam::container::xpod::type, cbeam::container::xpod::type>>((cbeam::container::nested_map<cbeam::container::xpod::type, cbeam::container::xpod::type>)lua_totable(L,"..i..")).safe_get()" -- serialize the type `nexuslua::LuaTable` to pass it to the shared library function
         end
     end
-        
+
     cmd=cmd..argument_list..")"
-    
+
     if return_type=="table" then
         cmd=cmd..")" -- closing bracket of the extra LuaTable constructor call required to cbeam::serialization::deserialize
     end
-    
+
     if return_type~="void" then
         cmd=cmd..")"
     end
-    
-    if #arguments <= n_use_map then
-        mapCpp:write(cmd)
-        mapCpp:write("; };\n")
-    else
-        ifChainCpp:write(cmd)
-        ifChainCpp:write("; return; }\n")
-    end
+
+    thunksCpp:write('void CallDllFunction_',name,'([[maybe_unused]] lua_State* L, DllFunction function) { ',prologue,cmd,';',epilogue,' }\n')
 end
 
 local sumOfArgs = 0
@@ -152,6 +167,63 @@ script_path = function()
    return str:match("(.*/)")
 end
 
+-- FNV-1a, must match Hash in the generated table
+local fnv1a = function(seed, str)
+    local h = 2166136261 ~ seed
+    for i = 1, #str do
+        h = ((h ~ str:byte(i)) * 16777619) & 0xffffffff
+    end
+    return h
+end
+
+local next_power_of_two = function(n)
+    local result = 1
+    while result < n do result = result * 2 end
+    return result
+end
+
+-- Perfect hash by "hash and displace": the signatures are distributed to buckets by fnv1a(0, signature). For each bucket,
+-- starting with the largest, a seed is searched that maps all of its signatures to free slots by fnv1a(seed, signature).
+local create_perfect_hash = function()
+    local n_buckets = next_power_of_two(math.max(1, #signatures // 4))
+    local n_slots   = next_power_of_two(#signatures + #signatures // 2)
+    local buckets   = {}
+    for b = 1, n_buckets do buckets[b] = {index=b-1} end
+    for id,entry in ipairs(signatures) do
+        local bucket = buckets[(fnv1a(0, entry.signature) & (n_buckets-1)) + 1]
+        table.insert(bucket, id)
+    end
+    table.sort(buckets, function(a, b) if #a ~= #b then return #a > #b end return a.index < b.index end)
+
+    local seeds = {}
+    local slots = {}
+    for b = 1, n_buckets do seeds[b] = 0 end
+    for s = 1, n_slots do slots[s] = -1 end
+
+    for _,bucket in ipairs(buckets) do
+        if #bucket > 0 then
+            local seed = 0
+            while true do
+                seed = seed + 1
+                local taken = {}
+                local fits  = true
+                for _,id in ipairs(bucket) do
+                    local slot = (fnv1a(seed, signatures[id].signature) & (n_slots-1)) + 1
+                    if slots[slot] ~= -1 or taken[slot] then fits = false break end
+                    taken[slot] = id
+                end
+                if fits then
+                    for slot,id in pairs(taken) do slots[slot] = id-1 end
+                    seeds[bucket.index+1] = seed
+                    break
+                end
+            end
+        end
+    end
+
+    return seeds, slots
+end
+
 local header =     '// Generated by '..debug.getinfo(1,'S').source..'\n'
 header = header .. '// Time of generation: '..os.date()..'\n'
 header = header .. '// Script path: '..script_path()..'\n'
@@ -171,9 +243,14 @@ header = header .. [[
 
 #include "lua.hpp"
 #include "lua_table.hpp"
+#include "table_view.h"
 
 #include <boost/dll.hpp> // must be included prior Lua headers because they break boost header compilation
 
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
 #define luac_c
 #define LUA_CORE
 
@@ -197,28 +274,109 @@ namespace nexuslua
     /// by cbeam::Memory and contains a serialized representation of a
     /// LuaTable instance, which can be deserialized back into a LuaTable object.
     using table = ::cbeam::serialization::serialized_object;
+
+    /// `table_view` and `table_builder` give a function of a shared library access to Lua tables without serializing them,
+    /// see table_view.h. A `table_builder` parameter must be the last one, and the built table is the result of the function.
+    using table_view    = const nexuslua_table_view*;
+    using table_builder = const nexuslua_table_builder*;
     using LuaTable = ::nexuslua::LuaTable;
 
 ]]
 
-mapCpp:write(header)
-ifChainCpp:write(header)
-
-mapCpp:write('void InitCallDllFunction()\n')
-mapCpp:write('{\n')
+tableCpp:write(header)
+thunksCpp:write(header)
 
 for i,return_type in ipairs(cpp_return_types) do
-    str_return_type = return_type:gsub("*","Ptr"):gsub(' ','_'):gsub("::","_")
-    ifChainCpp:write('void CallDllFunction_',str_return_type,'(lua_State* L, std::string signature, std::shared_ptr<boost::dll::shared_library> dll, std::string functionName)\n')
-    ifChainCpp:write('{\n')
     traverse(return_type, {}, {}, 1, true)
-    ifChainCpp:write('  throw std::runtime_error("CallDllFunction: function "+functionName+" was called with an unsupported signature "+signature+". If this signature would be useful for you, please file an issue on https://github.com/acrion/nexuslua/issues to support it. Currently parameters must be in the following order: table (max ' .. cpp_argument_types[1].max_sequence .. '), void* (max ' .. cpp_argument_types[2].max_sequence .. '), long long (max ' .. cpp_argument_types[3].max_sequence .. '), double (max ' .. cpp_argument_types[4].max_sequence .. '), bool (max ' .. cpp_argument_types[5].max_sequence .. '), const char* (max ' .. cpp_argument_types[6].max_sequence .. '). Note that type int is not supported, please use long long instead (matching type lua_Integer)");\n')
-    ifChainCpp:write('}\n')
 end
 
-mapCpp:write('}\n')
+local seeds, slots = create_perfect_hash()
+
+local write_list = function(file, values, per_line)
+    for i,value in ipairs(values) do
+        if (i-1) % per_line == 0 then file:write("    ") end
+        file:write(tostring(value), ",")
+        file:write(i % per_line == 0 and "\n" or " ")
+    end
+    if #values % per_line ~= 0 then file:write("\n") end
+end
+
+tableCpp:write('// defined in lua_find_signature_thunks.cpp\n')
+for _,entry in ipairs(signatures) do
+    tableCpp:write('void CallDllFunction_',entry.name,'(lua_State* L, DllFunction function);\n')
+end
+
+tableCpp:write('\nnamespace\n{\n')
+tableCpp:write('enum class DllSignature : short\n{\n')
+for _,entry in ipairs(signatures) do
+    tableCpp:write('    ',entry.name,',\n')
+end
+tableCpp:write('    count\n};\n\n')
+
+tableCpp:write('constexpr std::string_view signatures[(std::size_t)DllSignature::count] = {\n')
+for _,entry in ipairs(signatures) do
+    tableCpp:write('    "',entry.signature,'",\n')
+end
+tableCpp:write('};\n\n')
+
+tableCpp:write('constexpr CallDllFunctionType callDllFunctions[(std::size_t)DllSignature::count] = {\n')
+for _,entry in ipairs(signatures) do
+    tableCpp:write('    CallDllFunction_',entry.name,',\n')
+end
+tableCpp:write('};\n\n')
+
+tableCpp:write('constexpr std::uint32_t seeds[', #seeds, '] = {\n')
+write_list(tableCpp, seeds, 16)
+tableCpp:write('};\n\n')
+
+tableCpp:write('constexpr short slots[', #slots, '] = {\n')
+write_list(tableCpp, slots, 16)
+tableCpp:write('};\n\n')
+
+tableCpp:write([[
+constexpr std::uint32_t Hash(const std::uint32_t seed, const std::string_view str)
+{
+    std::uint32_t h = 2166136261u ^ seed;
+    for (const char c : str)
+    {
+        h = (h ^ (unsigned char)c) * 16777619u;
+    }
+    return h;
+}
+
+constexpr int Find(const std::string_view signature)
+{
+    const std::uint32_t seed = seeds[Hash(0, signature) & (std::size(seeds) - 1)];
+    const short         id   = slots[Hash(seed, signature) & (std::size(slots) - 1)];
+    return id >= 0 && signatures[id] == signature ? id : -1;
+}
+
+constexpr bool FindsAllSignatures()
+{
+    for (int id = 0; id < (int)DllSignature::count; ++id)
+    {
+        if (Find(signatures[id]) != id)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(FindsAllSignatures(), "the perfect hash table generated by lua_code_generator_find_signature.lua is inconsistent");
+}
+
+CallDllFunctionType FindCallDllFunction(const std::string_view signature)
+{
+    const int id = Find(signature);
+    return id >= 0 ? callDllFunctions[id] : nullptr;
+}
+]])
+
+print("lua_code_generator_find_signature.lua: "..#signatures.." signatures, "..#seeds.." buckets, "..#slots.." slots")
+
 local namespaceClosingBracket = ('} // namespace nexuslua\n')
-mapCpp:write(namespaceClosingBracket)
-ifChainCpp:write(namespaceClosingBracket)
-mapCpp:close()
-ifChainCpp:close()
+tableCpp:write(namespaceClosingBracket)
+thunksCpp:write(namespaceClosingBracket)
+tableCpp:close()
+thunksCpp:close()
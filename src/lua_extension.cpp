@@ -29,6 +29,7 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 #include "agent_lua.hpp"
 #include "agents.hpp"
 #include "configuration.hpp"
+#include "generic_dll_call.hpp"
 #include "lua.hpp"
 #include "lua_call_info.hpp" // must be included prior Lua headers because they break boost header compilation
 #include "utility.hpp"
@@ -45,6 +46,7 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 
 #include <cbeam/container/thread_safe_map.hpp>
 #include <cbeam/platform/compiler_compatibility.hpp>
+#include <cbeam/platform/runtime.hpp>
 #include <cbeam/platform/system_folders.hpp>
 #include <cbeam/random/generators.hpp>
 
@@ -56,14 +58,18 @@ CBEAM_SUPPRESS_WARNINGS_POP()
 
 #include <chrono>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <limits>
+#include <map>
 #include <mutex>
+#include <new>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <type_traits>
 
 extern "C"
 {
@@ -74,11 +80,6 @@ extern "C"
 
 using namespace std::literals;
 
-namespace nexuslua
-{
-    std::map<std::string, CallDllFunctionType> callDllFunction;
-}
-
 namespace nexuslua::LuaExtension
 {
     std::string nativeLuaFunctionsChunk;
@@ -136,11 +137,9 @@ namespace nexuslua::LuaExtension
     {
         Initializer()
         {
-            InitCallDllFunction();
-
             nativeLuaFunctionsChunk = GenerateBinaryChunk(nativeLuaFunctions); // prepare to save time when actual lua states are created
         }
-    } initializer; // to fill callDllFunction as soon as this shared lib is loaded
+    } initializer;
 
     std::map<std::string, std::set<std::filesystem::path>> _directories_of_DLL;
     std::mutex                                             _directories_of_DLL_mutex;
@@ -152,64 +151,101 @@ namespace nexuslua::LuaExtension
     };
     cbeam::container::thread_safe_map<lua_State*, DataOfLuaState>       _data_of_luaState;
     cbeam::container::thread_safe_map<const Agent*, nexuslua::LuaTable> _table_of_agent;
+    const char                                                          _callMarker{0}; ///< its address is yielded by `call`, see YieldedByCall
 
-    // There may be equally named DLL functions in different Lua instances. We differ
-    // between Lua instances via their thread id, so use a different map per key.
-    std::map<std::thread::id, std::map<std::string, LuaCallInfo>> _importedFunction;
-    std::mutex                                                    _importedFunction_mutex;
-
-    void ResetImportedFunctions()
+    /// the functions registered by `import` by an agent; kept in the registry of its Lua state, so that they live as long as the agent
+    struct ImportedFunction
     {
-        std::lock_guard<std::mutex> lock(_importedFunction_mutex);
-        const auto&                 it = _importedFunction.find(std::this_thread::get_id());
-        if (it != _importedFunction.end())
-        {
-            it->second.clear();
-        }
-    }
+        std::string dllName;   ///< as passed to `import`
+        std::string signature; ///< as passed to `import`
+        LuaCallInfo callInfo;
+    };
 
-    void StoreImportedFunction(const LuaCallInfo& s)
+    using ImportedFunctions = std::map<std::string, ImportedFunction>;
+
+    constexpr const char* importedFunctionsKey = "nexuslua.imported_functions";
+
+    int CollectImportedFunctions(lua_State* L)
     {
-        // All imported functions call the same function 'CallDllFunction'.
-        // We store the correct function name in map importedFunction.
-        // Later in CallDllFunction, when it was called via Lua, we look up the function name in importedFunction so we know meta info like DLL name.
-        std::lock_guard<std::mutex> lock(_importedFunction_mutex);
-        _importedFunction[std::this_thread::get_id()][s.functionName] = s;
+        static_cast<ImportedFunctions*>(lua_touserdata(L, 1))->~ImportedFunctions();
+        return 0;
     }
 
-    bool FunctionHasBeenImported(LuaCallInfo& s)
+    /// pushes the table with the global variables of the Lua function that called the C function running in L
+    /// \details This is the _ENV of the innermost calling Lua function that uses global variables. For an agent of a
+    /// CoroutineHost, it is the table with the global variables of the agent, not the global table of the shared Lua state.
+    void PushGlobals(lua_State* L)
     {
-        std::lock_guard<std::mutex> lock(_importedFunction_mutex);
-        const auto&                 it = _importedFunction.find(std::this_thread::get_id());
-        if (it != _importedFunction.end())
+        lua_Debug ar;
+
+        for (int level = 1; lua_getstack(L, level, &ar); ++level)
         {
-            const auto& it2 = it->second.find(s.functionName);
+            lua_getinfo(L, "f", &ar);
 
-            if (it2 != it->second.end())
+            for (int upvalue = 1; const char* name = lua_getupvalue(L, -1, upvalue); ++upvalue)
             {
-                return true;
+                if (std::strcmp(name, "_ENV") == 0 && lua_istable(L, -1))
+                {
+                    lua_remove(L, -2);
+                    return;
+                }
+                lua_pop(L, 1);
             }
+
+            lua_pop(L, 1);
         }
 
-        return false;
+        lua_pushglobaltable(L);
+    }
+
+    /// pops a value and assigns it to the global variable name of the agent that runs in L
+    void SetGlobal(lua_State* L, const char* name)
+    {
+        PushGlobals(L);
+        lua_insert(L, -2);
+        lua_setfield(L, -2, name);
+        lua_pop(L, 1);
     }
 
-    LuaCallInfo GetImportedFunction(const std::string& functionName)
+    /// pushes the userdata that owns the functions imported by the agent that runs in L, and returns them; creates it on first use
+    /// \details The agents of a CoroutineHost share its Lua state, so the functions are kept per table of global variables, in a
+    /// registry table with weak keys. They are released together with the globals of the agent, or when the state is closed.
+    ImportedFunctions& PushImportedFunctions(lua_State* L)
     {
-        std::lock_guard<std::mutex> lock(_importedFunction_mutex);
-        const auto&                 it = _importedFunction.find(std::this_thread::get_id());
-        if (it != _importedFunction.end())
+        if (lua_getfield(L, LUA_REGISTRYINDEX, importedFunctionsKey) != LUA_TTABLE)
         {
-            const auto& it2 = it->second.find(functionName);
+            lua_pop(L, 1);
+            lua_createtable(L, 0, 1);
+            lua_createtable(L, 0, 1);
+            lua_pushliteral(L, "k");
+            lua_setfield(L, -2, "__mode");
+            lua_setmetatable(L, -2);
+            lua_pushvalue(L, -1);
+            lua_setfield(L, LUA_REGISTRYINDEX, importedFunctionsKey);
+        }
 
-            if (it2 != it->second.end())
-            {
-                return it2->second;
-            }
+        ImportedFunctions* functions = nullptr;
+
+        PushGlobals(L);
+        if (lua_rawget(L, -2) == LUA_TUSERDATA)
+        {
+            functions = static_cast<ImportedFunctions*>(lua_touserdata(L, -1));
+        }
+        else
+        {
+            lua_pop(L, 1);
+            functions = new (lua_newuserdatauv(L, sizeof(ImportedFunctions), 0)) ImportedFunctions();
+            lua_createtable(L, 0, 1);
+            lua_pushcfunction(L, CollectImportedFunctions); // unloads the shared libraries, see LuaCallInfo::OpenSharedLibrary
+            lua_setfield(L, -2, "__gc");
+            lua_setmetatable(L, -2);
+            PushGlobals(L);
+            lua_pushvalue(L, -2);
+            lua_rawset(L, -4);
         }
 
-        // this should never occur even in buggy scripts, because CallDllFunction is only called if the function has been registered via Import
-        throw std::runtime_error("CallDllFunction: function '" + functionName + "' was called without prior call to Import(<pathToSharedLib>, " + functionName + ", <returnType>(<parameterList>)");
+        lua_remove(L, -2);
+        return *functions;
     }
 
     void StoreDirectoryOfDll(const std::string& dll_name, const std::filesystem::path& directory)
@@ -219,6 +255,28 @@ namespace nexuslua::LuaExtension
         _directories_of_DLL[dll_name].insert(directory);
     }
 
+    void StoreDirectoryOfDlls(const std::filesystem::path& directory)
+    {
+        static const int  symbol_inside_runtime_binary{};
+        const std::string dll_ext = cbeam::platform::get_path_to_runtime_binary(&symbol_inside_runtime_binary).extension().string().substr(1); // "so", "dylib" or "dll"
+
+        for (std::filesystem::path currentPath : std::filesystem::directory_iterator(directory))
+        {
+            if (currentPath.extension().string() == "." + dll_ext)
+            {
+                std::string dll_name = currentPath.stem().string();
+#if defined(__linux__) || defined(__APPLE__)
+                if (dll_name.find("lib") == 0)
+                {
+                    dll_name = dll_name.substr(3);
+                }
+#endif
+
+                StoreDirectoryOfDll(dll_name, directory);
+            }
+        }
+    }
+
     void StoreAgentOfLuaState(lua_State* L, Agent* agent, const std::string& luaPath, const bool isReplicated)
     {
         _data_of_luaState[L] = {agent, luaPath, isReplicated};
@@ -254,16 +312,29 @@ namespace nexuslua::LuaExtension
         _table_of_agent.clear();
     }
 
-    void PushRegisteredTables(lua_State* L)
+    void PushRegisteredTables(lua_State* L, int tableIndex)
     {
         Agent* agent = _data_of_luaState.at(L, "internal error in LuaExtension::PushRegisteredTables: no agent is known for this lua state").agent;
 
         auto lock_guard = _table_of_agent.get_lock_guard();
 
+        if (tableIndex != 0)
+        {
+            tableIndex = lua_absindex(L, tableIndex);
+        }
+
         for (const auto& subTable : _table_of_agent[agent].sub_tables)
         {
             lua_pushtable(L, subTable.second);
-            lua_setglobal(L, cbeam::convert::to_string(subTable.first).c_str());
+
+            if (tableIndex == 0)
+            {
+                lua_setglobal(L, cbeam::convert::to_string(subTable.first).c_str());
+            }
+            else
+            {
+                lua_setfield(L, tableIndex, cbeam::convert::to_string(subTable.first).c_str());
+            }
         }
     }
 
@@ -335,76 +406,59 @@ namespace nexuslua::LuaExtension
         return modDllName;
     }
 
-    int CallDllFunction(lua_State* L)
+    /// the upvalue of the closures pushed by `import`, so that a call needs neither the name of the function nor a lock
+    struct BoundDllFunction
     {
-        CBEAM_LOG_DEBUG("CallDllFunction: Current lua script called a function from a DLL that was previously registered.");
-        lua_Debug ar;
-
-        if (!lua_getstack(L, 0, &ar))
-        {
-            throw std::runtime_error("CallDllFunction: error while getting stack info");
-        }
-
-        if (!lua_getinfo(L, "n", &ar))
-        {
-            throw std::runtime_error("CallDllFunction: error while getting info about name of function that is to be called");
-        }
-        std::string functionName = ar.name;
-
-        LuaCallInfo s = GetImportedFunction(functionName);
+        DllFunction         function;
+        CallDllFunctionType call;
+        int                 results; ///< 0 for functions returning void, otherwise 1
+    };
 
-        //    the following check does not work, because ar.nparams is always 0 independent from the number of params in the script
-        //    if (!lua_getinfo(L, "u", &ar))
-        //    {
-        //      throw std::runtime_error("CallDllFunction: error while getting info about name of function that is to be called");
-        //    }
+    int CallDllFunction(lua_State* L)
+    {
+        const auto* bound = static_cast<const BoundDllFunction*>(lua_touserdata(L, lua_upvalueindex(1)));
+        bound->call(L, bound->function);
+        return bound->results;
+    }
 
-        //    if (ar.nparams != s.paramType.size())
-        //    {
-        //      throw std::runtime_error("CallDllFunction: function '"+functionName+"' has been imported with " + std::to_string(s.paramType.size()) + " parameters, but was called with " + std::to_string(ar.nparams) + " parameters");
-        //    }
+    /// like BoundDllFunction, for signatures without generated function; GenericDllCall is trivially copyable, so Lua may free it without __gc
+    struct BoundGenericDllFunction
+    {
+        DllFunction    function;
+        GenericDllCall call;
+        int            results;
+    };
 
-        const int nReturnValues = s.returnType == LuaCallInfo::ReturnType::VOID_ ? 0 : 1;
+    int CallDllFunctionGeneric(lua_State* L)
+    {
+        const auto* bound = static_cast<const BoundGenericDllFunction*>(lua_touserdata(L, lua_upvalueindex(1)));
+        bound->call(L, bound->function);
+        return bound->results;
+    }
 
-        auto callDllFunctionEntry = callDllFunction.find(s.signature);
+    /// pushes a function that calls the imported function s; the shared library is kept loaded by the imported functions of the Lua state
+    void PushDllFunction(lua_State* L, const LuaCallInfo& s, int ownerIndex)
+    {
+        // the second upvalue is the owner of s (see PushImportedFunctions), which keeps the shared library loaded while the function exists
+        const int results = s.returnType == LuaCallInfo::ReturnType::VOID_ ? 0 : 1;
+        ownerIndex        = lua_absindex(L, ownerIndex);
 
-        if (callDllFunctionEntry == callDllFunction.end())
+        if (s.call)
         {
-            // map does not contain this signature, fall back to runtime search of this signature
-            switch (s.returnType)
-            {
-            case LuaCallInfo::ReturnType::VOID_:
-                CallDllFunction_void(L, s.signature, s.dll, s.functionName);
-                break;
-            case LuaCallInfo::ReturnType::TABLE:
-                CallDllFunction_table(L, s.signature, s.dll, s.functionName);
-                break;
-            case LuaCallInfo::ReturnType::LONG_LONG:
-                CallDllFunction_long_long(L, s.signature, s.dll, s.functionName);
-                break;
-            case LuaCallInfo::ReturnType::STRING:
-                CallDllFunction_const_charPtr(L, s.signature, s.dll, s.functionName);
-                break;
-            case LuaCallInfo::ReturnType::DOUBLE:
-                CallDllFunction_double(L, s.signature, s.dll, s.functionName);
-                break;
-            case LuaCallInfo::ReturnType::VOID_PTR:
-                CallDllFunction_voidPtr(L, s.signature, s.dll, s.functionName);
-                break;
-            case LuaCallInfo::ReturnType::BOOL:
-                CallDllFunction_bool(L, s.signature, s.dll, s.functionName);
-                break;
-            default:
-                throw std::runtime_error("CallDllFunction: function '" + functionName + "' was called with unsupported return type '" + s.signature + "'. Please file an issue on https://github.com/acrion/nexuslua/issues to support it. Currently parameters must be in the following order: table (max 1), void* (max 2), long long (max 6), double (max 3), bool (max 3), std::string (max 1).");
-            }
+            auto* bound     = static_cast<BoundDllFunction*>(lua_newuserdatauv(L, sizeof(BoundDllFunction), 0));
+            bound->function = s.function;
+            bound->call     = s.call;
+            bound->results  = results;
+            lua_pushvalue(L, ownerIndex);
+            lua_pushcclosure(L, CallDllFunction, 2);
         }
         else
         {
-            callDllFunctionEntry->second(L, s.dll, s.functionName);
+            static_assert(std::is_trivially_copyable_v<BoundGenericDllFunction>);
+            new (lua_newuserdatauv(L, sizeof(BoundGenericDllFunction), 0)) BoundGenericDllFunction{s.function, *s.genericCall, results};
+            lua_pushvalue(L, ownerIndex);
+            lua_pushcclosure(L, CallDllFunctionGeneric, 2);
         }
-
-        CBEAM_LOG_DEBUG("CallDllFunction: Success");
-        return nReturnValues;
     }
 
     template <typename T>
@@ -452,6 +506,8 @@ namespace nexuslua::LuaExtension
         auto itDisplayName           = data.find("displayname");
         auto itDescription           = data.find("itDescription");
         auto itParameterDescriptions = subTables.find("parameters");
+        auto itBatch                 = data.find("batch");
+        auto itLazy                  = data.find("lazy");
 
         const std::string              iconPath              = itIconPath == data.end() || cbeam::container::get_value_or_default<std::string>(itIconPath->second).empty()
                                                                  ? ""
@@ -459,13 +515,15 @@ namespace nexuslua::LuaExtension
         const std::string              displayName           = itDisplayName == data.end() ? "" : cbeam::container::get_value_or_default<std::string>(itDisplayName->second);
         const std::string              description           = itDescription == data.end() ? "" : cbeam::container::get_value_or_default<std::string>(itDescription->second);
         const LuaTable::nested_tables& parameterDescriptions = itParameterDescriptions == subTables.end() ? LuaTable::nested_tables() : itParameterDescriptions->second.sub_tables;
+        const bool                     batched               = itBatch != data.end() && cbeam::container::get_value_or_default<bool>(itBatch->second);
+        const bool                     lazy                  = itLazy != data.end() && cbeam::container::get_value_or_default<bool>(itLazy->second);
 
         if (!iconPath.empty() && !std::filesystem::exists(iconPath))
         {
             throw std::runtime_error("Message '" + cbeam::container::get_value_or_default<std::string>(itDisplayName->second) + "' of Lua agent '" + luaPath + "' is specifying a non-existant SVG icon " + iconPath);
         }
 
-        agent->AddMessage(messageName, parameterDescriptions, displayName, description, iconPath);
+        agent->AddMessage(messageName, parameterDescriptions, displayName, description, iconPath, batched, lazy);
 
         CBEAM_LOG_DEBUG("Added message '" + messageName + "' of " + luaPath);
     }
@@ -613,6 +671,39 @@ namespace nexuslua::LuaExtension
         return 1; /* number of results */
     }
 
+    int Call(lua_State* L)
+    {
+        CBEAM_LOG_DEBUG("Lua script called call");
+
+        if (!lua_isstring(L, 1) || !lua_isstring(L, 2))
+        {
+            throw std::runtime_error("The first two arguments of function call must be the names of an agent and of one of its messages");
+        }
+
+        if (!lua_isyieldable(L))
+        {
+            throw std::runtime_error("Function call can only be used by a function that handles a message");
+        }
+
+        lua_settop(L, 3);
+
+        if (!lua_istable(L, 3) && !lua_totableproxy(L, 3))
+        {
+            lua_newtable(L);
+            lua_replace(L, 3);
+        }
+
+        // the handler is suspended; HandlerCoroutines sends the message and resumes it with the reply, which becomes the return value
+        lua_pushlightuserdata(L, const_cast<char*>(&_callMarker));
+        lua_insert(L, 1);
+        return lua_yield(L, 4);
+    }
+
+    bool YieldedByCall(lua_State* L, const int results)
+    {
+        return results == 4 && lua_touserdata(L, -4) == &_callMarker;
+    }
+
     int Cores(lua_State* L)
     {
         lua_pushinteger(L, std::thread::hardware_concurrency());
@@ -661,6 +752,22 @@ namespace nexuslua::LuaExtension
         const char* functionName = lua_tostring(L, 2);
         const char* signature    = lua_tostring(L, 3);
 
+        // imported functions are kept as long as the agent, so a handler that imports a function on each call only loads it once
+        ImportedFunctions& importedFunctions = PushImportedFunctions(L);
+        const int          owner             = lua_gettop(L);
+
+        if (const auto it = importedFunctions.find(functionName); it != importedFunctions.end())
+        {
+            if (it->second.dllName != dllName || it->second.signature != signature)
+            {
+                throw std::runtime_error("Import: Function '"s + functionName + "' is registered more than once");
+            }
+
+            PushDllFunction(L, it->second.callInfo, owner);
+            SetGlobal(L, functionName);
+            return 0;
+        }
+
         std::filesystem::path dllPath(GetDllPath(dllName, functionName));
         LuaCallInfo           s;
 
@@ -698,14 +805,30 @@ namespace nexuslua::LuaExtension
         else
             throw std::runtime_error("Import: Unsupported return type '" + returnType + "'. Supported types are void, table, long long, std::string, double, void* and bool.");
 
-        if (FunctionHasBeenImported(s))
+        if (s.returnType == LuaCallInfo::ReturnType::VOID_ && s.signature.ends_with("table_builder)"))
         {
-            throw std::runtime_error("Import: Function '" + s.functionName + "' is registered more than once");
+            s.returnType = LuaCallInfo::ReturnType::TABLE; // the table built by the function is its result, see table_view.h
         }
 
-        StoreImportedFunction(s);
-        lua_pushcfunction(L, CallDllFunction);
-        lua_setglobal(L, s.functionName.c_str());
+        // resolve the function and the code that calls it once, so that calls need no lookups (see CallDllFunction)
+        s.call = FindCallDllFunction(s.signature);
+
+        if (!s.call)
+        {
+            try
+            {
+                s.genericCall = std::make_shared<const GenericDllCall>(s.signature); // slower, but supports any order of parameters, see GenericDllCall
+            }
+            catch (const std::runtime_error& ex)
+            {
+                throw std::runtime_error("Import: function '" + s.functionName + "' has an unsupported signature '" + s.signature + "' (" + ex.what() + "). Signatures with parameters in the following order are supported on all platforms: table, table_view, void*, long long, double, bool, const char*, table_builder, with at most 3 parameters. Note that type int is not supported, please use long long instead (matching type lua_Integer)");
+            }
+        }
+
+        s.function = &s.dll->get<void()>(s.functionName);
+
+        PushDllFunction(L, importedFunctions.emplace(s.functionName, ImportedFunction{dllName, signature, s}).first->second.callInfo, owner);
+        SetGlobal(L, s.functionName.c_str());
 
         CBEAM_LOG_DEBUG("import: Success");
         return 0; // number of results of Import (it is called from Lua)
@@ -888,6 +1011,27 @@ namespace nexuslua::LuaExtension
         return 0;
     }
 
+    int QueueDepth(lua_State* L)
+    {
+        if (!lua_isstring(L, 1))
+        {
+            throw std::runtime_error("Function queuedepth expects the name of an agent as argument");
+        }
+
+        auto data = _data_of_luaState.at(L, "internal error: current Lua function called `queuedepth`, but no agent is known for this Lua state.");
+
+        const std::vector<std::size_t> depths = data.agent->GetAgents()->GetQueueDepths(lua_tostring(L, 1));
+
+        lua_createtable(L, 0, (int)depths.size());
+        for (std::size_t lane = 0; lane < depths.size(); ++lane)
+        {
+            lua_pushinteger(L, (lua_Integer)depths[lane]);
+            lua_rawseti(L, -2, (lua_Integer)lane);
+        }
+
+        return 1;
+    }
+
     int ScriptDir(lua_State* L)
     {
         auto data = _data_of_luaState.at(L, "internal error: current Lua function called `scriptdir`, but no Lua state is known for this script.");
@@ -910,10 +1054,24 @@ namespace nexuslua::LuaExtension
             parameters.SetReplyToAgentName(agentName);
         }
 
-        auto data = _data_of_luaState.at(L, "internal error: current Lua function called `send`, but no Lua state is known for this script.");
-        data.agent->GetAgents()->GetMessage(agentName, messageName).Send(parameters);
+        // optional 4th parameter: table of send options, currently `block` (default true), see Configuration::mailboxOverflowBlock
+        bool block = true;
 
-        return 0;
+        if (lua_istable(L, 4))
+        {
+            lua_getfield(L, 4, "block");
+            if (!lua_isnil(L, -1))
+            {
+                block = lua_toboolean(L, -1);
+            }
+            lua_pop(L, 1);
+        }
+
+        auto        data    = _data_of_luaState.at(L, "internal error: current Lua function called `send`, but no Lua state is known for this script.");
+        const auto& message = data.agent->GetAgents()->GetMessage(agentName, messageName);
+
+        lua_pushboolean(L, block ? message.Send(std::move(parameters)) : message.TrySend(std::move(parameters)));
+        return 1;
     }
 
     int SetConfig(lua_State* L)
@@ -923,8 +1081,10 @@ namespace nexuslua::LuaExtension
             throw std::runtime_error("Argument of function setconfig must be a lua table");
         }
 
-        auto data = _data_of_luaState.at(L, "internal error: current Lua function called `setconfig`, but no Lua state is known for this script.");
-        data.agent->GetConfiguration().SetTable(lua_totable(L, 1));
+        auto           data   = _data_of_luaState.at(L, "internal error: current Lua function called `setconfig`, but no Lua state is known for this script.");
+        const LuaTable config = lua_totable(L, 1);
+        data.agent->GetConfiguration().SetTable(config);
+        data.agent->GetAgents()->GetConfiguration().SetTable(config); // group-wide: agents that are added afterwards by any agent start with this configuration, see setconfig.md
         return 0;
     }
 
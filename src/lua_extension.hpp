@@ -44,6 +44,7 @@ namespace nexuslua
         int AddAgent(lua_State* L);
         int AddMessage(lua_State* L);
         int AddOffset(lua_State* L);
+        int Call(lua_State* L);
         int Cores(lua_State* L);
         int CurrentDir(lua_State* L);
         int Env(lua_State* L);
@@ -54,11 +55,13 @@ namespace nexuslua
         int Log(lua_State* L);
         int LuaState(lua_State* L);
         int MkTemp(lua_State* L);
+        int NewArray(lua_State* L);
         int Peek(lua_State* L);
         int Poke(lua_State* L);
         int ReadFile(lua_State* L);
         int IsReplicated(lua_State* L);
         int PrintTable(lua_State* L);
+        int QueueDepth(lua_State* L);
         int ScriptDir(lua_State* L);
         int Send(lua_State* L);
         int SetConfig(lua_State* L);
@@ -71,9 +74,11 @@ namespace nexuslua
 
         void RegisterTableForAgent(const Agent* agent, const nexuslua::LuaTable& table);
         void DeregisterTablesOfAgents();
-        void PushRegisteredTables(lua_State* L);
-        void ResetImportedFunctions();
+        void PushRegisteredTables(lua_State* L, int tableIndex = 0); ///< sets the tables registered for the agent of L as globals, or as fields of the table at tableIndex if it is not 0
         void StoreDirectoryOfDll(const std::string& dll_name, const std::filesystem::path& directory);
+        void StoreDirectoryOfDlls(const std::filesystem::path& directory); ///< calls StoreDirectoryOfDll for each shared library in the given directory
         void StoreAgentOfLuaState(lua_State* L, Agent* agent, const std::string& luaPath, const bool isReplicated);
+        void RemoveAgentOfLuaState(lua_State* L);
+        bool YieldedByCall(lua_State* L, int results); ///< true if the coroutine L yielded its results in function `call`; then the agent name, message name and parameters are on top of its stack
     }
 }
@@ -23,29 +23,15 @@ You should have received a copy of the GNU Affero General Public License
 along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 */
 
-#include <boost/dll.hpp>
+#include "lua_call_info.hpp"
 
-#include <functional>
-#include <map>
-#include <memory>
-#include <string>
-
-struct lua_State;
+#include <string_view>
 
 namespace nexuslua
 {
-    typedef std::function<void(lua_State* L, std::shared_ptr<boost::dll::shared_library> dll, std::string functionName)> CallDllFunctionType;
-    extern std::map<std::string, CallDllFunctionType>                                                                    callDllFunction; // initialized in ${CMAKE_CURRENT_BINARY_DIR}/LuaFindSignature_Map.cpp
-
-    // generated in ${CMAKE_CURRENT_BINARY_DIR}/lua_find_signature_map.cpp
-    void InitCallDllFunction();
-
-    // generated in ${CMAKE_CURRENT_BINARY_DIR}/lua_find_signature_if_chain.cpp
-    void CallDllFunction_void(lua_State* L, std::string signature, std::shared_ptr<boost::dll::shared_library> dll, std::string functionName);
-    void CallDllFunction_table(lua_State* L, std::string signature, std::shared_ptr<boost::dll::shared_library> dll, std::string functionName);
-    void CallDllFunction_long_long(lua_State* L, std::string signature, std::shared_ptr<boost::dll::shared_library> dll, std::string functionName);
-    void CallDllFunction_const_charPtr(lua_State* L, std::string signature, std::shared_ptr<boost::dll::shared_library> dll, std::string functionName);
-    void CallDllFunction_double(lua_State* L, std::string signature, std::shared_ptr<boost::dll::shared_library> dll, std::string functionName);
-    void CallDllFunction_voidPtr(lua_State* L, std::string signature, std::shared_ptr<boost::dll::shared_library> dll, std::string functionName);
-    void CallDllFunction_bool(lua_State* L, std::string signature, std::shared_ptr<boost::dll::shared_library> dll, std::string functionName);
+    /// returns the function that calls an imported function with the given signature, or nullptr if the signature is not supported
+    /// \details The signature must be in the format of utility::RemoveWsFromParams. It is looked up in a perfect hash table that is
+    /// generated together with the functions for all supported signatures by lua_code_generator_find_signature.lua into
+    /// ${CMAKE_CURRENT_BINARY_DIR}/lua_find_signature_table.cpp and ${CMAKE_CURRENT_BINARY_DIR}/lua_find_signature_thunks.cpp.
+    CallDllFunctionType FindCallDllFunction(std::string_view signature);
 }
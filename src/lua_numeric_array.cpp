@@ -0,0 +1,396 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "lua.hpp"
+
+#include "lua_extension.hpp"
+#include "numeric_array.hpp"
+
+extern "C"
+{
+#include "lauxlib.h"
+#include "lualib.h"
+}
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace nexuslua
+{
+    namespace
+    {
+        constexpr const char* metatableName = "nexuslua.numeric_array";
+
+        /// header of the userdata that represents a NumericArray in Lua; the elements follow at offset headerSize
+        struct LuaNumericArray
+        {
+            NumericArray::ElementType type;
+            std::size_t               length;
+        };
+
+        constexpr std::size_t headerSize = (sizeof(LuaNumericArray) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+        unsigned char* elementsOf(LuaNumericArray* array)
+        {
+            return reinterpret_cast<unsigned char*>(array) + headerSize;
+        }
+
+        LuaNumericArray* checkArray(lua_State* L, const int idx)
+        {
+            return static_cast<LuaNumericArray*>(luaL_checkudata(L, idx, metatableName));
+        }
+
+        lua_Number getNumber(LuaNumericArray* array, const std::size_t i)
+        {
+            switch (array->type)
+            {
+            case NumericArray::ElementType::Float64:
+                return reinterpret_cast<const double*>(elementsOf(array))[i];
+            case NumericArray::ElementType::Int64:
+                return (lua_Number)reinterpret_cast<const int64_t*>(elementsOf(array))[i];
+            case NumericArray::ElementType::UInt8:
+                return (lua_Number)elementsOf(array)[i];
+            }
+
+            return 0;
+        }
+
+        void pushElement(lua_State* L, LuaNumericArray* array, const std::size_t i)
+        {
+            switch (array->type)
+            {
+            case NumericArray::ElementType::Float64:
+                lua_pushnumber(L, reinterpret_cast<const double*>(elementsOf(array))[i]);
+                break;
+            case NumericArray::ElementType::Int64:
+                lua_pushinteger(L, (lua_Integer)reinterpret_cast<const int64_t*>(elementsOf(array))[i]);
+                break;
+            case NumericArray::ElementType::UInt8:
+                lua_pushinteger(L, (lua_Integer)elementsOf(array)[i]);
+                break;
+            }
+        }
+
+        /// stores the number at stack index valueIdx as element i, converted to the element type of the array
+        void setElement(lua_State* L, LuaNumericArray* array, const std::size_t i, const int valueIdx)
+        {
+            switch (array->type)
+            {
+            case NumericArray::ElementType::Float64:
+                reinterpret_cast<double*>(elementsOf(array))[i] = (double)luaL_checknumber(L, valueIdx);
+                break;
+            case NumericArray::ElementType::Int64:
+                reinterpret_cast<int64_t*>(elementsOf(array))[i] = (int64_t)luaL_checkinteger(L, valueIdx);
+                break;
+            case NumericArray::ElementType::UInt8:
+            {
+                const lua_Integer value = luaL_checkinteger(L, valueIdx);
+
+                if (value < 0 || value > std::numeric_limits<uint8_t>::max())
+                {
+                    throw std::runtime_error("nexuslua: value " + std::to_string(value) + " does not fit into an element of a uint8 array");
+                }
+
+                elementsOf(array)[i] = (uint8_t)value;
+                break;
+            }
+            }
+        }
+
+        /// returns the zero based index of the element at stack index idx, which is one based as usual in Lua
+        std::size_t checkIndex(lua_State* L, LuaNumericArray* array, const int idx)
+        {
+            const lua_Integer index = luaL_checkinteger(L, idx);
+
+            if (index < 1 || (std::size_t)index > array->length)
+            {
+                throw std::runtime_error("nexuslua: index " + std::to_string(index) + " is out of range of a numeric array with " + std::to_string(array->length) + " elements");
+            }
+
+            return (std::size_t)index - 1;
+        }
+
+        int index(lua_State* L)
+        {
+            LuaNumericArray* array = checkArray(L, 1);
+
+            if (lua_isinteger(L, 2))
+            {
+                const lua_Integer i = lua_tointeger(L, 2);
+
+                if (i >= 1 && (std::size_t)i <= array->length)
+                {
+                    pushElement(L, array, (std::size_t)i - 1);
+                }
+                else
+                {
+                    lua_pushnil(L); // like reading beyond the end of a Lua array
+                }
+            }
+            else
+            {
+                lua_pushvalue(L, 2);
+                lua_rawget(L, lua_upvalueindex(1)); // a method, see methods
+            }
+
+            return 1;
+        }
+
+        int newIndex(lua_State* L)
+        {
+            LuaNumericArray* array = checkArray(L, 1);
+            setElement(L, array, checkIndex(L, array, 2), 3);
+            return 0;
+        }
+
+        int length(lua_State* L)
+        {
+            lua_pushinteger(L, (lua_Integer)checkArray(L, 1)->length);
+            return 1;
+        }
+
+        int type(lua_State* L)
+        {
+            const std::string_view name = NumericArray::GetElementTypeName(checkArray(L, 1)->type);
+            lua_pushlstring(L, name.data(), name.size());
+            return 1;
+        }
+
+        int sum(lua_State* L)
+        {
+            LuaNumericArray* array = checkArray(L, 1);
+
+            if (array->type == NumericArray::ElementType::Float64)
+            {
+                const double* elements = reinterpret_cast<const double*>(elementsOf(array));
+                double        result   = 0;
+
+                for (std::size_t i = 0; i < array->length; ++i)
+                {
+                    result += elements[i];
+                }
+
+                lua_pushnumber(L, result);
+            }
+            else
+            {
+                lua_Integer result = 0;
+
+                for (std::size_t i = 0; i < array->length; ++i)
+                {
+                    result += (lua_Integer)getNumber(array, i);
+                }
+
+                lua_pushinteger(L, result);
+            }
+
+            return 1;
+        }
+
+        /// pushes the smallest (if greater is false) or largest element, or nil for an empty array
+        int extreme(lua_State* L, const bool greater)
+        {
+            LuaNumericArray* array = checkArray(L, 1);
+
+            if (array->length == 0)
+            {
+                lua_pushnil(L);
+                return 1;
+            }
+
+            std::size_t result = 0;
+
+            for (std::size_t i = 1; i < array->length; ++i)
+            {
+                if (greater ? getNumber(array, i) > getNumber(array, result) : getNumber(array, i) < getNumber(array, result))
+                {
+                    result = i;
+                }
+            }
+
+            pushElement(L, array, result);
+            return 1;
+        }
+
+        int min(lua_State* L)
+        {
+            return extreme(L, false);
+        }
+
+        int max(lua_State* L)
+        {
+            return extreme(L, true);
+        }
+
+        int fill(lua_State* L)
+        {
+            LuaNumericArray* array = checkArray(L, 1);
+
+            if (array->length > 0)
+            {
+                setElement(L, array, 0, 2);
+
+                const std::size_t size = NumericArray::GetElementSize(array->type);
+
+                for (std::size_t i = 1; i < array->length; ++i)
+                {
+                    std::memcpy(elementsOf(array) + i * size, elementsOf(array), size);
+                }
+            }
+
+            lua_settop(L, 1);
+            return 1; // the array itself, so that calls can be chained
+        }
+
+        int toTable(lua_State* L)
+        {
+            LuaNumericArray* array = checkArray(L, 1);
+            lua_createtable(L, (int)array->length, 0);
+
+            for (std::size_t i = 0; i < array->length; ++i)
+            {
+                pushElement(L, array, i);
+                lua_rawseti(L, -2, (lua_Integer)i + 1);
+            }
+
+            return 1;
+        }
+
+        constexpr luaL_Reg methods[] = {
+            {"fill", fill},
+            {"max", max},
+            {"min", min},
+            {"sum", sum},
+            {"totable", toTable},
+            {"type", type},
+            {nullptr, nullptr}};
+
+        LuaNumericArray* newArray(lua_State* L, const NumericArray::ElementType elementType, const std::size_t elementCount)
+        {
+            auto* array   = static_cast<LuaNumericArray*>(lua_newuserdatauv(L, headerSize + elementCount * NumericArray::GetElementSize(elementType), 0));
+            array->type   = elementType;
+            array->length = elementCount;
+
+            if (luaL_newmetatable(L, metatableName))
+            {
+                lua_newtable(L);
+                luaL_setfuncs(L, methods, 0);
+                lua_pushcclosure(L, index, 1);
+                lua_setfield(L, -2, "__index");
+                lua_pushcfunction(L, newIndex);
+                lua_setfield(L, -2, "__newindex");
+                lua_pushcfunction(L, length);
+                lua_setfield(L, -2, "__len");
+            }
+
+            lua_setmetatable(L, -2);
+            return array;
+        }
+    }
+
+    void lua_pushnumericarray(lua_State* L, const LuaTableBase& array)
+    {
+        const NumericArray::ElementType elementType = NumericArray::GetElementType(array);
+        const std::size_t               length      = NumericArray::GetLength(array);
+        const std::string&              bytes       = std::get<std::string>(array.data.at((std::string)NumericArray::bytesId));
+
+        LuaNumericArray* luaArray = newArray(L, elementType, length);
+        std::memcpy(elementsOf(luaArray), bytes.data(), length * NumericArray::GetElementSize(elementType)); // without the padding of bytes
+    }
+
+    bool lua_isnumericarray(lua_State* L, const int idx)
+    {
+        return luaL_testudata(L, idx, metatableName) != nullptr;
+    }
+
+    LuaTable lua_tonumericarray(lua_State* L, const int idx)
+    {
+        LuaNumericArray* array = checkArray(L, idx);
+        return NumericArray::Create(array->type, elementsOf(array), array->length);
+    }
+
+    void* lua_newnumericarray(lua_State* L, const NumericArray::ElementType type, const std::size_t length)
+    {
+        LuaNumericArray* array = newArray(L, type, length);
+        std::memset(elementsOf(array), 0, length * NumericArray::GetElementSize(type));
+        return elementsOf(array);
+    }
+
+    void* lua_tonumericarraydata(lua_State* L, const int idx, NumericArray::ElementType& type, std::size_t& length)
+    {
+        auto* array = static_cast<LuaNumericArray*>(luaL_testudata(L, idx, metatableName));
+
+        if (!array)
+        {
+            return nullptr;
+        }
+
+        type   = array->type;
+        length = array->length;
+        return elementsOf(array);
+    }
+
+    namespace LuaExtension
+    {
+        int NewArray(lua_State* L)
+        {
+            NumericArray::ElementType elementType;
+
+            if (!lua_isstring(L, 1) || !NumericArray::ParseElementTypeName(lua_tostring(L, 1), elementType))
+            {
+                throw std::runtime_error("Error running function 'newarray': first parameter must be the element type \"float64\", \"int64\" or \"uint8\"");
+            }
+
+            if (lua_istable(L, 2))
+            {
+                const std::size_t elementCount = (std::size_t)lua_rawlen(L, 2);
+                LuaNumericArray*  array        = newArray(L, elementType, elementCount);
+
+                for (std::size_t i = 0; i < elementCount; ++i)
+                {
+                    lua_rawgeti(L, 2, (lua_Integer)i + 1);
+                    setElement(L, array, i, -1);
+                    lua_pop(L, 1);
+                }
+            }
+            else
+            {
+                const lua_Integer elementCount = lua_isinteger(L, 2) ? lua_tointeger(L, 2) : -1;
+
+                if (elementCount < 0)
+                {
+                    throw std::runtime_error("Error running function 'newarray': second parameter must be the number of elements or a Lua array of numbers");
+                }
+
+                LuaNumericArray* array = newArray(L, elementType, (std::size_t)elementCount);
+                std::memset(elementsOf(array), 0, (std::size_t)elementCount * NumericArray::GetElementSize(elementType));
+            }
+
+            return 1;
+        }
+    }
+}
@@ -56,6 +56,14 @@ namespace nexuslua
         }
     }
 
+    void LuaTable::SetOriginalMessage(const std::string& originalName, LuaTable&& originalParameters)
+    {
+        auto& originalMessage = sub_tables[(std::string)Message::originalMessageTableId];
+
+        originalMessage.data[(std::string)Message::originalMessageNameId]             = originalName;
+        originalMessage.sub_tables[(std::string)Message::originalMessageParametersId] = std::move(originalParameters);
+    }
+
     void LuaTable::SetReplyTo(const std::string& agentName, const std::string& messageName)
     {
         SetReplyToAgentName(agentName);
@@ -101,6 +109,23 @@ namespace nexuslua
         return itReplyToTable->second.get_mapped_value_or_default<std::string>((std::string)agentMessageId);
     }
 
+    void LuaTable::SetReplyToCall(const long long id)
+    {
+        sub_tables[(std::string)replyToTableId].data[(std::string)callId] = id;
+    }
+
+    long long LuaTable::GetReplyToCallOrZero() const
+    {
+        const auto& itReplyToTable = sub_tables.find((std::string)replyToTableId);
+
+        if (itReplyToTable == sub_tables.end())
+        {
+            return 0;
+        }
+
+        return itReplyToTable->second.get_mapped_value_or_default<long long>((std::string)callId);
+    }
+
     LuaTableBase LuaTable::GetTableToMergeWhenReplyingOrEmpty() const
     {
         const auto& itReplyToTable = sub_tables.find((std::string)replyToTableId);
@@ -0,0 +1,255 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "lua.hpp"
+
+#include "numeric_array.hpp"
+
+#include <cbeam/convert/string.hpp>
+
+extern "C"
+{
+#include "lauxlib.h"
+#include "lualib.h"
+}
+
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace nexuslua
+{
+    namespace
+    {
+        constexpr const char* metatableName = "nexuslua.table_proxy";
+
+        /// userdata that gives Lua read access to a C++ table without copying it; the uservalue caches proxies of its sub tables
+        struct TableProxy
+        {
+            std::shared_ptr<const LuaTableBase> table; ///< aliases the owner of the table, e. g. the Message that carries it
+        };
+
+        const LuaTableBase& checkProxy(lua_State* L, const int idx)
+        {
+            return *static_cast<TableProxy*>(luaL_checkudata(L, idx, metatableName))->table;
+        }
+
+        /// converts the Lua key at idx like lua_totable does; returns std::nullopt for keys that a LuaTable cannot contain
+        std::optional<cbeam::container::xpod::type> toKey(lua_State* L, const int idx)
+        {
+            if (lua_isinteger(L, idx))
+            {
+                return (long long)lua_tointeger(L, idx);
+            }
+            else if (lua_isnumber(L, idx))
+            {
+                return cbeam::convert::to_string(lua_tonumber(L, idx));
+            }
+            else if (lua_isboolean(L, idx))
+            {
+                return lua_toboolean(L, idx) ? "1"s : "0"s;
+            }
+            else if (lua_isstring(L, idx))
+            {
+                return std::string(lua_tostring(L, idx));
+            }
+
+            return std::nullopt;
+        }
+
+        void pushProxy(lua_State* L, std::shared_ptr<const LuaTableBase> table);
+
+        /// pushes the sub table of the proxy at proxyIdx whose Lua key is at keyIdx, reusing the proxy created by a previous access
+        void pushSubTable(lua_State* L, const int proxyIdx, const int keyIdx, const LuaTableBase& subTable)
+        {
+            if (NumericArray::IsNumericArray(subTable))
+            {
+                lua_pushnumericarray(L, subTable);
+                return;
+            }
+
+            const int key = lua_absindex(L, keyIdx);
+
+            if (lua_getiuservalue(L, proxyIdx, 1) != LUA_TTABLE)
+            {
+                lua_pop(L, 1);
+                lua_newtable(L);
+                lua_pushvalue(L, -1);
+                lua_setiuservalue(L, proxyIdx, 1);
+            }
+
+            lua_pushvalue(L, key);
+
+            if (lua_rawget(L, -2) == LUA_TNIL)
+            {
+                lua_pop(L, 1);
+                const auto& owner = static_cast<TableProxy*>(lua_touserdata(L, proxyIdx))->table;
+                pushProxy(L, std::shared_ptr<const LuaTableBase>(owner, &subTable));
+                lua_pushvalue(L, key);
+                lua_pushvalue(L, -2);
+                lua_rawset(L, -4);
+            }
+
+            lua_remove(L, -2); // the cache
+        }
+
+        int index(lua_State* L)
+        {
+            const LuaTableBase& table = checkProxy(L, 1);
+            const auto          key   = toKey(L, 2);
+
+            if (key)
+            {
+                if (const auto it = table.data.find(*key); it != table.data.end())
+                {
+                    lua_pushvalue(L, it->second);
+                    return 1;
+                }
+
+                if (const auto it = table.sub_tables.find(*key); it != table.sub_tables.end())
+                {
+                    pushSubTable(L, 1, 2, it->second);
+                    return 1;
+                }
+            }
+
+            lua_pushnil(L);
+            return 1;
+        }
+
+        int newIndex(lua_State* L)
+        {
+            checkProxy(L, 1);
+            throw std::runtime_error("nexuslua: the parameters of a message with lazy=true are read-only; copy them with `send` or return them to get a modifiable table");
+        }
+
+        int length(lua_State* L)
+        {
+            // like lua_pushtable: the integer keys 1..n are ordered before all other keys of the maps
+            const LuaTableBase& table = checkProxy(L, 1);
+            const long long     first = 1;
+            const long long     last  = (long long)(table.data.size() + table.sub_tables.size()) + 1;
+
+            lua_pushinteger(L, (lua_Integer)(std::distance(table.data.lower_bound(first), table.data.lower_bound(last)) + std::distance(table.sub_tables.lower_bound(first), table.sub_tables.lower_bound(last))));
+            return 1;
+        }
+
+        /// the iterator function returned by __pairs: visits the values of the table, then its sub tables
+        int next(lua_State* L)
+        {
+            const LuaTableBase& table = checkProxy(L, 1);
+            lua_settop(L, 2);
+
+            auto itData     = table.data.begin();
+            auto itSubTable = table.sub_tables.begin();
+
+            if (!lua_isnil(L, 2))
+            {
+                const auto key = toKey(L, 2);
+
+                if (key && (itData = table.data.find(*key)) != table.data.end())
+                {
+                    ++itData;
+                }
+                else if (key && (itSubTable = table.sub_tables.find(*key)) != table.sub_tables.end())
+                {
+                    itData = table.data.end();
+                    ++itSubTable;
+                }
+                else
+                {
+                    return luaL_error(L, "invalid key to 'next'");
+                }
+            }
+
+            if (itData != table.data.end())
+            {
+                lua_pushvalue(L, itData->first);
+                lua_pushvalue(L, itData->second);
+                return 2;
+            }
+
+            if (itSubTable != table.sub_tables.end())
+            {
+                lua_pushvalue(L, itSubTable->first);
+                pushSubTable(L, 1, -1, itSubTable->second);
+                return 2;
+            }
+
+            lua_pushnil(L);
+            return 1;
+        }
+
+        int pairs(lua_State* L)
+        {
+            checkProxy(L, 1);
+            lua_pushcfunction(L, next);
+            lua_pushvalue(L, 1);
+            lua_pushnil(L);
+            return 3;
+        }
+
+        int collect(lua_State* L)
+        {
+            static_cast<TableProxy*>(luaL_checkudata(L, 1, metatableName))->~TableProxy();
+            return 0;
+        }
+
+        void pushProxy(lua_State* L, std::shared_ptr<const LuaTableBase> table)
+        {
+            new (lua_newuserdatauv(L, sizeof(TableProxy), 1)) TableProxy{std::move(table)};
+
+            if (luaL_newmetatable(L, metatableName))
+            {
+                const luaL_Reg metamethods[] = {
+                    {"__index", index},
+                    {"__newindex", newIndex},
+                    {"__len", length},
+                    {"__pairs", pairs},
+                    {"__gc", collect},
+                    {nullptr, nullptr}};
+
+                luaL_setfuncs(L, metamethods, 0);
+            }
+
+            lua_setmetatable(L, -2);
+        }
+    }
+
+    void lua_pushtableproxy(lua_State* L, std::shared_ptr<const LuaTableBase> table)
+    {
+        pushProxy(L, std::move(table));
+    }
+
+    const LuaTableBase* lua_totableproxy(lua_State* L, const int idx)
+    {
+        auto* proxy = static_cast<TableProxy*>(luaL_testudata(L, idx, metatableName));
+        return proxy ? proxy->table.get() : nullptr;
+    }
+}
@@ -0,0 +1,364 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "lua.hpp"
+
+#include "numeric_array.hpp"
+#include "table_view.h"
+
+extern "C"
+{
+#include "lauxlib.h"
+#include "lualib.h"
+}
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace nexuslua
+{
+    namespace
+    {
+        static_assert((int)NumericArray::ElementType::Float64 == NEXUSLUA_FLOAT64
+                          && (int)NumericArray::ElementType::Int64 == NEXUSLUA_INT64
+                          && (int)NumericArray::ElementType::UInt8 == NEXUSLUA_UINT8,
+                      "nexuslua_element_type must match NumericArray::ElementType");
+
+        extern const nexuslua_table_api tableApi;
+
+        template <typename T>
+        lua_State* stateOf(const T* viewOrBuilder)
+        {
+            return static_cast<lua_State*>(viewOrBuilder->state);
+        }
+
+        void toValue(lua_State* L, const int idx, nexuslua_value* value)
+        {
+            NumericArray::ElementType elementType;
+            std::size_t               length;
+
+            switch (lua_type(L, idx))
+            {
+            case LUA_TNUMBER:
+                if (lua_isinteger(L, idx))
+                {
+                    value->type       = NEXUSLUA_INTEGER;
+                    value->as.integer = (long long)lua_tointeger(L, idx);
+                }
+                else
+                {
+                    value->type      = NEXUSLUA_NUMBER;
+                    value->as.number = (double)lua_tonumber(L, idx);
+                }
+                break;
+            case LUA_TBOOLEAN:
+                value->type       = NEXUSLUA_BOOLEAN;
+                value->as.boolean = lua_toboolean(L, idx);
+                break;
+            case LUA_TSTRING:
+                value->type           = NEXUSLUA_STRING;
+                value->as.string.data = lua_tolstring(L, idx, &value->as.string.size);
+                break;
+            case LUA_TLIGHTUSERDATA:
+                value->type       = NEXUSLUA_POINTER;
+                value->as.pointer = lua_touserdata(L, idx);
+                break;
+            case LUA_TTABLE:
+                value->type     = NEXUSLUA_TABLE;
+                value->as.table = {&tableApi, L, idx};
+                break;
+            case LUA_TUSERDATA:
+                if (void* elements = lua_tonumericarraydata(L, idx, elementType, length))
+                {
+                    value->type     = NEXUSLUA_ARRAY;
+                    value->as.array = {(nexuslua_element_type)elementType, elements, length};
+                }
+                else if (lua_totableproxy(L, idx))
+                {
+                    value->type     = NEXUSLUA_TABLE;
+                    value->as.table = {&tableApi, L, idx};
+                }
+                else
+                {
+                    value->type       = NEXUSLUA_POINTER;
+                    value->as.pointer = lua_touserdata(L, idx);
+                }
+                break;
+            default:
+                value->type = NEXUSLUA_NIL;
+                break;
+            }
+        }
+
+        /// returns true if the value at idx, which has been read from view, must stay on the stack until the imported function returns
+        /// \details Views of sub tables refer to their stack index. Strings and arrays of a Lua table are kept alive by the table, but
+        /// those of a table proxy are created on access (see lua_pushtableproxy).
+        bool mustKeep(lua_State* L, const nexuslua_table_view* view, const int idx)
+        {
+            const int type = lua_type(L, idx);
+            return type == LUA_TTABLE || lua_totableproxy(L, idx) || (!lua_istable(L, view->index) && (type == LUA_TSTRING || type == LUA_TUSERDATA));
+        }
+
+        /// pushes key or value; returns false without pushing anything if it cannot be stored as requested
+        bool push(lua_State* L, const nexuslua_value* value, const bool isKey)
+        {
+            switch (value->type)
+            {
+            case NEXUSLUA_NIL:
+                if (isKey)
+                {
+                    return false;
+                }
+                lua_pushnil(L);
+                return true;
+            case NEXUSLUA_INTEGER:
+                lua_pushinteger(L, (lua_Integer)value->as.integer);
+                return true;
+            case NEXUSLUA_NUMBER:
+                if (isKey && std::isnan(value->as.number))
+                {
+                    return false;
+                }
+                lua_pushnumber(L, (lua_Number)value->as.number);
+                return true;
+            case NEXUSLUA_BOOLEAN:
+                lua_pushboolean(L, value->as.boolean);
+                return true;
+            case NEXUSLUA_STRING:
+                lua_pushlstring(L, value->as.string.data, value->as.string.size);
+                return true;
+            case NEXUSLUA_POINTER:
+                lua_pushlightuserdata(L, value->as.pointer);
+                return true;
+            case NEXUSLUA_TABLE:
+                if (isKey || value->as.table.state != L)
+                {
+                    return false;
+                }
+                lua_pushvalue(L, value->as.table.index);
+                return true;
+            case NEXUSLUA_ARRAY:
+                if (isKey || value->as.array.type < NEXUSLUA_FLOAT64 || value->as.array.type > NEXUSLUA_UINT8)
+                {
+                    return false;
+                }
+                std::memcpy(lua_newnumericarray(L, (NumericArray::ElementType)value->as.array.type, value->as.array.length),
+                            value->as.array.data,
+                            value->as.array.length * NumericArray::GetElementSize((NumericArray::ElementType)value->as.array.type));
+                return true;
+            }
+
+            return false;
+        }
+
+        size_t length(const nexuslua_table_view* view)
+        {
+            lua_State* L = stateOf(view);
+            lua_len(L, view->index); // respects __len of table proxies
+            const lua_Integer result = lua_tointeger(L, -1);
+            lua_pop(L, 1);
+            return result > 0 ? (size_t)result : 0;
+        }
+
+        int get(const nexuslua_table_view* view, const nexuslua_value* key, nexuslua_value* value)
+        {
+            lua_State* L = stateOf(view);
+
+            if (!lua_checkstack(L, 2) || !push(L, key, true))
+            {
+                value->type = NEXUSLUA_NIL;
+                return 0;
+            }
+
+            lua_gettable(L, view->index); // respects __index of table proxies
+
+            const int idx = lua_gettop(L);
+            toValue(L, idx, value);
+
+            if (!mustKeep(L, view, idx))
+            {
+                lua_pop(L, 1);
+            }
+
+            return value->type != NEXUSLUA_NIL;
+        }
+
+        int next(const nexuslua_table_view* view, nexuslua_iterator* iterator, nexuslua_value* key, nexuslua_value* value)
+        {
+            lua_State* L = stateOf(view);
+
+            if (!lua_checkstack(L, 5))
+            {
+                return 0;
+            }
+
+            if (lua_istable(L, view->index))
+            {
+                if (iterator->state == 0)
+                {
+                    lua_pushnil(L);
+                    iterator->state = lua_gettop(L); // the slot of the current key
+                }
+
+                lua_pushvalue(L, iterator->state);
+
+                if (!lua_next(L, view->index))
+                {
+                    return 0;
+                }
+            }
+            else
+            {
+                if (iterator->state == 0)
+                {
+                    if (luaL_getmetafield(L, view->index, "__pairs") == LUA_TNIL)
+                    {
+                        return 0;
+                    }
+
+                    lua_pushvalue(L, view->index);
+                    lua_call(L, 1, 3);
+                    iterator->state = lua_gettop(L); // the slot of the current key, preceded by the iterator function and its state
+                }
+
+                lua_pushvalue(L, iterator->state - 2);
+                lua_pushvalue(L, iterator->state - 1);
+                lua_pushvalue(L, iterator->state);
+                lua_call(L, 2, 2);
+
+                if (lua_isnil(L, -2))
+                {
+                    lua_pop(L, 2);
+                    return 0;
+                }
+            }
+
+            lua_copy(L, -2, iterator->state);
+
+            const int  keyIdx    = lua_gettop(L) - 1;
+            const bool keepKey   = mustKeep(L, view, keyIdx);
+            const bool keepValue = mustKeep(L, view, keyIdx + 1);
+
+            toValue(L, keyIdx, key);
+            toValue(L, keyIdx + 1, value);
+
+            if (!keepValue)
+            {
+                lua_pop(L, 1);
+            }
+
+            if (!keepKey)
+            {
+                lua_remove(L, keyIdx);
+
+                if (value->type == NEXUSLUA_TABLE)
+                {
+                    value->as.table.index = keyIdx;
+                }
+            }
+
+            return 1;
+        }
+
+        int set(const nexuslua_table_builder* builder, const nexuslua_value* key, const nexuslua_value* value)
+        {
+            lua_State* L   = stateOf(builder);
+            const int  top = lua_gettop(L);
+
+            if (!lua_checkstack(L, 2) || !push(L, key, true) || !push(L, value, false))
+            {
+                lua_settop(L, top);
+                return 0;
+            }
+
+            lua_settable(L, builder->index);
+            return 1;
+        }
+
+        nexuslua_table_builder addTable(const nexuslua_table_builder* builder, const nexuslua_value* key)
+        {
+            lua_State* L = stateOf(builder);
+
+            if (!lua_checkstack(L, 3))
+            {
+                return {};
+            }
+
+            lua_newtable(L);
+            const int table = lua_gettop(L); // stays on the stack, so that the returned builder can refer to it
+
+            if (!push(L, key, true))
+            {
+                lua_pop(L, 1);
+                return {};
+            }
+
+            lua_pushvalue(L, table);
+            lua_settable(L, builder->index);
+            return {&tableApi, L, table};
+        }
+
+        void* addArray(const nexuslua_table_builder* builder, const nexuslua_value* key, const nexuslua_element_type type, const size_t length)
+        {
+            lua_State* L = stateOf(builder);
+
+            if (type < NEXUSLUA_FLOAT64 || type > NEXUSLUA_UINT8 || !lua_checkstack(L, 3) || !push(L, key, true))
+            {
+                return nullptr;
+            }
+
+            void* elements = lua_newnumericarray(L, (NumericArray::ElementType)type, length);
+            lua_settable(L, builder->index); // the table keeps the array alive
+            return elements;
+        }
+
+        const nexuslua_table_api tableApi{
+            .version   = NEXUSLUA_TABLE_API_VERSION,
+            .length    = length,
+            .get       = get,
+            .next      = next,
+            .set       = set,
+            .add_table = addTable,
+            .add_array = addArray};
+    }
+
+    nexuslua_table_view lua_totableview(lua_State* L, const int idx)
+    {
+        if (!lua_istable(L, idx) && !lua_totableproxy(L, idx))
+        {
+            throw std::runtime_error("nexuslua: expected a table for a parameter of type table_view, got " + std::string(luaL_typename(L, idx)));
+        }
+
+        return {&tableApi, L, lua_absindex(L, idx)};
+    }
+
+    nexuslua_table_builder lua_newtablebuilder(lua_State* L)
+    {
+        lua_newtable(L);
+        return {&tableApi, L, lua_gettop(L)};
+    }
+}
@@ -0,0 +1,709 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "mailbox.hpp"
+
+#include "cpu_affinity.hpp"
+#include "scheduler.hpp"
+
+#include <cbeam/concurrency/thread.hpp>
+#include <cbeam/logging/log_manager.hpp>
+
+#include <algorithm>
+
+using namespace std::string_literals;
+
+namespace nexuslua
+{
+    namespace
+    {
+        thread_local const Mailbox*             handlingMailbox = nullptr; ///< the mailbox whose handler is executed by the current thread, if any
+        thread_local const void*                handlingOwner   = nullptr; ///< the owner of this handler
+        thread_local std::vector<Mailbox::Task> afterHandler;              ///< see Mailbox::RunAfterHandler
+
+        bool haveSameName(const Message& a, const Message& b)
+        {
+            // messages sent via AgentMessage::Send carry their interned name
+            return a.message_id >= 0 && b.message_id >= 0 ? a.message_id == b.message_id : a.name == b.name;
+        }
+    }
+
+    Mailbox::Mailbox(Scheduler* scheduler, std::size_t lanes, const Dequeue dequeue)
+        : _scheduler{scheduler}
+        , _dequeue{dequeue}
+    {
+        lanes = std::clamp<std::size_t>(lanes, 1, maxLanes);
+
+        _lanes.resize(lanes);
+        _credits.resize(lanes, 0);
+
+        for (std::size_t lane = 0; lane < lanes; ++lane)
+        {
+            _weights.push_back(1LL << (lanes - 1 - lane));
+        }
+    }
+
+    Mailbox::~Mailbox()
+    {
+        // the threads of the handlers keep the mailbox alive, so they have all been removed
+        for (auto& thread : _exited)
+        {
+            if (thread.get_id() == std::this_thread::get_id())
+            {
+                thread.detach(); // the mailbox is released by the thread of a handler that removed itself, which ends now
+            }
+            else if (thread.joinable())
+            {
+                thread.join();
+            }
+        }
+    }
+
+    void Mailbox::AddHandler(const void* owner, Handler handler, const std::string& threadName, Task first)
+    {
+        std::lock_guard lock(_mtx);
+        _handlers[owner] = std::move(handler);
+
+        if (first)
+        {
+            // posted tasks run before queued messages, see Process and Run
+            _posted[owner].emplace_back(std::move(first));
+        }
+
+        if (_scheduler)
+        {
+            _idle.push_back(owner);
+            Schedule(false);
+
+            if (_posted.count(owner) > 0)
+            {
+                SchedulePosted(owner);
+            }
+        }
+        else
+        {
+            _threads[owner] = std::thread(&Mailbox::Run, shared_from_this(), owner, threadName); // keeps the mailbox alive until the thread ends
+        }
+    }
+
+    void Mailbox::RemoveHandler(const void* owner)
+    {
+        std::vector<Task> discarded; // destroyed after the lock is released, because tasks may own agents
+        std::unique_lock  lock(_mtx);
+
+        if (_handlers.count(owner) == 0)
+        {
+            return;
+        }
+
+        auto posted = _posted.find(owner);
+        if (posted != _posted.end())
+        {
+            discarded = std::move(posted->second);
+            _posted.erase(posted);
+        }
+
+        Remove(lock, owner);
+    }
+
+    bool Mailbox::RemoveHandlerIfIdle(const void* owner, const std::function<bool()>& idle)
+    {
+        std::unique_lock lock(_mtx);
+
+        if (_handlers.count(owner) == 0 || _busy.count(owner) > 0 || _posted.count(owner) > 0 || !idle())
+        {
+            return false;
+        }
+
+        Remove(lock, owner);
+        return true;
+    }
+
+    void Mailbox::Remove(std::unique_lock<std::mutex>& lock, const void* owner)
+    {
+        // called with _mtx locked; may unlock it
+        _handlers.erase(owner);
+
+        if (_scheduler)
+        {
+            _idle.erase(std::remove(_idle.begin(), _idle.end(), owner), _idle.end());
+            _cvQueued.notify_all(); // ends a Linger of the handler
+
+            if (!(handlingMailbox == this && handlingOwner == owner)) // a handler that removes itself cannot wait for itself; Process returns after it
+            {
+                _cvReleased.wait(lock, [this, owner]
+                                 { return _busy.count(owner) == 0; });
+            }
+            return;
+        }
+
+        std::thread thread = std::move(_threads[owner]);
+        _threads.erase(owner);
+
+        if (thread.get_id() == std::this_thread::get_id())
+        {
+            // the handler removed itself; its thread ends after the current message and is joined by the destructor, which cannot
+            // run before, because the thread keeps the mailbox alive
+            _exited.emplace_back(std::move(thread));
+            lock.unlock();
+            _cvQueued.notify_all();
+            return;
+        }
+
+        lock.unlock();
+        _cvQueued.notify_all();
+
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+
+    bool Mailbox::IsHandling(const void* owner)
+    {
+        return handlingMailbox && handlingOwner == owner;
+    }
+
+    void Mailbox::RunAfterHandler(Task task)
+    {
+        if (handlingMailbox)
+        {
+            afterHandler.emplace_back(std::move(task));
+        }
+        else
+        {
+            task();
+        }
+    }
+
+    Mailbox::PushResult Mailbox::Push(std::shared_ptr<Message> message, const std::size_t lane, const bool mayBlock, std::shared_ptr<Message>* dropped)
+    {
+        PushResult result = PushResult::Queued;
+        bool       lingering;
+        {
+            std::unique_lock lock(_mtx);
+
+            if (_capacity > 0 && _queued >= _capacity && !_closed)
+            {
+                if (_overflow == Overflow::Fail || (_overflow == Overflow::Block && !mayBlock))
+                {
+                    ++_overflowCount;
+                    return PushResult::Rejected;
+                }
+
+                if (_overflow == Overflow::Block && handlingMailbox != this && !Scheduler::IsWorkerThread())
+                {
+                    ++_blockedSenders;
+                    _cvSpace.wait(lock, [this]
+                                  { return _queued < _capacity || _closed; });
+                    --_blockedSenders;
+                }
+            }
+
+            const Message* pushed = message.get();
+            _lanes[std::min(lane, _lanes.size() - 1)].emplace_back(std::move(message));
+            ++_queued;
+
+            if (_capacity > 0 && _queued > _capacity && _overflow == Overflow::DropOldest)
+            {
+                ++_overflowCount;
+                // the dropped message is the oldest one of the lowest priority lane, which may be the new message itself
+                auto lowest = std::find_if(_lanes.rbegin(), _lanes.rend(), [](const auto& queue)
+                                           { return !queue.empty(); });
+                result      = lowest->front().get() == pushed ? PushResult::Rejected : PushResult::DroppedOldest;
+
+                if (result == PushResult::DroppedOldest && dropped)
+                {
+                    *dropped = std::move(lowest->front());
+                }
+
+                lowest->pop_front();
+                --_queued;
+
+                if (result == PushResult::Rejected)
+                {
+                    return result;
+                }
+            }
+
+            _highWaterMark = std::max(_highWaterMark, _queued);
+            ++_pushed;
+            lingering = _lingering > 0;
+
+            if (_scheduler)
+            {
+                Schedule(false);
+            }
+        }
+
+        if (lingering)
+        {
+            _cvQueued.notify_all(); // the message may complete a batch that is waiting for it
+        }
+        else if (!_scheduler)
+        {
+            _cvQueued.notify_one();
+        }
+
+        return result;
+    }
+
+    bool Mailbox::Post(const void* owner, Task task)
+    {
+        {
+            std::lock_guard lock(_mtx);
+
+            if (_handlers.count(owner) == 0)
+            {
+                return false;
+            }
+
+            _posted[owner].emplace_back(std::move(task));
+
+            if (_scheduler)
+            {
+                SchedulePosted(owner);
+                return true;
+            }
+        }
+
+        _cvQueued.notify_all(); // wakes the thread of owner
+        return true;
+    }
+
+    void Mailbox::SetCapacity(const std::size_t capacity, const Overflow overflow)
+    {
+        std::lock_guard lock(_mtx);
+        _capacity = capacity;
+        _overflow = overflow;
+        Released();
+    }
+
+    void Mailbox::SetAffinity(std::shared_ptr<CpuAffinity> affinity)
+    {
+        std::lock_guard lock(_mtx);
+        _affinity = std::move(affinity);
+    }
+
+    void Mailbox::Close()
+    {
+        std::lock_guard lock(_mtx);
+        _closed = true;
+        _cvSpace.notify_all();
+    }
+
+    std::size_t Mailbox::GetHighWaterMark()
+    {
+        std::lock_guard lock(_mtx);
+        return _highWaterMark;
+    }
+
+    std::size_t Mailbox::GetOverflowCount()
+    {
+        std::lock_guard lock(_mtx);
+        return _overflowCount;
+    }
+
+    void Mailbox::Released()
+    {
+        // called with _mtx locked after messages have been taken from the lanes
+        if (_blockedSenders > 0 && (_capacity == 0 || _queued < _capacity))
+        {
+            _cvSpace.notify_all();
+        }
+    }
+
+    std::vector<std::size_t> Mailbox::GetLaneDepths()
+    {
+        std::lock_guard          lock(_mtx);
+        std::vector<std::size_t> depths;
+
+        for (const auto& lane : _lanes)
+        {
+            depths.push_back(lane.size());
+        }
+
+        return depths;
+    }
+
+    std::size_t Mailbox::GetLaneCount() const
+    {
+        return _lanes.size();
+    }
+
+    void Mailbox::SetBatching(const std::size_t size, const std::chrono::duration<double> linger, BatchSelection batched)
+    {
+        std::lock_guard lock(_mtx);
+        _batchSize   = std::max<std::size_t>(size, 1);
+        _batchLinger = linger;
+        _batched     = std::move(batched);
+    }
+
+    Mailbox::BatchSelection Mailbox::GetBatchSelection()
+    {
+        std::lock_guard lock(_mtx);
+        return _batched;
+    }
+
+    std::size_t Mailbox::Pop(std::vector<std::shared_ptr<Message>>& batch)
+    {
+        // called with _mtx locked and _queued > 0; returns the lane of the batch
+        std::size_t next = _lanes.size();
+
+        if (_dequeue == Dequeue::Strict)
+        {
+            next = 0;
+            while (_lanes[next].empty())
+            {
+                ++next;
+            }
+        }
+        else
+        {
+            // smooth weighted round robin over the non-empty lanes
+            long long total = 0;
+
+            for (std::size_t lane = 0; lane < _lanes.size(); ++lane)
+            {
+                if (!_lanes[lane].empty())
+                {
+                    _credits[lane] += _weights[lane];
+                    total += _weights[lane];
+
+                    if (next == _lanes.size() || _credits[lane] > _credits[next])
+                    {
+                        next = lane;
+                    }
+                }
+            }
+
+            _credits[next] -= total;
+        }
+
+        batch.clear();
+        batch.emplace_back(std::move(_lanes[next].front()));
+        _lanes[next].pop_front();
+        --_queued;
+
+        if (_batchSize > 1 && _batched && _batched(*batch.front()))
+        {
+            TakeBatch(next, batch);
+        }
+
+        Released();
+
+        return next;
+    }
+
+    void Mailbox::TakeBatch(const std::size_t lane, std::vector<std::shared_ptr<Message>>& batch)
+    {
+        // called with _mtx locked; moves further messages with the name of the first one from the lane to the batch, keeping the order of the remaining ones
+        auto&          queue = _lanes[lane];
+        auto           kept  = queue.begin();
+        auto           it    = queue.begin();
+        const Message& first = *batch.front();
+
+        for (; it != queue.end() && batch.size() < _batchSize; ++it)
+        {
+            if (haveSameName(**it, first))
+            {
+                batch.emplace_back(std::move(*it));
+                --_queued;
+            }
+            else
+            {
+                if (kept != it)
+                {
+                    *kept = std::move(*it);
+                }
+                ++kept;
+            }
+        }
+
+        if (kept != it)
+        {
+            queue.erase(std::move(it, queue.end(), kept), queue.end());
+            Released();
+        }
+    }
+
+    void Mailbox::Linger(std::unique_lock<std::mutex>& lock, const void* owner, const std::size_t lane, std::vector<std::shared_ptr<Message>>& batch)
+    {
+        if (batch.size() >= _batchSize || _batchLinger.count() <= 0 || !_batched || !_batched(*batch.front()))
+        {
+            return;
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(_batchLinger);
+        ++_lingering;
+
+        while (batch.size() < _batchSize)
+        {
+            const std::size_t pushed = _pushed;
+
+            if (!_cvQueued.wait_until(lock, deadline, [this, owner, pushed]
+                                      { return _pushed != pushed || _handlers.count(owner) == 0; })
+                || _handlers.count(owner) == 0)
+            {
+                break;
+            }
+
+            TakeBatch(lane, batch);
+        }
+
+        --_lingering;
+    }
+
+    void Mailbox::Invoke(const void* owner, const Handler& handler, std::vector<std::shared_ptr<Message>>& batch)
+    {
+        const Mailbox* previous      = handlingMailbox;
+        const void*    previousOwner = handlingOwner;
+        handlingMailbox              = this;
+        handlingOwner                = owner;
+
+        try
+        {
+            handler(std::span<std::shared_ptr<Message>>(batch));
+        }
+        catch (const std::exception& ex)
+        {
+            CBEAM_LOG("Mailbox: exception while handling message '" + batch.front()->name + "': "s + ex.what());
+        }
+        catch (...)
+        {
+            CBEAM_LOG("Mailbox: unknown exception while handling message '" + batch.front()->name + "'");
+        }
+
+        RunTasksAfterHandler();
+        handlingMailbox = previous;
+        handlingOwner   = previousOwner;
+    }
+
+    void Mailbox::RunTasksAfterHandler()
+    {
+        // the tasks may remove the handler, which does not wait for itself, because handlingMailbox and handlingOwner are still set
+        std::vector<Task> tasks;
+        tasks.swap(afterHandler);
+
+        for (auto& task : tasks)
+        {
+            try
+            {
+                task();
+            }
+            catch (const std::exception& ex)
+            {
+                CBEAM_LOG("Mailbox: exception while running a task after the handler: "s + ex.what());
+            }
+            catch (...)
+            {
+                CBEAM_LOG("Mailbox: unknown exception while running a task after the handler");
+            }
+        }
+    }
+
+    bool Mailbox::RunPosted(std::unique_lock<std::mutex>& lock, const void* owner)
+    {
+        // called with _mtx locked; runs the tasks posted for owner with _mtx unlocked
+        auto posted = _posted.find(owner);
+
+        if (posted == _posted.end())
+        {
+            return false;
+        }
+
+        std::vector<Task> tasks = std::move(posted->second);
+        _posted.erase(posted);
+        lock.unlock();
+
+        const Mailbox* previous      = handlingMailbox;
+        const void*    previousOwner = handlingOwner;
+        handlingMailbox              = this;
+        handlingOwner                = owner;
+
+        for (auto& task : tasks)
+        {
+            try
+            {
+                task();
+            }
+            catch (const std::exception& ex)
+            {
+                CBEAM_LOG("Mailbox: exception while running a posted task: "s + ex.what());
+            }
+            catch (...)
+            {
+                CBEAM_LOG("Mailbox: unknown exception while running a posted task");
+            }
+        }
+
+        tasks.clear();
+        RunTasksAfterHandler();
+        handlingMailbox = previous;
+        handlingOwner   = previousOwner;
+        lock.lock();
+
+        return true;
+    }
+
+    void Mailbox::SchedulePosted(const void* owner)
+    {
+        // called with _mtx locked; a busy handler runs the posted tasks before its next message
+        auto idle = std::find(_idle.begin(), _idle.end(), owner);
+
+        if (idle != _idle.end())
+        {
+            _idle.erase(idle);
+            _busy.insert(owner);
+
+            // behind the tasks that are currently queued, so that e. g. a handler that yields gives way to other agents
+            _scheduler->Defer([self = shared_from_this(), owner]
+                              { self->Process(owner); });
+        }
+    }
+
+    void Mailbox::Schedule(bool defer)
+    {
+        // called with _mtx locked; start one task per idle handler until each pending message has a task
+        while (!_idle.empty() && _queued > _busy.size())
+        {
+            const void* owner = _idle.back();
+            _idle.pop_back();
+            _busy.insert(owner);
+
+            auto task = [self = shared_from_this(), owner]
+            { self->Process(owner); };
+
+            if (defer)
+            {
+                _scheduler->Defer(std::move(task));
+            }
+            else
+            {
+                _scheduler->Submit(std::move(task));
+            }
+        }
+    }
+
+    void Mailbox::Process(const void* owner)
+    {
+        Handler                               handler;
+        std::vector<std::shared_ptr<Message>> batch;
+
+        for (std::size_t handled = 0;; ++handled)
+        {
+            {
+                std::unique_lock lock(_mtx);
+
+                if (_handlers.count(owner) > 0)
+                {
+                    RunPosted(lock, owner);
+                }
+
+                auto it = _handlers.find(owner);
+
+                if (it == _handlers.end() || (_queued == 0 && _posted.count(owner) == 0) || handled == messagesPerTask)
+                {
+                    _busy.erase(owner);
+
+                    if (it != _handlers.end())
+                    {
+                        _idle.push_back(owner);
+                        Schedule(true); // if messages are left, queue them behind the other agents' tasks
+
+                        if (_posted.count(owner) > 0)
+                        {
+                            SchedulePosted(owner);
+                        }
+                    }
+
+                    _cvReleased.notify_all();
+                    return;
+                }
+
+                if (_queued == 0)
+                {
+                    continue; // more tasks have been posted while running the previous ones
+                }
+
+                if (!handler)
+                {
+                    handler = it->second;
+                }
+
+                Linger(lock, owner, Pop(batch), batch); // occupies the worker of the Scheduler for at most the linger time
+            }
+
+            Invoke(owner, handler, batch);
+        }
+    }
+
+    void Mailbox::Run(const void* owner, const std::string& threadName)
+    {
+        if (!threadName.empty())
+        {
+            cbeam::concurrency::set_thread_name(threadName.c_str());
+        }
+
+        Handler                               handler;
+        std::vector<std::shared_ptr<Message>> batch;
+        std::unique_lock                      lock(_mtx);
+
+        if (_affinity)
+        {
+            _affinity->ApplyToCurrentThread();
+        }
+
+        while (true)
+        {
+            _busy.erase(owner);
+            _cvQueued.wait(lock, [this, owner]
+                           { return _queued > 0 || _posted.count(owner) > 0 || _handlers.count(owner) == 0; });
+
+            auto it = _handlers.find(owner);
+            if (it == _handlers.end())
+            {
+                return;
+            }
+
+            _busy.insert(owner); // see RemoveHandlerIfIdle
+
+            if (RunPosted(lock, owner) || _queued == 0)
+            {
+                continue;
+            }
+
+            if (!handler)
+            {
+                handler = it->second;
+            }
+
+            Linger(lock, owner, Pop(batch), batch);
+            lock.unlock();
+            Invoke(owner, handler, batch);
+            lock.lock();
+        }
+    }
+}
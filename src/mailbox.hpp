@@ -0,0 +1,195 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "message.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nexuslua
+{
+    class CpuAffinity;
+    class Scheduler;
+
+    /// \brief message queue of one agent
+    /// \details Each registered handler (an AgentThread, i. e. one Lua state or one C++ handler) processes at most one
+    /// message at a time. Replicas register additional handlers, so that up to one message per handler is processed
+    /// concurrently. The handlers are either executed by a Scheduler (Configuration::schedulerPool) or each by its own
+    /// thread (Configuration::schedulerThreads).
+    ///
+    /// Messages are queued in priority lanes, lane 0 having the highest priority. Within a lane, messages are
+    /// dequeued in FIFO order. Across lanes, the next message is either taken from the first non-empty lane
+    /// (Dequeue::Strict) or by weighted round robin, each lane having twice the weight of the next one
+    /// (Dequeue::Weighted), so that lower priority lanes are not starved.
+    ///
+    /// Messages whose name is selected by SetBatching are handed to the handler in batches: together with the dequeued
+    /// message, the handler receives the other queued messages of the same name and lane, optionally waiting a short
+    /// linger time for more of them.
+    ///
+    /// By default the mailbox is unbounded. SetCapacity limits the number of queued messages and selects what Push does
+    /// if the limit is reached, see Overflow.
+    ///
+    /// Post queues a task for one specific handler, e. g. to resume a message handler that waits for a reply. Posted
+    /// tasks bypass the lanes and the capacity and are run before the handler takes its next message.
+    class Mailbox : public std::enable_shared_from_this<Mailbox>
+    {
+    public:
+        using Handler        = std::function<void(std::span<std::shared_ptr<Message>> messages)>; ///< receives a single message, unless batching is enabled for its name
+        using BatchSelection = std::function<bool(const Message& message)>;
+        using Task           = std::function<void()>;
+
+        enum class Dequeue
+        {
+            Strict,
+            Weighted
+        };
+
+        enum class Overflow
+        {
+            Block,     ///< the sender waits until a handler took a message from the mailbox, see Push
+            Fail,      ///< the new message is rejected
+            DropOldest ///< the oldest message of the lowest priority lane is discarded to make room
+        };
+
+        enum class PushResult
+        {
+            Queued,
+            Rejected,     ///< the message was not queued, because the mailbox is full
+            DroppedOldest ///< the message was queued, but another one was discarded (Overflow::DropOldest)
+        };
+
+        explicit Mailbox(Scheduler* scheduler, std::size_t lanes = 1, Dequeue dequeue = Dequeue::Strict); ///< if scheduler is nullptr, each handler gets its own thread
+        virtual ~Mailbox();
+
+        /// adds the handler of owner; if first is set, it is posted for owner (see Post) before the handler can take a queued message
+        void                     AddHandler(const void* owner, Handler handler, const std::string& threadName = {}, Task first = nullptr);
+        void                     RemoveHandler(const void* owner); ///< blocks until the handler finished the message it is currently processing, unless it is called by the handler itself
+        std::vector<std::size_t> GetLaneDepths();                  ///< number of queued messages per lane
+        std::size_t              GetLaneCount() const;
+        std::size_t              GetHighWaterMark();               ///< maximum number of messages that have been queued at the same time
+        std::size_t              GetOverflowCount();               ///< number of messages that have been rejected or dropped because the mailbox was full
+
+        /// queues the message; lanes beyond the last one are mapped to the last lane
+        /// \details If the mailbox is full and its Overflow is Block, the call waits for space if mayBlock is true and otherwise
+        /// returns PushResult::Rejected. A handler of this mailbox that sends to its own agent never waits, because it would
+        /// wait for itself, and neither does a worker of a Scheduler (which includes the thread of a CoroutineHost), because
+        /// it would keep the handlers that it executes from taking messages. In these cases the message is queued and the
+        /// capacity is exceeded. If the result is PushResult::DroppedOldest, dropped receives the discarded message.
+        PushResult Push(std::shared_ptr<Message> message, std::size_t lane = 0, bool mayBlock = true, std::shared_ptr<Message>* dropped = nullptr);
+
+        /// removes the handler of owner like RemoveHandler, but only if it neither processes a message nor has posted tasks and idle returns true
+        /// \details idle is called with the mailbox locked, so that the handler cannot take a message between the check and its
+        /// removal. Returns true if the handler has been removed.
+        bool RemoveHandlerIfIdle(const void* owner, const std::function<bool()>& idle);
+
+        /// runs task on the thread that executes the handler of owner, as soon as the handler finished its current message
+        /// \details Returns false and discards the task if owner has no handler (anymore). Tasks that have not run yet when
+        /// the handler is removed are discarded, too.
+        bool Post(const void* owner, Task task);
+
+        /// limits the number of queued messages to capacity (0 means unbounded) and selects what Push does if it is reached
+        void SetCapacity(std::size_t capacity, Overflow overflow);
+
+        /// wakes up and no longer blocks senders that wait for space, e. g. because the agent is shutting down
+        void Close();
+
+        static bool IsHandling(const void* owner); ///< returns true if the current thread executes the handler of owner
+
+        /// runs task on the current thread as soon as the handler that it executes returned, or immediately if it executes none
+        /// \details Used to destroy the owner of a handler that releases its own agent, which must not be destroyed while its
+        /// handler is running.
+        static void RunAfterHandler(Task task);
+
+        /// hand up to size queued messages whose name is accepted by batched to the handler at once, waiting at most linger for the batch to fill up
+        void           SetBatching(std::size_t size, std::chrono::duration<double> linger, BatchSelection batched);
+        BatchSelection GetBatchSelection(); ///< the selection passed to SetBatching, or an empty function
+
+        /// restricts the threads that are started for handlers from now on to the cores selected by affinity; not applied to Scheduler workers
+        void SetAffinity(std::shared_ptr<CpuAffinity> affinity);
+
+        Mailbox(const Mailbox&)            = delete;
+        Mailbox& operator=(const Mailbox&) = delete;
+
+        static constexpr std::size_t messagesPerTask = 64; ///< after this number of handler calls a Scheduler task yields its worker to other agents
+        static constexpr std::size_t maxLanes        = 16;
+
+    private:
+        void        Remove(std::unique_lock<std::mutex>& lock, const void* owner);
+        void        Schedule(bool defer);
+        void        Process(const void* owner);
+        void        Run(const void* owner, const std::string& threadName);
+        std::size_t Pop(std::vector<std::shared_ptr<Message>>& batch);
+        void        TakeBatch(std::size_t lane, std::vector<std::shared_ptr<Message>>& batch);
+        void        Linger(std::unique_lock<std::mutex>& lock, const void* owner, std::size_t lane, std::vector<std::shared_ptr<Message>>& batch);
+        void        Invoke(const void* owner, const Handler& handler, std::vector<std::shared_ptr<Message>>& batch);
+        void        RunTasksAfterHandler(); ///< runs the tasks passed to RunAfterHandler
+        bool        RunPosted(std::unique_lock<std::mutex>& lock, const void* owner);
+        void        SchedulePosted(const void* owner);
+        void        Released();
+        void        DropOldest();
+
+        Scheduler*                                        _scheduler;
+        const Dequeue                                     _dequeue;
+        std::vector<std::deque<std::shared_ptr<Message>>> _lanes;
+        std::vector<long long>                            _weights;
+        std::vector<long long>                            _credits;
+        std::size_t                                       _queued{0};
+        std::size_t                                       _pushed{0}; ///< number of messages pushed so far, to let Linger detect new messages
+        std::size_t                                       _lingering{0};
+        std::size_t                                       _capacity{0};
+        Overflow                                          _overflow{Overflow::Block};
+        std::size_t                                       _blockedSenders{0};
+        std::size_t                                       _highWaterMark{0};
+        std::size_t                                       _overflowCount{0};
+        bool                                              _closed{false};
+        std::size_t                                       _batchSize{1};
+        std::chrono::duration<double>                     _batchLinger{0};
+        BatchSelection                                    _batched;
+        std::shared_ptr<CpuAffinity>                      _affinity;
+        std::map<const void*, Handler>                    _handlers;
+        std::map<const void*, std::thread>                _threads;
+        std::vector<std::thread>                          _exited; ///< threads of handlers that removed themselves, joined by the destructor
+        std::map<const void*, std::vector<Task>>          _posted; ///< tasks passed to Post, per handler
+        std::vector<const void*>                          _idle;
+        std::set<const void*>                             _busy; ///< handlers that have a Scheduler task or whose thread is not waiting for messages
+        std::mutex                                        _mtx;
+        std::condition_variable                           _cvReleased;
+        std::condition_variable                           _cvQueued;
+        std::condition_variable                           _cvSpace;
+    };
+}
@@ -26,22 +26,40 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
 #include <cbeam/lifecycle/singleton.hpp>
+#include <cbeam/logging/log_manager.hpp>
 
 #include "nexuslua_export.h"
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <mutex>
+#include <thread>
 
 namespace nexuslua
 {
+    /// \brief counts the messages that have been sent, but not yet processed, of all agents
+    /// \details Every send and every handled message updates the counter, so it must not serialize the threads. Each thread
+    /// counts the messages it sent and the messages it processed in one of several shards, each on its own cache line. Both
+    /// counts only increase, and a message is counted as sent before it is counted as processed, as are the messages that
+    /// its handler sent in turn. size reads the processed counts of all shards before the sent counts, so that it may
+    /// include messages that have been processed meanwhile, but never misses one that is still in flight: it only returns 0
+    /// if there has been a moment at which all sent messages had been processed. Only size reads all shards; it is called
+    /// by threads that wait for all messages to be processed, which poll it, so that sending and processing a message
+    /// touch nothing but the shard of the current thread.
     class message_counter
     {
     public:
-        static std::shared_ptr<message_counter> get()
+        static message_counter* get()
         {
-            return cbeam::lifecycle::singleton<message_counter>::get("nexuslua::message_counter");
+            // the singleton is looked up once; the static shared_ptr keeps it alive for the callers of this function
+            static const std::shared_ptr<message_counter> instance = cbeam::lifecycle::singleton<message_counter>::get("nexuslua::message_counter");
+            return instance.get();
         }
 
         inline void wait_until_first()
@@ -56,44 +74,71 @@ namespace nexuslua
 
         inline void wait_until_empty()
         {
-            std::unique_lock<std::mutex> lock(_mtx);
-            if (_size > 0)
+            auto interval = minPollInterval;
+
+            while (size() != 0)
             {
-                _cv.wait(lock, [this]
-                         { return _size == 0; });
+                std::this_thread::sleep_for(interval);
+                interval = std::min(interval * 2, maxPollInterval);
             }
         }
 
         inline int64_t size()
         {
-            return _size;
+            int64_t processed = 0;
+            for (const auto& shard : _shards)
+            {
+                processed += shard.processed.load();
+            }
+
+            int64_t sent = 0;
+            for (const auto& shard : _shards)
+            {
+                sent += shard.sent.load();
+            }
+
+            return sent - processed;
         }
 
         inline void increase()
         {
-            std::lock_guard lock(_mtx);
-            if (++_size == 1)
+            _shards[shard_index()].sent.fetch_add(1);
+
+            if (!_increase_was_called.load(std::memory_order_relaxed))
             {
+                std::lock_guard lock(_mtx);
                 _increase_was_called = true;
                 CBEAM_LOG_DEBUG("message_counter::increase: notifying.");
-                _cv.notify_one();
+                _cv.notify_all();
             }
         }
 
-        inline void decrease()
+        inline void decrease(const int64_t count = 1)
         {
-            std::lock_guard lock(_mtx);
-            if (--_size == 0)
-            {
-                CBEAM_LOG_DEBUG("message_counter::Decrease: notifying.");
-                _cv.notify_one();
-            }
+            _shards[shard_index()].processed.fetch_add(count);
         }
 
     private:
-        std::atomic<bool>       _increase_was_called{false};
-        std::atomic<int64_t>    _size{0};
-        std::mutex              _mtx;
-        std::condition_variable _cv;
+        static constexpr std::size_t               shardCount      = 64;
+        static constexpr std::chrono::microseconds minPollInterval{50};
+        static constexpr std::chrono::microseconds maxPollInterval{1000};
+
+        struct alignas(64) shard
+        {
+            std::atomic<int64_t> sent{0};      ///< messages sent by the threads of this shard
+            std::atomic<int64_t> processed{0}; ///< messages processed or discarded by the threads of this shard
+        };
+
+        static std::size_t shard_index()
+        {
+            static std::atomic<std::size_t> next{0};
+            thread_local const std::size_t  index = next++ % shardCount;
+            return index;
+        }
+
+        std::array<shard, shardCount> _shards;
+        std::atomic<bool>             _increase_was_called{false};
+        std::mutex                    _mtx;
+        std::condition_variable       _cv;
     };
 } // namespace nexuslua
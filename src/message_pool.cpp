@@ -0,0 +1,227 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "message_pool.hpp"
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace nexuslua
+{
+    namespace
+    {
+        constexpr std::size_t magazineSize     = 64; ///< number of blocks that are handed over between a thread and the depot at once
+        constexpr std::size_t maxMagazineCount = 64; ///< the depot frees further magazines, which limits the memory that is kept for bursts
+
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        /// free blocks of a single size, cached per thread and exchanged between threads via a shared depot
+        template <std::size_t Size>
+        class BlockPool
+        {
+        public:
+            static void* Allocate()
+            {
+                Cache& cache = _cache;
+
+                if (!cache.head && !cache.closed)
+                {
+                    cache.Refill();
+                }
+
+                if (FreeBlock* block = cache.head)
+                {
+                    cache.head = block->next;
+                    --cache.count;
+                    return block;
+                }
+
+                return ::operator new(Size);
+            }
+
+            static void Deallocate(void* p)
+            {
+                Cache& cache = _cache;
+
+                if (cache.closed)
+                {
+                    // the thread is exiting and its cache has already been flushed
+                    ::operator delete(p);
+                    return;
+                }
+
+                auto* block = static_cast<FreeBlock*>(p);
+                block->next = cache.head;
+                cache.head  = block;
+
+                if (++cache.count == 2 * magazineSize)
+                {
+                    cache.Flush();
+                }
+            }
+
+        private:
+            struct Depot
+            {
+                std::mutex              mtx;
+                std::vector<FreeBlock*> magazines; ///< each entry is a list of exactly magazineSize blocks
+            };
+
+            struct Cache
+            {
+                FreeBlock*  head{nullptr};
+                std::size_t count{0};
+                bool        closed{false};
+
+                ~Cache()
+                {
+                    while (count >= magazineSize)
+                    {
+                        Flush();
+                    }
+
+                    while (head)
+                    {
+                        FreeBlock* next = head->next;
+                        ::operator delete(head);
+                        head = next;
+                    }
+
+                    count  = 0;
+                    closed = true;
+                }
+
+                void Refill()
+                {
+                    Depot&          depot = GetDepot();
+                    std::lock_guard lock(depot.mtx);
+
+                    if (!depot.magazines.empty())
+                    {
+                        head  = depot.magazines.back();
+                        count = magazineSize;
+                        depot.magazines.pop_back();
+                    }
+                }
+
+                /// moves magazineSize blocks to the depot
+                void Flush()
+                {
+                    FreeBlock* magazine = head;
+                    FreeBlock* last     = head;
+
+                    for (std::size_t i = 1; i < magazineSize; ++i)
+                    {
+                        last = last->next;
+                    }
+
+                    head       = last->next;
+                    last->next = nullptr;
+                    count -= magazineSize;
+
+                    {
+                        Depot&          depot = GetDepot();
+                        std::lock_guard lock(depot.mtx);
+
+                        if (depot.magazines.size() < maxMagazineCount)
+                        {
+                            depot.magazines.push_back(magazine);
+                            return;
+                        }
+                    }
+
+                    while (magazine)
+                    {
+                        FreeBlock* next = magazine->next;
+                        ::operator delete(magazine);
+                        magazine = next;
+                    }
+                }
+            };
+
+            static Depot& GetDepot()
+            {
+                // never destroyed, because messages may still be released during static destruction
+                static Depot* depot = new Depot;
+                return *depot;
+            }
+
+            static thread_local Cache _cache;
+        };
+
+        template <std::size_t Size>
+        thread_local typename BlockPool<Size>::Cache BlockPool<Size>::_cache;
+
+        /// passed to std::allocate_shared, which rebinds it to its internal type that holds the reference count and the Message
+        template <typename T>
+        struct PoolAllocator
+        {
+            using value_type = T;
+
+            static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "nexuslua::MessagePool: over-aligned blocks are not supported");
+
+            PoolAllocator() = default;
+
+            template <typename U>
+            PoolAllocator(const PoolAllocator<U>&) noexcept
+            {
+            }
+
+            T* allocate(const std::size_t n)
+            {
+                return static_cast<T*>(n == 1 ? BlockPool<sizeof(T)>::Allocate() : ::operator new(n * sizeof(T)));
+            }
+
+            void deallocate(T* p, const std::size_t n) noexcept
+            {
+                if (n == 1)
+                {
+                    BlockPool<sizeof(T)>::Deallocate(p);
+                }
+                else
+                {
+                    ::operator delete(p);
+                }
+            }
+
+            template <typename U>
+            bool operator==(const PoolAllocator<U>&) const noexcept
+            {
+                return true;
+            }
+        };
+    }
+
+    std::shared_ptr<Message> MessagePool::Make(const int agentN, const int messageId, const std::string& name, LuaTable&& parameters)
+    {
+        return std::allocate_shared<Message>(PoolAllocator<Message>{}, agentN, messageId, name, std::move(parameters));
+    }
+}
@@ -0,0 +1,46 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "message.hpp"
+
+#include <memory>
+#include <string>
+
+namespace nexuslua
+{
+    /// \brief recycles the memory of messages that are sent via AgentMessage::Send
+    /// \details Each message is constructed in place in a single block that holds both the Message and the reference count of
+    /// its std::shared_ptr. Released blocks are cached by the thread that releases them and handed over to other threads in
+    /// magazines of blocks via a shared depot, so that a steady flow of messages from a sending to a handling thread does not
+    /// allocate memory for the Message itself. The parameters are moved into the message; only a message name that exceeds the
+    /// small string buffer of std::string still allocates.
+    class MessagePool
+    {
+    public:
+        static std::shared_ptr<Message> Make(int agentN, int messageId, const std::string& name, LuaTable&& parameters); ///< constructs a message in a recycled block
+    };
+}
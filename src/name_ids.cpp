@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "name_ids.hpp"
+
+#include <mutex>
+
+namespace nexuslua
+{
+    std::shared_mutex                    NameIds::_mtx;
+    std::unordered_map<std::string, int> NameIds::_ids;
+    std::deque<std::string>              NameIds::_names;
+
+    int NameIds::Intern(const std::string& name)
+    {
+        const int id = Find(name);
+
+        if (id >= 0)
+        {
+            return id;
+        }
+
+        std::unique_lock lock(_mtx);
+        const auto [it, inserted] = _ids.emplace(name, (int)_names.size());
+
+        if (inserted)
+        {
+            _names.push_back(name);
+        }
+
+        return it->second;
+    }
+
+    int NameIds::Find(const std::string& name)
+    {
+        std::shared_lock lock(_mtx);
+        auto             it = _ids.find(name);
+        return it == _ids.end() ? -1 : it->second;
+    }
+
+    const std::string& NameIds::GetName(const int id)
+    {
+        std::shared_lock lock(_mtx);
+        return _names.at((std::size_t)id);
+    }
+}
@@ -0,0 +1,51 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace nexuslua
+{
+    /// \brief interns the names of messages to dense integer IDs
+    /// \details Names are interned when messages are registered via \ref addmessage or agents::AddMessageForCppAgent, so
+    /// that dispatching and batching compare these IDs instead of strings (see Message::message_id). IDs are never reused,
+    /// and the name of an ID stays valid until the process exits.
+    class NameIds
+    {
+    public:
+        static int                Intern(const std::string& name); ///< returns the ID of name, assigning the next free ID if it has not been interned before
+        static int                Find(const std::string& name);   ///< returns the ID of name, or -1 if it has not been interned
+        static const std::string& GetName(int id);                 ///< returns the name of an ID returned by Intern
+
+    private:
+        static std::shared_mutex                    _mtx;
+        static std::unordered_map<std::string, int> _ids;
+        static std::deque<std::string>              _names; ///< indexed by ID; a deque keeps references to its elements valid when growing
+    };
+}
@@ -0,0 +1,156 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "numeric_array.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace nexuslua
+{
+    namespace
+    {
+        /// the string of bytes of a numeric array is at least this long, so that it is never stored in the small string buffer of std::string
+        constexpr std::size_t minimumBytes = sizeof(std::string);
+
+        const cbeam::container::xpod::type typeKey{NumericArray::elementTypeKey}; ///< NumericArray::elementTypeKey as key of LuaTable::data
+    }
+
+    LuaTable NumericArray::Create(const ElementType type, const std::size_t length)
+    {
+        LuaTable table;
+        table.data[typeKey]               = (std::string)GetElementTypeName(type);
+        table.data[(std::string)lengthId] = (long long)length;
+        table.data[(std::string)bytesId]  = std::string(std::max(length * GetElementSize(type), minimumBytes), '\0');
+        return table;
+    }
+
+    LuaTable NumericArray::Create(const ElementType type, const void* elements, const std::size_t length)
+    {
+        LuaTable table = Create(type, length);
+
+        if (length > 0)
+        {
+            std::memcpy(std::get<std::string>(table.data[(std::string)bytesId]).data(), elements, length * GetElementSize(type));
+        }
+
+        return table;
+    }
+
+    bool NumericArray::IsNumericArray(const LuaTableBase& table)
+    {
+        if (table.data.size() != 3 || !table.sub_tables.empty())
+        {
+            return false;
+        }
+
+        auto type   = table.data.find(typeKey);
+        auto length = table.data.find((std::string)lengthId);
+        auto bytes  = table.data.find((std::string)bytesId);
+
+        ElementType elementType;
+        return type != table.data.end() && length != table.data.end() && bytes != table.data.end()
+            && type->second.index() == cbeam::container::xpod::type_index::string
+            && length->second.index() == cbeam::container::xpod::type_index::integer
+            && bytes->second.index() == cbeam::container::xpod::type_index::string
+            && ParseElementTypeName(std::get<std::string>(type->second), elementType)
+            && std::get<long long>(length->second) >= 0
+            && std::get<std::string>(bytes->second).size() >= std::max((std::size_t)std::get<long long>(length->second) * GetElementSize(elementType), minimumBytes);
+    }
+
+    NumericArray::ElementType NumericArray::GetElementType(const LuaTableBase& table)
+    {
+        ElementType type;
+
+        if (!IsNumericArray(table) || !ParseElementTypeName(std::get<std::string>(table.data.at(typeKey)), type))
+        {
+            throw std::runtime_error("nexuslua::NumericArray: table is not a numeric array");
+        }
+
+        return type;
+    }
+
+    std::size_t NumericArray::GetLength(const LuaTableBase& table)
+    {
+        GetElementType(table); // throws if table is not a numeric array
+        return (std::size_t)std::get<long long>(table.data.at((std::string)lengthId));
+    }
+
+    std::size_t NumericArray::GetElementSize(const ElementType type)
+    {
+        switch (type)
+        {
+        case ElementType::Float64:
+            return sizeof(double);
+        case ElementType::Int64:
+            return sizeof(int64_t);
+        case ElementType::UInt8:
+            return sizeof(uint8_t);
+        }
+
+        throw std::runtime_error("nexuslua::NumericArray: unknown element type " + std::to_string((int)type));
+    }
+
+    std::string_view NumericArray::GetElementTypeName(const ElementType type)
+    {
+        switch (type)
+        {
+        case ElementType::Float64:
+            return "float64";
+        case ElementType::Int64:
+            return "int64";
+        case ElementType::UInt8:
+            return "uint8";
+        }
+
+        throw std::runtime_error("nexuslua::NumericArray: unknown element type " + std::to_string((int)type));
+    }
+
+    bool NumericArray::ParseElementTypeName(const std::string_view name, ElementType& type)
+    {
+        for (const ElementType candidate : {ElementType::Float64, ElementType::Int64, ElementType::UInt8})
+        {
+            if (GetElementTypeName(candidate) == name)
+            {
+                type = candidate;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    const void* NumericArray::GetElements(const LuaTableBase& table, const ElementType type, std::size_t& length)
+    {
+        if (!IsNumericArray(table) || GetElementType(table) != type)
+        {
+            return nullptr;
+        }
+
+        length = (std::size_t)std::get<long long>(table.data.at((std::string)lengthId));
+        return std::get<std::string>(table.data.at((std::string)bytesId)).data();
+    }
+}
@@ -0,0 +1,75 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pending_calls.hpp"
+
+namespace nexuslua
+{
+    std::mutex                                              PendingCalls::_mtx;
+    std::unordered_map<long long, PendingCalls::Completion> PendingCalls::_completions;
+    long long                                               PendingCalls::_nextId{0};
+
+    long long PendingCalls::Add(Completion completion)
+    {
+        std::lock_guard lock(_mtx);
+        const long long id = ++_nextId;
+        _completions.emplace(id, std::move(completion));
+        return id;
+    }
+
+    bool PendingCalls::Complete(const long long id, LuaTable reply)
+    {
+        Completion completion;
+        {
+            std::lock_guard lock(_mtx);
+            auto            it = _completions.find(id);
+
+            if (it == _completions.end())
+            {
+                return false;
+            }
+
+            completion = std::move(it->second);
+            _completions.erase(it);
+        }
+
+        // invoked without the lock, because a completion may start further calls or send messages that wait for a full mailbox
+        completion(std::move(reply));
+
+        return true;
+    }
+
+    void PendingCalls::Cancel(const long long id)
+    {
+        std::lock_guard lock(_mtx);
+        _completions.erase(id);
+    }
+
+    std::size_t PendingCalls::GetCount()
+    {
+        std::lock_guard lock(_mtx);
+        return _completions.size();
+    }
+}
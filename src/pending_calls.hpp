@@ -0,0 +1,57 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "lua_table.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace nexuslua
+{
+    /// \brief correlates the replies to messages with the callers that wait for them, see \ref call
+    /// \details A caller registers a completion and stores the returned id in the message via LuaTable::SetReplyToCall.
+    /// The handler of the message passes its return value to Complete instead of sending a reply-to message, so that
+    /// neither the original message nor its parameters are copied back to the caller. Used by \ref call and
+    /// AgentMessage::Call.
+    class PendingCalls
+    {
+    public:
+        using Completion = std::function<void(LuaTable reply)>;
+
+        static long long   Add(Completion completion);             ///< registers completion and returns the id of the call, which is never 0
+        static bool        Complete(long long id, LuaTable reply); ///< removes and invokes the completion of the call on the calling thread; returns false if there is none, e. g. because the call has been cancelled
+        static void        Cancel(long long id);                   ///< removes the completion of the call without invoking it; a concurrent Complete may already have taken it
+        static std::size_t GetCount();                             ///< number of calls that wait for their reply
+
+    private:
+        static std::mutex                                _mtx;
+        static std::unordered_map<long long, Completion> _completions;
+        static long long                                 _nextId;
+    };
+}
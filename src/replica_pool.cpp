@@ -0,0 +1,161 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "replica_pool.hpp"
+
+#include "agent_thread_lua.hpp"
+
+#include <cbeam/concurrency/thread.hpp>
+#include <cbeam/logging/log_manager.hpp>
+
+using namespace std::string_literals;
+
+namespace nexuslua
+{
+    ReplicaPool::ReplicaPool(std::size_t size, Factory factory, const std::string& threadName)
+        : _size{size}
+        , _factory{std::move(factory)}
+        , _threadName{threadName}
+    {
+        _thread = std::thread(&ReplicaPool::Run, this);
+    }
+
+    ReplicaPool::~ReplicaPool()
+    {
+        Stop();
+    }
+
+    std::shared_ptr<AgentThreadLua> ReplicaPool::Take()
+    {
+        std::shared_ptr<AgentThreadLua> replica;
+        {
+            std::lock_guard lock(_mtx);
+            if (!_warm.empty())
+            {
+                replica = _warm.front();
+                _warm.pop_front();
+            }
+            _filling = !_stop;
+        }
+        _cv.notify_one();
+        return replica;
+    }
+
+    void ReplicaPool::Fill()
+    {
+        {
+            std::lock_guard lock(_mtx);
+            _filling = !_stop;
+        }
+        _cv.notify_one();
+    }
+
+    void ReplicaPool::Stop()
+    {
+        {
+            std::lock_guard lock(_mtx);
+            _stop = true;
+        }
+        _cv.notify_one();
+
+        if (_thread.joinable())
+        {
+            _thread.join();
+        }
+
+        std::deque<std::shared_ptr<AgentThreadLua>> warm;
+        {
+            std::lock_guard lock(_mtx);
+            warm.swap(_warm);
+        }
+    }
+
+    std::size_t ReplicaPool::GetWarmCount()
+    {
+        std::lock_guard lock(_mtx);
+        return _warm.size();
+    }
+
+    void ReplicaPool::Run()
+    {
+        if (!_threadName.empty())
+        {
+            cbeam::concurrency::set_thread_name(_threadName.c_str());
+        }
+
+        std::unique_lock lock(_mtx);
+
+        while (true)
+        {
+            _cv.wait(lock, [this]
+                     { return _stop || (_filling && _warm.size() < _size); });
+
+            if (_stop)
+            {
+                break;
+            }
+
+            lock.unlock();
+
+            std::shared_ptr<AgentThreadLua> replica;
+            try
+            {
+                replica = _factory();
+            }
+            catch (const std::exception& ex)
+            {
+                CBEAM_LOG("ReplicaPool: could not prepare replica: "s + ex.what());
+            }
+            catch (...)
+            {
+                CBEAM_LOG("ReplicaPool: could not prepare replica: unknown exception");
+            }
+
+            lock.lock();
+
+            if (!replica)
+            {
+                // do not retry in a loop; the next replica that is taken will trigger another attempt
+                _filling = false;
+                continue;
+            }
+
+            if (_stop)
+            {
+                lock.unlock();
+                replica.reset();
+                lock.lock();
+                break;
+            }
+
+            _warm.push_back(std::move(replica));
+
+            if (_warm.size() >= _size)
+            {
+                _filling = false;
+            }
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace nexuslua
+{
+    class AgentThreadLua;
+
+    /// \brief pool of replicas of a Lua agent that are initialized in the background ahead of demand
+    /// \details Creating a replica means creating a new Lua state, registering the nexuslua functions and running the
+    /// agent's script. The pool does this on its own thread, so that a busy agent only needs to take a prepared replica
+    /// when it replicates (see Configuration::luaReplicaPoolSize). After each replica that is taken, the pool is refilled.
+    class ReplicaPool
+    {
+    public:
+        using Factory = std::function<std::shared_ptr<AgentThreadLua>()>;
+
+        ReplicaPool(std::size_t size, Factory factory, const std::string& threadName = {});
+        virtual ~ReplicaPool();
+
+        std::shared_ptr<AgentThreadLua> Take();          ///< returns a prepared replica or nullptr if none is available yet; starts refilling the pool
+        void                            Fill();          ///< starts creating replicas in the background until the pool is full
+        void                            Stop();          ///< stops the background thread and destroys all prepared replicas
+        std::size_t                     GetWarmCount();  ///< number of replicas that are currently prepared
+
+        ReplicaPool(const ReplicaPool&)            = delete;
+        ReplicaPool& operator=(const ReplicaPool&) = delete;
+
+    private:
+        void Run();
+
+        const std::size_t                           _size;
+        Factory                                     _factory;
+        const std::string                           _threadName;
+        std::deque<std::shared_ptr<AgentThreadLua>> _warm;
+        bool                                        _filling{false};
+        bool                                        _stop{false};
+        std::mutex                                  _mtx;
+        std::condition_variable                     _cv;
+        std::thread                                 _thread;
+    };
+}
@@ -0,0 +1,142 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "replication_policy.hpp"
+
+#include "configuration.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace nexuslua
+{
+    void AgentLoad::MessageQueued()
+    {
+        ++_queued;
+    }
+
+    void AgentLoad::MessageDequeued()
+    {
+        --_queued;
+    }
+
+    std::size_t AgentLoad::GetQueuedMessages() const
+    {
+        return _queued;
+    }
+
+    void AgentLoad::AddHandlingTime(const double seconds)
+    {
+        std::lock_guard lock(_mtx);
+
+        if (_measured)
+        {
+            _averageHandlingTime = smoothing * seconds + (1 - smoothing) * _averageHandlingTime;
+        }
+        else
+        {
+            _averageHandlingTime = seconds;
+            _measured            = true;
+        }
+    }
+
+    double AgentLoad::GetAverageHandlingTime()
+    {
+        std::lock_guard lock(_mtx);
+        return _averageHandlingTime;
+    }
+
+    std::unique_ptr<ReplicationPolicy> ReplicationPolicy::Create(Configuration& configuration)
+    {
+        const std::string policy = configuration.GetInternal<std::string>(Configuration::luaReplicationPolicy);
+
+        if (policy == Configuration::luaReplicationPolicyIdleTime)
+        {
+            return std::make_unique<ReplicationPolicyIdleTime>(configuration);
+        }
+
+        if (policy == Configuration::luaReplicationPolicyQueueDepth)
+        {
+            return std::make_unique<ReplicationPolicyQueueDepth>(configuration);
+        }
+
+        throw std::runtime_error("nexuslua::ReplicationPolicy: unknown value '" + policy + "' of configuration entry '" + std::string(Configuration::luaReplicationPolicy) + "'");
+    }
+
+    void ReplicationPolicy::ReplicasStarted(const std::size_t count)
+    {
+        _replicas += count;
+    }
+
+    void ReplicationPolicy::ReplicasStopped(const std::size_t count)
+    {
+        _replicas -= count;
+    }
+
+    std::size_t ReplicationPolicy::GetReplicaCount()
+    {
+        return _replicas;
+    }
+
+    ReplicationPolicyIdleTime::ReplicationPolicyIdleTime(Configuration& configuration)
+        : _configuration{configuration}
+    {
+    }
+
+    bool ReplicationPolicyIdleTime::Replicate(const ReplicationState& state)
+    {
+        return state.secondsSinceLastMessage <= _configuration.GetInternal<double>(Configuration::luaStartNewThreadTime);
+    }
+
+    ReplicationPolicyQueueDepth::ReplicationPolicyQueueDepth(Configuration& configuration)
+        : _configuration{configuration}
+    {
+    }
+
+    bool ReplicationPolicyQueueDepth::Replicate(const ReplicationState& state)
+    {
+        if (state.queuedMessages == 0)
+        {
+            return false;
+        }
+
+        long long budget = _configuration.GetInternal<long long>(Configuration::luaReplicationCoreBudget);
+        if (budget <= 0)
+        {
+            budget = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        if (GetReplicaCount() >= (std::size_t)budget)
+        {
+            return false;
+        }
+
+        const double expectedWait = state.queuedMessages * state.averageHandlingTime / std::max<std::size_t>(state.instances, 1);
+
+        return expectedWait > _configuration.GetInternal<double>(Configuration::luaReplicationTargetLatency);
+    }
+}
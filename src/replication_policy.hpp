@@ -0,0 +1,109 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+namespace nexuslua
+{
+    class Configuration;
+
+    /// \brief load of an agent, shared by the agent and all of its replicas
+    class AgentLoad
+    {
+    public:
+        void        MessageQueued();                 ///< called by ThreadPool when a message is sent to the agent
+        void        MessageDequeued();               ///< called by the agent when it starts to process a message
+        std::size_t GetQueuedMessages() const;       ///< number of messages that have been sent to the agent, but not yet processed
+        void        AddHandlingTime(double seconds); ///< adds a measured message handling time to the exponentially weighted moving average
+        double      GetAverageHandlingTime();        ///< exponentially weighted moving average of the time in seconds the agent needs to process a message; 0 before the first message has been processed
+
+        static constexpr double smoothing = 0.2; ///< weight of the latest handling time in the moving average
+
+    private:
+        std::atomic<std::size_t> _queued{0};
+        double                   _averageHandlingTime{0};
+        bool                     _measured{false};
+        std::mutex               _mtx;
+    };
+
+    /// \brief what a ReplicationPolicy can base its decision on
+    struct ReplicationState
+    {
+        std::size_t queuedMessages;          ///< messages waiting for the agent, see AgentLoad::GetQueuedMessages
+        std::size_t instances;               ///< number of instances that currently process messages of the agent, i. e. 1 + number of replicas
+        double      secondsSinceLastMessage; ///< time since the instance that decides finished its previous message
+        double      averageHandlingTime;     ///< see AgentLoad::GetAverageHandlingTime
+    };
+
+    /// \brief decides if a busy Lua agent replicates to process a message that requests more `threads`
+    /// \details The policy is selected by Configuration::luaReplicationPolicy. The number of threads requested by the
+    /// message is an upper limit that is checked by the agent independently of the policy.
+    class ReplicationPolicy
+    {
+    public:
+        virtual ~ReplicationPolicy() = default;
+
+        virtual bool Replicate(const ReplicationState& state) = 0; ///< return true if another replica shall be created
+
+        static std::unique_ptr<ReplicationPolicy> Create(Configuration& configuration); ///< creates the policy that is selected by Configuration::luaReplicationPolicy
+
+        static void        ReplicasStarted(std::size_t count = 1); ///< keeps track of the replicas of all agents for Configuration::luaReplicationCoreBudget
+        static void        ReplicasStopped(std::size_t count = 1);
+        static std::size_t GetReplicaCount(); ///< number of replicas of all agents that are currently running
+
+    private:
+        inline static std::atomic<std::size_t> _replicas{0};
+    };
+
+    /// \brief the original heuristic: replicate if the previous message was finished less than Configuration::luaStartNewThreadTime ago
+    class ReplicationPolicyIdleTime : public ReplicationPolicy
+    {
+    public:
+        explicit ReplicationPolicyIdleTime(Configuration& configuration);
+        bool Replicate(const ReplicationState& state) override;
+
+    private:
+        Configuration& _configuration;
+    };
+
+    /// \brief replicate if the queued messages would wait longer than Configuration::luaReplicationTargetLatency
+    /// \details The expected waiting time is estimated from the number of queued messages, the average handling time
+    /// and the number of instances. Replication stops when the replicas of all agents reach
+    /// Configuration::luaReplicationCoreBudget.
+    class ReplicationPolicyQueueDepth : public ReplicationPolicy
+    {
+    public:
+        explicit ReplicationPolicyQueueDepth(Configuration& configuration);
+        bool Replicate(const ReplicationState& state) override;
+
+    private:
+        Configuration& _configuration;
+    };
+}
@@ -0,0 +1,218 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "scheduler.hpp"
+
+#include <cbeam/concurrency/thread.hpp>
+#include <cbeam/logging/log_manager.hpp>
+
+#include <algorithm>
+#include <string>
+
+using namespace std::string_literals;
+
+namespace nexuslua
+{
+    Scheduler::Scheduler(std::size_t workerCount)
+    {
+        if (workerCount == 0)
+        {
+            workerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for (std::size_t i = 0; i < workerCount; ++i)
+        {
+            _workers.emplace_back(std::make_unique<Worker>());
+        }
+
+        for (std::size_t i = 0; i < workerCount; ++i)
+        {
+            _workers[i]->thread = std::thread(&Scheduler::Run, this, i);
+        }
+
+        CBEAM_LOG_DEBUG("Scheduler: started " + std::to_string(workerCount) + " workers");
+    }
+
+    Scheduler::~Scheduler()
+    {
+        {
+            std::lock_guard lock(_mtxIdle);
+            _stop = true;
+        }
+        _cvIdle.notify_all();
+
+        for (auto& worker : _workers)
+        {
+            if (worker->thread.joinable())
+            {
+                worker->thread.join();
+            }
+        }
+
+        CBEAM_LOG_DEBUG("Scheduler: stopped all workers");
+    }
+
+    void Scheduler::Submit(Task task)
+    {
+        Push(std::move(task), false);
+    }
+
+    void Scheduler::Defer(Task task)
+    {
+        Push(std::move(task), true);
+    }
+
+    std::size_t Scheduler::GetWorkerCount() const
+    {
+        return _workers.size();
+    }
+
+    void Scheduler::Push(Task task, bool front)
+    {
+        if (_currentScheduler == this)
+        {
+            Worker&         worker = *_workers[_currentWorker];
+            std::lock_guard lock(worker.mtx);
+            if (front)
+            {
+                worker.tasks.emplace_front(std::move(task));
+            }
+            else
+            {
+                worker.tasks.emplace_back(std::move(task));
+            }
+            ++_pending;
+        }
+        else
+        {
+            std::lock_guard lock(_mtxInjected);
+            _injected.emplace_back(std::move(task));
+            ++_pending;
+        }
+
+        {
+            // taking the lock guarantees that a worker cannot miss this notification between checking _pending and waiting
+            std::lock_guard lock(_mtxIdle);
+        }
+        _cvIdle.notify_one();
+    }
+
+    bool Scheduler::Pop(std::size_t index, Task& task)
+    {
+        Worker&         worker = *_workers[index];
+        std::lock_guard lock(worker.mtx);
+
+        if (worker.tasks.empty())
+        {
+            return false;
+        }
+
+        task = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+        --_pending;
+        return true;
+    }
+
+    bool Scheduler::PopInjected(Task& task)
+    {
+        std::lock_guard lock(_mtxInjected);
+
+        if (_injected.empty())
+        {
+            return false;
+        }
+
+        task = std::move(_injected.front());
+        _injected.pop_front();
+        --_pending;
+        return true;
+    }
+
+    bool Scheduler::Steal(std::size_t index, Task& task)
+    {
+        for (std::size_t offset = 1; offset < _workers.size(); ++offset)
+        {
+            Worker&         victim = *_workers[(index + offset) % _workers.size()];
+            std::lock_guard lock(victim.mtx);
+
+            if (!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                --_pending;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool Scheduler::IsWorkerThread()
+    {
+        return _currentScheduler != nullptr;
+    }
+
+    void Scheduler::Run(std::size_t index)
+    {
+        _currentScheduler = this;
+        _currentWorker    = index;
+
+        const std::string threadName = "S" + std::to_string(index);
+        cbeam::concurrency::set_thread_name(threadName.c_str());
+
+        for (std::size_t tick = 1;; ++tick)
+        {
+            Task task;
+
+            if ((tick % injectInterval == 0 && PopInjected(task)) || Pop(index, task) || PopInjected(task) || Steal(index, task))
+            {
+                try
+                {
+                    task();
+                }
+                catch (const std::exception& ex)
+                {
+                    CBEAM_LOG("Scheduler: exception in worker " + std::to_string(index) + ": "s + ex.what());
+                }
+                catch (...)
+                {
+                    CBEAM_LOG("Scheduler: unknown exception in worker " + std::to_string(index));
+                }
+                continue;
+            }
+
+            std::unique_lock lock(_mtxIdle);
+            _cvIdle.wait(lock, [this]
+                         { return _stop || _pending > 0; });
+
+            if (_stop)
+            {
+                break;
+            }
+        }
+
+        _currentScheduler = nullptr;
+    }
+}
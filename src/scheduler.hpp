@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nexuslua
+{
+    /// \brief fixed pool of worker threads with one task deque per worker and work stealing
+    /// \details Used by ThreadPool for agents that are configured with Configuration::schedulerPool. Tasks that a worker
+    /// submits itself are queued to its own deque, from whose back it takes them (LIFO, the data of such a task is likely
+    /// still in the cache of the worker). Tasks submitted from outside the pool are queued to a shared inject queue in
+    /// FIFO order. A worker takes tasks from its own deque, then from the inject queue, then it steals from the front of
+    /// the deques of the other workers. Every injectInterval tasks, a worker looks at the inject queue first, so that
+    /// external submissions are not starved by workers that keep submitting tasks themselves.
+    class Scheduler
+    {
+    public:
+        using Task = std::function<void()>;
+
+        explicit Scheduler(std::size_t workerCount); ///< 0 means one worker per core
+        virtual ~Scheduler();
+
+        void        Submit(Task task); ///< queue the task; if called by a worker of this pool, it is queued to this worker's own deque, otherwise to the inject queue
+        void        Defer(Task task);  ///< like Submit, but a worker queues the task behind all tasks that are currently pending on its deque
+        std::size_t GetWorkerCount() const;
+
+        static bool IsWorkerThread(); ///< returns true if the current thread is a worker of any Scheduler, e. g. the thread of a CoroutineHost
+
+        static constexpr std::size_t injectInterval = 31; ///< see class description
+
+        Scheduler(const Scheduler&)            = delete;
+        Scheduler& operator=(const Scheduler&) = delete;
+
+    private:
+        struct Worker
+        {
+            std::deque<Task> tasks;
+            std::mutex       mtx;
+            std::thread      thread;
+        };
+
+        void        Run(std::size_t index);
+        void        Push(Task task, bool front);
+        bool        Pop(std::size_t index, Task& task);
+        bool        PopInjected(Task& task);
+        bool        Steal(std::size_t index, Task& task);
+
+        std::vector<std::unique_ptr<Worker>> _workers;
+        std::deque<Task>                     _injected; ///< tasks submitted from outside the pool, in FIFO order
+        std::mutex                           _mtxInjected;
+        std::atomic<std::size_t>             _pending{0};
+        bool                                 _stop{false};
+        std::mutex                           _mtxIdle;
+        std::condition_variable              _cvIdle;
+
+        inline static thread_local Scheduler*  _currentScheduler{nullptr};
+        inline static thread_local std::size_t _currentWorker{0};
+    };
+}
@@ -0,0 +1,500 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "nexuslua/agent.hpp"
+#include "nexuslua/agent_message.hpp"
+#include "nexuslua/agents.hpp"
+#include "nexuslua/configuration.hpp"
+#include "nexuslua/lua_table.hpp"
+#include "nexuslua/message.hpp"
+
+#include <cbeam/platform/runtime.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nexuslua
+{
+    using namespace std::string_literals;
+
+    /// behaviour of Lua and C++ agents that exchange messages
+    class AgentsTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            _agents = std::make_shared<agents>();
+        }
+
+        void TearDown() override
+        {
+            _agents->ShutdownAgents();
+            _agents.reset();
+        }
+
+        /// polls condition for at most 10 seconds and returns its last result
+        static bool WaitFor(const std::function<bool()>& condition)
+        {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+            while (!condition())
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            return true;
+        }
+
+        /// adds a C++ agent that counts the messages named messageName it receives
+        void AddCounter(const std::string& agentName, const std::string& messageName, std::atomic<int>& count)
+        {
+            _agents->Add(agentName, [&count](std::shared_ptr<Message>)
+                         { ++count; });
+            _agents->AddMessageForCppAgent(agentName, messageName);
+        }
+
+        /// returns the path of a (non-existing) Lua script in the directory of the shared library built from test/test_library.cpp,
+        /// so that agents started with it can import its functions
+        static std::filesystem::path ScriptNextToTestLibrary()
+        {
+            return std::filesystem::path(cbeam::platform::get_path_to_runtime_binary()).parent_path() / "nexuslua-test-library" / "script.lua"; // copied by CMakeLists.txt
+        }
+
+        std::shared_ptr<agents> _agents;
+    };
+
+    TEST_F(AgentsTest, WaitUntilMessageQueueIsEmptyWaitsForMessagesSentByHandlers)
+    {
+        constexpr int chainCount = 20;
+
+        _agents->GetConfiguration().SetInternal(Configuration::scheduler, (std::string)Configuration::schedulerPool);
+
+        // each message is passed on by two agents in turn, so that it is always sent by another thread than the one that
+        // processes it
+        const std::string relayCode = R"(
+            function Relay(parameters)
+                if parameters.hops > 0 then
+                    send(parameters.next, "Relay", {hops=parameters.hops - 1, next=parameters.this, this=parameters.next})
+                else
+                    send("collector", "Done", {})
+                end
+            end
+
+            addmessage("Relay")
+        )";
+
+        _agents->Add("ping", "", relayCode);
+        _agents->Add("pong", "", relayCode);
+
+        std::atomic<int> finished{0};
+        AddCounter("collector", "Done", finished);
+
+        const auto& relay = _agents->GetMessage("ping", "Relay");
+
+        for (int i = 0; i < chainCount; ++i)
+        {
+            LuaTable parameters;
+            parameters.data["hops"s] = 200LL;
+            parameters.data["this"s] = "ping"s;
+            parameters.data["next"s] = "pong"s;
+            relay.Send(parameters);
+        }
+
+        _agents->WaitUntilMessageQueueIsEmpty();
+        EXPECT_EQ(finished, chainCount);
+        EXPECT_EQ(agents::TotalSizeOfMessagesQueues(), 0);
+    }
+
+    TEST_F(AgentsTest, MessagesAreRoutedByAgentAndMessageName)
+    {
+        std::atomic<int> first{0};
+        std::atomic<int> second{0};
+        AddCounter("first", "Count", first);
+        AddCounter("second", "Count", second);
+
+        EXPECT_TRUE(_agents->GetMessage("second", "Count").Send(LuaTable()));
+        _agents->AddMessageForCppAgent("second", "Other"); // added after messages of the agent have been looked up
+        EXPECT_TRUE(_agents->GetMessage("second", "Other").Send(LuaTable()));
+        EXPECT_EQ(_agents->GetMessage("first", "Count").GetAgentName(), "first");
+
+        _agents->WaitUntilMessageQueueIsEmpty();
+        EXPECT_EQ(first, 0);
+        EXPECT_EQ(second, 2); // the counter does not look at the message name
+
+        EXPECT_THROW(_agents->GetMessage("first", "Other"), std::runtime_error);
+        EXPECT_THROW(_agents->GetMessage("unknown", "Count"), std::runtime_error);
+    }
+
+    TEST_F(AgentsTest, HandlerThatIsReassignedByTheScriptIsCalled)
+    {
+        // the function of a message is resolved once and then called via a reference, which must follow the global
+        _agents->Add("versioned", "", R"(
+            function Handle(parameters)
+                Handle = function(parameters)
+                    return {version=2}
+                end
+                return {version=1}
+            end
+
+            addmessage("Handle")
+        )");
+
+        const auto& handle = _agents->GetMessage("versioned", "Handle");
+
+        for (const long long version : {1LL, 2LL, 2LL})
+        {
+            auto reply = handle.Call(LuaTable());
+            ASSERT_EQ(reply.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+            EXPECT_EQ(reply.get().get_mapped_value_or_default<long long>("version"s), version);
+        }
+    }
+
+    TEST_F(AgentsTest, LazyParametersKeptByTheHandlerOutliveTheirMessage)
+    {
+        // the handler keeps the view of the parameters and of a sub table, and reads them when the next message arrives
+        _agents->Add("keeper", "", R"(
+            function Keep(parameters)
+                local previous, previousSub = kept, keptSub
+                kept, keptSub = parameters, parameters.sub
+                collectgarbage()
+                return {value = previous and previous.value or 0, subValue = previousSub and previousSub.value or 0}
+            end
+
+            addmessage("Keep", {lazy=true})
+        )");
+
+        std::mutex            mtx;
+        std::vector<LuaTable> replies;
+        _agents->Add("collector", [&](std::shared_ptr<Message> message)
+                     {
+                         std::lock_guard<std::mutex> lock(mtx);
+                         replies.push_back(message->parameters); });
+        _agents->AddMessageForCppAgent("collector", "Reply");
+
+        const auto& keep = _agents->GetMessage("keeper", "Keep");
+
+        for (long long i = 1; i <= 2; ++i)
+        {
+            LuaTable parameters;
+            parameters.data["value"s]                    = i;
+            parameters.sub_tables["sub"s].data["value"s] = 10 * i;
+            parameters.SetReplyTo("collector", "Reply"); // the reply takes the parameters of the message along
+            keep.Send(parameters);
+
+            _agents->WaitUntilMessageQueueIsEmpty(); // the first message has been replied to and released before the second is sent
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        ASSERT_EQ(replies.size(), 2u);
+        EXPECT_EQ(replies[1].get_mapped_value_or_default<long long>("value"s), 1LL);
+        EXPECT_EQ(replies[1].get_mapped_value_or_default<long long>("subValue"s), 10LL);
+        EXPECT_EQ(replies[0].sub_tables.at((std::string)Message::originalMessageTableId).sub_tables.at((std::string)Message::originalMessageParametersId).get_mapped_value_or_default<long long>("value"s), 1LL);
+    }
+
+    TEST_F(AgentsTest, CallReturnsTheReplyOfTheCalledFunction)
+    {
+        _agents->Add("geometry", "", R"(
+            function Size(parameters)
+                if parameters.shape ~= "rectangle" then
+                    error("unknown shape")
+                end
+                return {width=2, height=3}
+            end
+
+            addmessage("Size")
+        )");
+        _agents->Add("area", "", R"(
+            function Area(parameters)
+                local size = call("geometry", "Size", {shape=parameters.shape})
+                if size.error then
+                    return {failed=true}
+                end
+                return {area=size.width * size.height, withoutOriginal=size.original_message == nil}
+            end
+
+            function Missing(parameters)
+                return {failed=call("unknown", "Size", {}).error ~= nil}
+            end
+
+            addmessage("Area")
+            addmessage("Missing")
+        )");
+
+        const auto& area = _agents->GetMessage("area", "Area");
+
+        LuaTable rectangle;
+        rectangle.data["shape"s] = "rectangle"s;
+        auto reply               = area.Call(rectangle);
+        ASSERT_EQ(reply.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        const LuaTable result = reply.get();
+        EXPECT_EQ(result.get_mapped_value_or_default<long long>("area"s), 6LL);
+        EXPECT_TRUE(result.get_mapped_value_or_default<bool>("withoutOriginal"s));
+
+        LuaTable circle;
+        circle.data["shape"s] = "circle"s;
+        auto failed           = area.Call(circle);
+        ASSERT_EQ(failed.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        EXPECT_TRUE(failed.get().get_mapped_value_or_default<bool>("failed"s));
+
+        auto missing = _agents->GetMessage("area", "Missing").Call(LuaTable());
+        ASSERT_EQ(missing.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        EXPECT_TRUE(missing.get().get_mapped_value_or_default<bool>("failed"s));
+    }
+
+    TEST_F(AgentsTest, CallPassesTheReplyToTheCallback)
+    {
+        _agents->Add("adder", "", R"(
+            function Add(parameters)
+                return {sum=parameters.a + parameters.b}
+            end
+
+            addmessage("Add")
+        )");
+
+        LuaTable parameters;
+        parameters.data["a"s] = 2LL;
+        parameters.data["b"s] = 3LL;
+
+        auto promise = std::make_shared<std::promise<LuaTable>>();
+        auto reply   = promise->get_future();
+        ASSERT_TRUE(_agents->GetMessage("adder", "Add").Call(parameters, [promise](LuaTable result)
+                                                             { promise->set_value(std::move(result)); }));
+        ASSERT_EQ(reply.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        EXPECT_EQ(reply.get().get_mapped_value_or_default<long long>("sum"s), 5LL);
+
+        // a C++ agent returns nothing, so the reply is empty once its handler returned
+        std::atomic<int> count{0};
+        AddCounter("counter", "Count", count);
+        auto empty = _agents->GetMessage("counter", "Count").Call(LuaTable());
+        ASSERT_EQ(empty.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        EXPECT_EQ(empty.get(), LuaTable());
+        EXPECT_EQ(count, 1);
+    }
+
+    TEST_F(AgentsTest, CallOfThrowingCppHandlerReturnsError)
+    {
+        std::atomic<int> count{0};
+        _agents->Add("throwing", [&count](std::shared_ptr<Message>)
+                     {
+                         if (++count == 1)
+                         {
+                             throw std::runtime_error("first message fails");
+                         } });
+        _agents->AddMessageForCppAgent("throwing", "Throw");
+
+        const auto& message = _agents->GetMessage("throwing", "Throw");
+
+        auto failed = message.Call(LuaTable());
+        ASSERT_EQ(failed.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        EXPECT_EQ(failed.get().get_mapped_value_or_default<std::string>("error"s), "first message fails");
+
+        auto succeeded = message.Call(LuaTable());
+        ASSERT_EQ(succeeded.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        EXPECT_EQ(succeeded.get(), LuaTable());
+
+        _agents->WaitUntilMessageQueueIsEmpty(); // the failed message was counted as handled
+        EXPECT_EQ(count, 2);
+    }
+
+    TEST_F(AgentsTest, IdleReplicasAreRetiredWithoutLosingMessages)
+    {
+        constexpr int messageCount = 50;
+
+        auto& configuration = _agents->GetConfiguration();
+        configuration.SetInternal(Configuration::luaReplicaIdleTimeout, 0.02);
+        configuration.SetInternal(Configuration::luaStartNewThreadTime, 1.0); // replicate whenever a message arrives while the agent is busy
+
+        // the replicas are suspended in call for longer than the idle timeout, so they must not be retired meanwhile
+        _agents->Add("slow", "", R"(
+            function Sleep(parameters)
+                local finished = os.clock() + 0.05
+                while os.clock() < finished do end
+                return {}
+            end
+
+            addmessage("Sleep")
+        )");
+        _agents->Add("worker", "", R"(
+            function Work(parameters)
+                local reply = call("slow", "Sleep", {})
+                return {failed=reply.error ~= nil}
+            end
+
+            addmessage("Work")
+        )");
+
+        std::atomic<int> replies{0};
+        AddCounter("collector", "Done", replies);
+
+        const auto& work = _agents->GetMessage("worker", "Work");
+
+        for (int i = 0; i < messageCount; ++i)
+        {
+            LuaTable parameters;
+            parameters.data["threads"s] = 4LL;
+            parameters.SetReplyTo("collector", "Done");
+            work.Send(parameters);
+        }
+
+        ASSERT_TRUE(WaitFor([&]()
+                            { return replies == messageCount; }));
+        EXPECT_TRUE(WaitFor([&]()
+                            { return _agents->GetAgent("worker")->GetReplicaCount() == 0; }));
+    }
+
+    TEST_F(AgentsTest, CallOfDroppedMessageReturnsError)
+    {
+        auto& configuration = _agents->GetConfiguration();
+        configuration.SetInternal(Configuration::mailboxCapacity, 1LL);
+        configuration.SetInternal(Configuration::mailboxOverflow, (std::string)Configuration::mailboxOverflowDropOldest);
+
+        _agents->Add("slow", "", R"(
+            function Sleep(parameters)
+                local finished = os.clock() + 0.2
+                while os.clock() < finished do end
+                return {slept=true}
+            end
+
+            addmessage("Sleep")
+        )");
+
+        const auto& sleep = _agents->GetMessage("slow", "Sleep");
+
+        ASSERT_TRUE(sleep.Send(LuaTable()));
+        ASSERT_TRUE(WaitFor([&]()
+                            { return _agents->GetQueueDepths("slow")[0] == 0; })); // the agent sleeps
+
+        auto dropped = sleep.Call(LuaTable());
+        auto queued  = sleep.Call(LuaTable()); // discards the previous call
+
+        ASSERT_EQ(dropped.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        EXPECT_FALSE(dropped.get().get_mapped_value_or_default<std::string>("error"s).empty());
+
+        ASSERT_EQ(queued.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        EXPECT_TRUE(queued.get().get_mapped_value_or_default<bool>("slept"s));
+        EXPECT_EQ(_agents->GetQueueOverflowCount("slow"), 1u);
+    }
+
+    TEST_F(AgentsTest, CoroutineAgentsImportIntoTheirOwnGlobals)
+    {
+        auto& configuration = _agents->GetConfiguration();
+        configuration.SetInternal(Configuration::scheduler, (std::string)Configuration::schedulerCoroutines);
+        configuration.SetInternal(Configuration::schedulerHosts, 1LL); // all agents share the Lua state of one host
+
+        // both agents import the same function, with a differently written signature, so they must not share their imports
+        _agents->Add("importer", ScriptNextToTestLibrary(), R"lua(
+            function Add(parameters)
+                import("nexuslua_test_library", "nexuslua_test_add", "long long(long long, long long)")
+                return {sum=nexuslua_test_add(parameters.a, parameters.b)}
+            end
+
+            addmessage("Add")
+        )lua");
+        _agents->Add("twin", ScriptNextToTestLibrary(), R"lua(
+            function Add(parameters)
+                local wasImported = nexuslua_test_add ~= nil
+                import("nexuslua_test_library", "nexuslua_test_add", "long long(long long,long long)")
+                return {sum=nexuslua_test_add(parameters.a, parameters.b), wasImported=wasImported}
+            end
+
+            addmessage("Add")
+        )lua");
+        _agents->Add("other", "", R"(
+            function Check(parameters)
+                return {unknown=nexuslua_test_add == nil}
+            end
+
+            addmessage("Check")
+        )");
+
+        LuaTable parameters;
+        parameters.data["a"s] = 2LL;
+        parameters.data["b"s] = 3LL;
+
+        const auto& add = _agents->GetMessage("importer", "Add");
+
+        for (int i = 0; i < 2; ++i) // the second import of the function is taken from the imports of the agent
+        {
+            auto sum = add.Call(parameters);
+            ASSERT_EQ(sum.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+            EXPECT_EQ(sum.get().get_mapped_value_or_default<long long>("sum"s), 5LL);
+        }
+
+        auto twin = _agents->GetMessage("twin", "Add").Call(parameters);
+        ASSERT_EQ(twin.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        const LuaTable twinResult = twin.get();
+        EXPECT_EQ(twinResult.get_mapped_value_or_default<long long>("sum"s), 5LL);
+        EXPECT_FALSE(twinResult.get_mapped_value_or_default<bool>("wasImported"s));
+
+        auto other = _agents->GetMessage("other", "Check").Call(LuaTable());
+        ASSERT_EQ(other.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        EXPECT_TRUE(other.get().get_mapped_value_or_default<bool>("unknown"s));
+    }
+
+    TEST_F(AgentsTest, CoroutineAgentRepliesWithErrorIfAFunctionThrows)
+    {
+        auto& configuration = _agents->GetConfiguration();
+        configuration.SetInternal(Configuration::scheduler, (std::string)Configuration::schedulerCoroutines);
+
+        _agents->Add("failing", "", R"(
+            function Fail(parameters)
+                env() -- throws a C++ exception, which Lua cannot catch
+                return {failed=false}
+            end
+
+            function Succeed(parameters)
+                return {succeeded=true}
+            end
+
+            addmessage("Fail")
+            addmessage("Succeed")
+        )");
+
+        auto failed = _agents->GetMessage("failing", "Fail").Call(LuaTable());
+        ASSERT_EQ(failed.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        EXPECT_FALSE(failed.get().get_mapped_value_or_default<std::string>("error"s).empty());
+
+        auto succeeded = _agents->GetMessage("failing", "Succeed").Call(LuaTable());
+        ASSERT_EQ(succeeded.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        EXPECT_TRUE(succeeded.get().get_mapped_value_or_default<bool>("succeeded"s));
+
+        _agents->WaitUntilMessageQueueIsEmpty(); // the failed message was counted as handled
+    }
+}
@@ -40,6 +40,56 @@ namespace nexuslua
         EXPECT_EQ(luaStartNewThreadTime, 0.01);
     }
 
+    TEST(ConfigurationTest, testScheduler)
+    {
+        Configuration configuration;
+        EXPECT_EQ(configuration.GetInternal<std::string>(Configuration::scheduler), Configuration::schedulerThreads);
+        EXPECT_EQ(configuration.GetInternal<long long>(Configuration::schedulerWorkers), 0);
+        EXPECT_EQ(configuration.GetInternal<long long>(Configuration::schedulerHosts), 0);
+
+        configuration.SetInternal(Configuration::scheduler, (std::string)Configuration::schedulerPool);
+        EXPECT_EQ(configuration.GetInternal<std::string>(Configuration::scheduler), Configuration::schedulerPool);
+    }
+
+    TEST(ConfigurationTest, testMailbox)
+    {
+        Configuration configuration;
+        EXPECT_EQ(configuration.GetInternal<long long>(Configuration::mailboxLanes), 4);
+        EXPECT_EQ(configuration.GetInternal<std::string>(Configuration::mailboxDequeue), Configuration::mailboxDequeueStrict);
+        EXPECT_EQ(configuration.GetInternal<long long>(Configuration::mailboxCapacity), 0);
+        EXPECT_EQ(configuration.GetInternal<std::string>(Configuration::mailboxOverflow), Configuration::mailboxOverflowBlock);
+    }
+
+    TEST(ConfigurationTest, testMessageBatching)
+    {
+        Configuration configuration;
+        EXPECT_EQ(configuration.GetInternal<long long>(Configuration::messageBatchSize), 64);
+        EXPECT_EQ(configuration.GetInternal<double>(Configuration::messageBatchLinger), 0.0);
+    }
+
+    TEST(ConfigurationTest, testReplicaPool)
+    {
+        Configuration configuration;
+        EXPECT_EQ(configuration.GetInternal<long long>(Configuration::luaReplicaPoolSize), 0);
+        EXPECT_EQ(configuration.GetInternal<std::string>(Configuration::luaReplicaWarmup), Configuration::luaReplicaWarmupEager);
+        EXPECT_EQ(configuration.GetInternal<double>(Configuration::luaReplicaIdleTimeout), 0.0);
+    }
+
+    TEST(ConfigurationTest, testReplicationPolicy)
+    {
+        Configuration configuration;
+        EXPECT_EQ(configuration.GetInternal<std::string>(Configuration::luaReplicationPolicy), Configuration::luaReplicationPolicyIdleTime);
+        EXPECT_EQ(configuration.GetInternal<double>(Configuration::luaReplicationTargetLatency), 0.01);
+        EXPECT_EQ(configuration.GetInternal<long long>(Configuration::luaReplicationCoreBudget), 0);
+    }
+
+    TEST(ConfigurationTest, testCpuAffinity)
+    {
+        Configuration configuration;
+        EXPECT_EQ(configuration.GetInternal<std::string>(Configuration::cpuAffinity), Configuration::cpuAffinityNone);
+        EXPECT_EQ(configuration.GetInternal<std::string>(Configuration::cpuAffinityCores), "");
+    }
+
     TEST(ConfigurationTest, testUserConfig)
     {
         Configuration     configuration;
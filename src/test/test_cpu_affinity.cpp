@@ -0,0 +1,126 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "cpu_affinity.hpp"
+
+#include "nexuslua/configuration.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nexuslua
+{
+    using namespace std::string_literals;
+
+    using Cores = std::vector<std::size_t>;
+
+    TEST(CpuAffinityTest, ParseCoresAcceptsIndicesAndRanges)
+    {
+        EXPECT_EQ(CpuAffinity::ParseCores("", 8), Cores{});
+        EXPECT_EQ(CpuAffinity::ParseCores("6", 8), (Cores{6}));
+        EXPECT_EQ(CpuAffinity::ParseCores("0-3,6", 8), (Cores{0, 1, 2, 3, 6}));
+        EXPECT_EQ(CpuAffinity::ParseCores(" 5 , 1 - 2 ,", 8), (Cores{1, 2, 5})); // sorted, spaces and empty entries are ignored
+        EXPECT_EQ(CpuAffinity::ParseCores("2-4,3,4-4,2", 8), (Cores{2, 3, 4}));  // duplicates are removed
+        EXPECT_EQ(CpuAffinity::ParseCores("7", 8), (Cores{7}));
+    }
+
+    TEST(CpuAffinityTest, ParseCoresRejectsInvalidInput)
+    {
+        for (const char* cores : {"a", "1a", "-1", "1-", "1-2-3", "1;2", "0x1"})
+        {
+            EXPECT_THROW(CpuAffinity::ParseCores(cores, 8), std::runtime_error) << cores;
+        }
+
+        EXPECT_THROW(CpuAffinity::ParseCores("8", 8), std::runtime_error);   // beyond the cores of the system
+        EXPECT_THROW(CpuAffinity::ParseCores("6-9", 8), std::runtime_error); // partly beyond
+        EXPECT_THROW(CpuAffinity::ParseCores("3-1", 8), std::runtime_error); // descending
+    }
+
+    TEST(CpuAffinityTest, CreateRejectsInvalidConfiguration)
+    {
+        Configuration configuration;
+        configuration.SetInternal(Configuration::cpuAffinity, "unknown"s);
+        EXPECT_THROW(CpuAffinity::Create(configuration), std::runtime_error);
+
+        configuration.SetInternal(Configuration::cpuAffinity, (std::string)Configuration::cpuAffinityIsolate);
+        configuration.SetInternal(Configuration::cpuAffinityCores, ""s);
+        EXPECT_THROW(CpuAffinity::Create(configuration), std::runtime_error); // isolate needs explicit cores
+
+        configuration.SetInternal(Configuration::cpuAffinity, (std::string)Configuration::cpuAffinityPin);
+        configuration.SetInternal(Configuration::cpuAffinityCores, "0"s);
+        EXPECT_EQ(CpuAffinity::Create(configuration)->GetPolicy(), CpuAffinity::Policy::Pin);
+    }
+
+    TEST(CpuAffinityTest, PinAndNoneSelectTheSameCoresForEachThread)
+    {
+        CpuAffinity none(CpuAffinity::Policy::None, {});
+        CpuAffinity pin(CpuAffinity::Policy::Pin, {1, 3});
+
+        for (int thread = 0; thread < 3; ++thread)
+        {
+            EXPECT_EQ(none.SelectCoresOfNextThread(), Cores{}); // left to the operating system
+            EXPECT_EQ(pin.SelectCoresOfNextThread(), (Cores{1, 3}));
+        }
+    }
+
+    TEST(CpuAffinityTest, SpreadSelectsOneCorePerThreadInTurn)
+    {
+        CpuAffinity spread(CpuAffinity::Policy::Spread, {2, 5, 7});
+
+        Cores selected;
+        for (int thread = 0; thread < 4; ++thread)
+        {
+            const Cores cores = spread.SelectCoresOfNextThread();
+            ASSERT_EQ(cores.size(), 1u);
+            selected.push_back(cores.front());
+        }
+
+        EXPECT_EQ(selected, (Cores{2, 5, 7, 2}));
+    }
+
+    TEST(CpuAffinityTest, IsolatedCoresAreAvoidedByOtherAgents)
+    {
+        CpuAffinity pin(CpuAffinity::Policy::Pin, {0, 1, 2});
+        CpuAffinity spread(CpuAffinity::Policy::Spread, {1, 2, 3});
+        {
+            CpuAffinity isolate(CpuAffinity::Policy::Isolate, {1, 2});
+            EXPECT_EQ(isolate.SelectCoresOfNextThread(), (Cores{1, 2}));
+
+            EXPECT_EQ(pin.SelectCoresOfNextThread(), (Cores{0}));
+            EXPECT_EQ(spread.SelectCoresOfNextThread(), (Cores{3}));
+            EXPECT_EQ(spread.SelectCoresOfNextThread(), (Cores{3}));
+
+            // if all cores of an agent are isolated, the isolation is ignored rather than leaving it without a core
+            CpuAffinity isolated(CpuAffinity::Policy::Pin, {1, 2});
+            EXPECT_EQ(isolated.SelectCoresOfNextThread(), (Cores{1, 2}));
+        }
+
+        // the cores are released when the isolating agent is destroyed
+        EXPECT_EQ(pin.SelectCoresOfNextThread(), (Cores{0, 1, 2}));
+    }
+}
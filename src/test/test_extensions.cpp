@@ -25,18 +25,65 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 
 #include <gtest/gtest.h>
 
+#include "nexuslua/agent_message.hpp"
+#include "nexuslua/agents.hpp"
 #include "nexuslua/description.hpp"
+#include "nexuslua/lua_table.hpp"
+#include "nexuslua/numeric_array.hpp"
 #include "nexuslua/utility.hpp"
 
+#include "generic_dll_call.hpp"
+
 #include <cbeam/filesystem/io.hpp>
 #include <cbeam/filesystem/path.hpp>
 #include <cbeam/logging/log_manager.hpp>
 #include <cbeam/platform/runtime.hpp>
 
+#include <chrono>
 #include <filesystem>
+#include <future>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
 
 namespace nexuslua
 {
+    using namespace std::string_literals;
+
+    /// functions of the shared library built from test/test_library.cpp, imported by Lua agents
+    class ImportTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            _agents = std::make_shared<agents>();
+        }
+
+        void TearDown() override
+        {
+            _agents->ShutdownAgents();
+            _agents.reset();
+        }
+
+        /// adds an agent with the given code, located next to the test library so that `import` finds it
+        void AddAgent(const std::string& agentName, const std::string& code)
+        {
+            const auto script = std::filesystem::path(cbeam::platform::get_path_to_runtime_binary()).parent_path() / "nexuslua-test-library" / "script.lua"; // copied by CMakeLists.txt
+            _agents->Add(agentName, script, code);
+        }
+
+        /// calls the message of the agent and returns its reply
+        LuaTable Call(const std::string& agentName, const std::string& messageName, const LuaTable& parameters = {})
+        {
+            auto reply = _agents->GetMessage(agentName, messageName).Call(parameters);
+            EXPECT_EQ(reply.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+            return reply.get();
+        }
+
+        std::shared_ptr<agents> _agents;
+    };
+
     TEST(nexusluaTest, unzip)
     {
         const std::filesystem::path binary_dir = std::filesystem::path(cbeam::platform::get_path_to_runtime_binary()).parent_path();
@@ -57,4 +104,96 @@ namespace nexuslua
         EXPECT_EQ(cbeam::filesystem::read_file(input_dir / "test" / "test.txt"), cbeam::filesystem::read_file(output_dir / "test2" / "test.txt"));
         EXPECT_EQ(cbeam::filesystem::read_file(input_dir / "test" / "subfolder" / "test2.txt"), cbeam::filesystem::read_file(output_dir / "test2" / "subfolder" / "test2.txt"));
     }
+
+    TEST_F(ImportTest, FunctionsImportedByTheScriptAreKeptForAllMessages)
+    {
+        AddAgent("importer", R"lua(
+            import("nexuslua_test_library", "nexuslua_test_add", "long long(long long,long long)")
+
+            function Add(parameters)
+                return {sum=nexuslua_test_add(parameters.a, parameters.b)}
+            end
+
+            addmessage("Add")
+        )lua");
+
+        for (long long i = 0; i < 3; ++i)
+        {
+            LuaTable parameters;
+            parameters.data["a"s] = i;
+            parameters.data["b"s] = 10LL;
+            EXPECT_EQ(Call("importer", "Add", parameters).get_mapped_value_or_default<long long>("sum"s), i + 10);
+        }
+    }
+
+    TEST_F(ImportTest, ImportedFunctionCanBeCalledUnderAnotherName)
+    {
+        // the function is bound to its closure and does not depend on the name it is called by
+        AddAgent("importer", R"lua(
+            import("nexuslua_test_library", "nexuslua_test_add", "long long(long long,long long)")
+            local add = nexuslua_test_add
+            nexuslua_test_add = nil
+            local functions = {sum=add}
+
+            function Add(parameters)
+                return {local_name=add(1, 2), field=functions.sum(3, 4), removed=nexuslua_test_add == nil}
+            end
+
+            addmessage("Add")
+        )lua");
+
+        const LuaTable result = Call("importer", "Add");
+        EXPECT_EQ(result.get_mapped_value_or_default<long long>("local_name"s), 3LL);
+        EXPECT_EQ(result.get_mapped_value_or_default<long long>("field"s), 7LL);
+        EXPECT_TRUE(result.get_mapped_value_or_default<bool>("removed"s));
+    }
+
+#ifdef NEXUSLUA_GENERIC_DLL_CALL
+    TEST_F(ImportTest, FunctionWithoutGeneratedSignatureIsImported)
+    {
+        AddAgent("importer", R"lua(
+            import("nexuslua_test_library", "nexuslua_test_mixed", "double(double, long long, const char*, double)")
+
+            function Mixed(parameters)
+                return {result=nexuslua_test_mixed(1.5, 4, "abc", 0.5)}
+            end
+
+            addmessage("Mixed")
+        )lua");
+
+        EXPECT_DOUBLE_EQ(Call("importer", "Mixed").get_mapped_value_or_default<double>("result"s), 1.5 * 4 + 3 - 0.5);
+    }
+#endif
+
+    TEST_F(ImportTest, TableViewOfLazyParametersIsPassedToFunction)
+    {
+        // the lazy parameters are passed to the function in place, and the numeric array it returns is passed on to the reply
+        AddAgent("importer", R"lua(
+            import("nexuslua_test_library", "nexuslua_test_scale", "void(table_view, table_builder)")
+
+            function Scale(parameters)
+                return nexuslua_test_scale(parameters)
+            end
+
+            function ScaleNewArray(parameters)
+                local result = nexuslua_test_scale({factor=3.0, values=newarray("float64", {1, 2, 3})})
+                return {sum=result.values:sum()}
+            end
+
+            addmessage("Scale", {lazy=true})
+            addmessage("ScaleNewArray")
+        )lua");
+
+        const std::vector<double> values{1.0, 2.0, 3.0};
+
+        LuaTable parameters;
+        parameters.data["factor"s]       = 2.0;
+        parameters.sub_tables["values"s] = NumericArray::Create(std::span<const double>(values));
+
+        const LuaTable result   = Call("importer", "Scale", parameters);
+        const auto     elements = NumericArray::Get<double>(result.sub_tables.at("values"s));
+        EXPECT_EQ(std::vector<double>(elements.begin(), elements.end()), (std::vector<double>{2.0, 4.0, 6.0}));
+
+        EXPECT_DOUBLE_EQ(Call("importer", "ScaleNewArray").get_mapped_value_or_default<double>("sum"s), 18.0);
+    }
 }
@@ -0,0 +1,69 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// A shared library whose functions are imported by the tests, see function `import` and table_view.h
+
+#include "nexuslua/table_view.h"
+
+#include <cstring>
+
+#if defined(_WIN32)
+    #define NEXUSLUA_TEST_EXPORT extern "C" __declspec(dllexport)
+#else
+    #define NEXUSLUA_TEST_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+NEXUSLUA_TEST_EXPORT long long nexuslua_test_add(long long a, long long b)
+{
+    return a + b;
+}
+
+/// its parameters are not in the order supported by the generated calls, so it is called by GenericDllCall
+NEXUSLUA_TEST_EXPORT double nexuslua_test_mixed(double a, long long b, const char* c, double d)
+{
+    return a * (double)b + (double)std::strlen(c) - d;
+}
+
+/// returns {values = parameters.values * parameters.factor} for a float64 array `values`
+NEXUSLUA_TEST_EXPORT void nexuslua_test_scale(const nexuslua_table_view* parameters, const nexuslua_table_builder* result)
+{
+    const nexuslua_value factorKey = nexuslua_string_value("factor");
+    const nexuslua_value valuesKey = nexuslua_string_value("values");
+    nexuslua_value       factor;
+    nexuslua_value       values;
+
+    if (!parameters->api->get(parameters, &factorKey, &factor) || !parameters->api->get(parameters, &valuesKey, &values) || values.type != NEXUSLUA_ARRAY)
+    {
+        return;
+    }
+
+    const double* in  = static_cast<const double*>(values.as.array.data);
+    double*       out = static_cast<double*>(result->api->add_array(result, &valuesKey, NEXUSLUA_FLOAT64, values.as.array.length));
+
+    for (size_t i = 0; i < values.as.array.length; ++i)
+    {
+        out[i] = in[i] * factor.as.number;
+    }
+}
@@ -27,10 +27,89 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 
 #include <cbeam/container/xpod.hpp>
 
-#include "lua.h"
+#include "nexuslua/numeric_array.hpp"
+#include "nexuslua/table_view.h"
+
+#include "generic_dll_call.hpp"
+#include "lua.hpp"
+#include "lua_find_signature.hpp"
+
+extern "C"
+{
+#include "lauxlib.h"
+#include "lualib.h"
+}
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+    long long nexuslua_lua_test_add(long long a, double b)
+    {
+        return a + (long long)b;
+    }
+
+    double nexuslua_lua_test_mixed(double a, long long b, const char* c, double d)
+    {
+        return a * (double)b + (double)std::strlen(c) - d;
+    }
+
+    /// returns {values = parameters.values * parameters.factor} for a float64 array
+    void nexuslua_lua_test_scale(const nexuslua_table_view* parameters, const nexuslua_table_builder* result)
+    {
+        const nexuslua_value factorKey = nexuslua_string_value("factor");
+        const nexuslua_value valuesKey = nexuslua_string_value("values");
+        nexuslua_value       factor;
+        nexuslua_value       values;
+
+        if (!parameters->api->get(parameters, &factorKey, &factor) || !parameters->api->get(parameters, &valuesKey, &values) || values.type != NEXUSLUA_ARRAY)
+        {
+            return;
+        }
+
+        const double* in  = static_cast<const double*>(values.as.array.data);
+        double*       out = static_cast<double*>(result->api->add_array(result, &valuesKey, NEXUSLUA_FLOAT64, values.as.array.length));
+
+        for (size_t i = 0; i < values.as.array.length; ++i)
+        {
+            out[i] = in[i] * factor.as.number;
+        }
+    }
+}
 
 namespace nexuslua
 {
+    using namespace std::string_literals;
+
+    /// a Lua state with the standard libraries
+    class LuaTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            _L = luaL_newstate();
+            luaL_openlibs(_L);
+        }
+
+        void TearDown() override
+        {
+            lua_close(_L);
+        }
+
+        /// runs code and leaves its first result on the stack
+        void Run(const char* code)
+        {
+            ASSERT_EQ(luaL_loadstring(_L, code), LUA_OK);
+            ASSERT_EQ(lua_pcall(_L, 0, 1, 0), LUA_OK) << lua_tostring(_L, -1);
+        }
+
+        lua_State* _L{nullptr};
+    };
+
     TEST(NexusLuaCoreValueTest, TypeCheck)
     {
         cbeam::container::xpod::type test;
@@ -44,4 +123,208 @@ namespace nexuslua
         EXPECT_TRUE((std::is_same<ValueType, lua_Number>::value))
             << "The type type_index::number of cbeam::value does not match lua_Number.";
     }
+
+    TEST(NumericArrayTest, ElementsOfShortArraysAreAligned)
+    {
+        // the elements of short arrays must not be stored in the small string buffer of std::string, neither in copies
+        for (std::size_t length = 0; length <= 4; ++length)
+        {
+            std::vector<double> values(length);
+            for (std::size_t i = 0; i < length; ++i)
+            {
+                values[i] = 0.5 + (double)i;
+            }
+
+            const LuaTable array = NumericArray::Create(std::span<const double>(values));
+            const LuaTable copy  = array;
+
+            for (const LuaTable* table : {&array, &copy})
+            {
+                const auto elements = NumericArray::Get<double>(*table);
+                ASSERT_EQ(elements.size(), length);
+                EXPECT_EQ(reinterpret_cast<std::uintptr_t>(elements.data()) % alignof(double), 0u);
+                EXPECT_EQ(std::vector<double>(elements.begin(), elements.end()), values);
+            }
+
+            EXPECT_EQ(NumericArray::GetLength(copy), length);
+            EXPECT_TRUE(NumericArray::Get<int64_t>(copy).empty()); // other element type
+        }
+    }
+
+    TEST_F(LuaTest, NumericArraysKeepTheirElementsThroughLua)
+    {
+        const std::vector<int64_t> values{3, -1, 4};
+
+        LuaTable parameters;
+        parameters.sub_tables["values"s] = NumericArray::Create(std::span<const int64_t>(values));
+        lua_pushtable(_L, parameters);
+        lua_setglobal(_L, "parameters");
+
+        Run("return {isArray = type(parameters.values) == 'userdata', sum = parameters.values:sum(), values = parameters.values}");
+        const LuaTable result = lua_totable(_L, -1);
+
+        EXPECT_TRUE(result.get_mapped_value_or_default<bool>("isArray"s));
+        EXPECT_EQ(result.get_mapped_value_or_default<long long>("sum"s), 6LL);
+        const auto elements = NumericArray::Get<int64_t>(result.sub_tables.at("values"s));
+        EXPECT_EQ(std::vector<int64_t>(elements.begin(), elements.end()), values);
+    }
+
+    TEST_F(LuaTest, TableWithTheEntriesOfANumericArrayStaysATable)
+    {
+        // a script cannot create the key of the element type, because boolean keys are converted to strings
+        Run("return {values = {[true] = 'float64', length = 1, bytes = string.rep('x', 32)}}");
+        const LuaTable result = lua_totable(_L, -1);
+        const auto&    values = result.sub_tables.at("values"s);
+
+        EXPECT_FALSE(NumericArray::IsNumericArray(values));
+
+        lua_pushtable(_L, result);
+        lua_getfield(_L, -1, "values");
+        EXPECT_TRUE(lua_istable(_L, -1));
+        EXPECT_FALSE(lua_isnumericarray(_L, -1));
+    }
+
+    TEST_F(LuaTest, IntegerKeysSurviveTheRoundTrip)
+    {
+        Run("return {10, 20, 30, [5] = 50, name = 'x', nested = {{1}, {2}}}");
+        const LuaTable table = lua_totable(_L, -1);
+
+        EXPECT_EQ(table.get_mapped_value_or_default<long long>(1LL), 10LL);
+        EXPECT_EQ(table.get_mapped_value_or_default<long long>(5LL), 50LL);
+        EXPECT_EQ(table.get_mapped_value_or_default<std::string>("name"s), "x");
+        EXPECT_EQ(table.sub_tables.at("nested"s).sub_tables.at(2LL).get_mapped_value_or_default<long long>(1LL), 2LL);
+
+        lua_pushtable(_L, table);
+        lua_setglobal(_L, "t");
+
+        Run(R"(
+            local count, sum = 0, 0
+            for _, value in ipairs(t) do
+                count, sum = count + 1, sum + value
+            end
+            return {count = count, sum = sum, fifth = t[5], nested = #t.nested, second = t.nested[2][1]}
+        )");
+        const LuaTable result = lua_totable(_L, -1);
+
+        EXPECT_EQ(result.get_mapped_value_or_default<long long>("count"s), 3LL);
+        EXPECT_EQ(result.get_mapped_value_or_default<long long>("sum"s), 60LL);
+        EXPECT_EQ(result.get_mapped_value_or_default<long long>("fifth"s), 50LL);
+        EXPECT_EQ(result.get_mapped_value_or_default<long long>("nested"s), 2LL);
+        EXPECT_EQ(result.get_mapped_value_or_default<long long>("second"s), 2LL);
+    }
+
+    TEST_F(LuaTest, TableProxyCanBeReadLikeATable)
+    {
+        auto table                                = std::make_shared<LuaTable>();
+        table->data[1LL]                          = 3LL;
+        table->data[2LL]                          = 4LL;
+        table->data["name"s]                      = "x"s;
+        table->sub_tables["sub"s].data["value"s] = 5LL;
+
+        lua_pushtableproxy(_L, table);
+        ASSERT_NE(lua_totableproxy(_L, -1), nullptr);
+        EXPECT_EQ(lua_totable(_L, -1), *table);
+        lua_setglobal(_L, "p");
+
+        const LuaTable expected = *table;
+        table.reset(); // the proxy shares the ownership of the table
+
+        Run(R"(
+            local sum, keys = 0, 0
+            for _, value in ipairs(p) do
+                sum = sum + value
+            end
+            for _ in pairs(p) do
+                keys = keys + 1
+            end
+            return {name = p.name, length = #p, sum = sum, keys = keys, value = p.sub.value, missing = p.missing == nil}
+        )");
+        const LuaTable result = lua_totable(_L, -1);
+
+        EXPECT_EQ(result.get_mapped_value_or_default<std::string>("name"s), "x");
+        EXPECT_EQ(result.get_mapped_value_or_default<long long>("length"s), 2LL);
+        EXPECT_EQ(result.get_mapped_value_or_default<long long>("sum"s), 7LL);
+        EXPECT_EQ(result.get_mapped_value_or_default<long long>("keys"s), 4LL);
+        EXPECT_EQ(result.get_mapped_value_or_default<long long>("value"s), 5LL);
+        EXPECT_TRUE(result.get_mapped_value_or_default<bool>("missing"s));
+
+        lua_getglobal(_L, "p");
+        EXPECT_EQ(lua_totable(_L, -1), expected);
+    }
+
+    TEST(FindCallDllFunctionTest, FindsGeneratedSignaturesOnly)
+    {
+        // the perfect hash maps every generated signature to its slot, but other strings must not match any of them
+        EXPECT_NE(FindCallDllFunction("long long(long long,double)"), nullptr);
+        EXPECT_NE(FindCallDllFunction("void(table_view,table_builder)"), nullptr);
+        EXPECT_NE(FindCallDllFunction("void()"), nullptr);
+        EXPECT_EQ(FindCallDllFunction("long long(long long,doubl)"), nullptr);
+        EXPECT_EQ(FindCallDllFunction("long long(long long, double)"), nullptr); // see RemoveWsFromParams
+        EXPECT_EQ(FindCallDllFunction("double(double,long long,const char*,double)"), nullptr);
+        EXPECT_EQ(FindCallDllFunction(""), nullptr);
+    }
+
+    TEST_F(LuaTest, GeneratedFunctionCallsFunction)
+    {
+        const CallDllFunctionType call = FindCallDllFunction("long long(long long,double)");
+        ASSERT_NE(call, nullptr);
+
+        lua_pushinteger(_L, 3);
+        lua_pushnumber(_L, 4.0);
+        call(_L, reinterpret_cast<DllFunction>(&nexuslua_lua_test_add));
+
+        EXPECT_EQ(lua_tointeger(_L, -1), 7);
+    }
+
+#ifdef NEXUSLUA_GENERIC_DLL_CALL
+    TEST_F(LuaTest, GenericDllCallPassesArgumentsInAnyOrder)
+    {
+        const GenericDllCall call("double(double, long long, const char*, double)");
+
+        lua_pushnumber(_L, 1.5);
+        lua_pushinteger(_L, 4);
+        lua_pushstring(_L, "abc");
+        lua_pushnumber(_L, 0.5);
+        call(_L, reinterpret_cast<DllFunction>(&nexuslua_lua_test_mixed));
+
+        EXPECT_DOUBLE_EQ(lua_tonumber(_L, -1), 1.5 * 4 + 3 - 0.5);
+    }
+
+    TEST(GenericDllCallTest, RejectsUnsupportedSignatures)
+    {
+        EXPECT_THROW(GenericDllCall("double"), std::runtime_error);
+        EXPECT_THROW(GenericDllCall("double(void)"), std::runtime_error);
+        EXPECT_THROW(GenericDllCall("table_view(double)"), std::runtime_error);
+        EXPECT_THROW(GenericDllCall("void(table_builder,double)"), std::runtime_error);
+        EXPECT_THROW(GenericDllCall("void(double,double,double,double,double,double,double,double,double)"), std::runtime_error);
+    }
+#endif
+
+    TEST_F(LuaTest, TableViewPassesTablesInPlace)
+    {
+        const CallDllFunctionType call = FindCallDllFunction("void(table_view,table_builder)");
+        ASSERT_NE(call, nullptr);
+
+        lua_newtable(_L);
+        lua_pushnumber(_L, 2.0);
+        lua_setfield(_L, -2, "factor");
+        auto* values = static_cast<double*>(lua_newnumericarray(_L, NumericArray::ElementType::Float64, 3));
+        values[0]    = 1.0;
+        values[1]    = 2.0;
+        values[2]    = 3.0;
+        lua_setfield(_L, -2, "values");
+
+        call(_L, reinterpret_cast<DllFunction>(&nexuslua_lua_test_scale));
+
+        ASSERT_TRUE(lua_istable(_L, -1));
+        lua_getfield(_L, -1, "values");
+        NumericArray::ElementType type;
+        std::size_t               length = 0;
+        const auto*               result = static_cast<const double*>(lua_tonumericarraydata(_L, -1, type, length));
+
+        ASSERT_NE(result, nullptr);
+        EXPECT_EQ(type, NumericArray::ElementType::Float64);
+        ASSERT_EQ(length, 3u);
+        EXPECT_EQ(std::vector<double>(result, result + length), (std::vector<double>{2.0, 4.0, 6.0}));
+    }
 }
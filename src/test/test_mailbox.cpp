@@ -0,0 +1,414 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "mailbox.hpp"
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nexuslua
+{
+    namespace
+    {
+        /// polls condition for at most 10 seconds and returns its last result
+        bool WaitFor(const std::function<bool()>& condition)
+        {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+            while (!condition())
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            return true;
+        }
+    }
+
+    class MailboxTest : public ::testing::TestWithParam<bool> ///< parameter: executed by a Scheduler instead of a thread per handler
+    {
+    protected:
+        std::shared_ptr<Mailbox> Create(const std::size_t lanes = 1, const Mailbox::Dequeue dequeue = Mailbox::Dequeue::Strict)
+        {
+            return std::make_shared<Mailbox>(GetParam() ? &_scheduler : nullptr, lanes, dequeue);
+        }
+
+        /// adds a handler that records the agent_n of the messages it receives, but waits in the first message until Release is called
+        void AddRecorder(const std::shared_ptr<Mailbox>& mailbox)
+        {
+            mailbox->AddHandler(this, [this, released = _gate.get_future().share()](std::span<std::shared_ptr<Message>> messages)
+                                {
+                released.wait();
+                std::lock_guard lock(_mtx);
+                _batches.push_back(messages.size());
+                for (const auto& message : messages)
+                {
+                    _received.push_back(message->agent_n);
+                } });
+        }
+
+        void Release()
+        {
+            _gate.set_value();
+        }
+
+        /// waits until count messages have been received and returns their agent_n, omitting the first one
+        std::vector<int> Received(const std::size_t count)
+        {
+            EXPECT_TRUE(WaitFor([this, count]()
+                                {
+                std::lock_guard lock(_mtx);
+                return _received.size() >= count; }));
+
+            std::lock_guard lock(_mtx);
+            return {_received.begin() + std::min<std::size_t>(1, _received.size()), _received.end()};
+        }
+
+        std::vector<std::size_t> Batches()
+        {
+            std::lock_guard lock(_mtx);
+            return _batches;
+        }
+
+        Scheduler                _scheduler{2};
+        std::promise<void>       _gate;
+        std::mutex               _mtx;
+        std::vector<int>         _received;
+        std::vector<std::size_t> _batches; ///< sizes of the batches passed to the handler
+    };
+
+    TEST_P(MailboxTest, StrictDequeueTakesHighestPriorityLaneFirst)
+    {
+        auto mailbox = Create(3, Mailbox::Dequeue::Strict);
+        AddRecorder(mailbox);
+
+        mailbox->Push(std::make_shared<Message>(-1)); // occupies the handler until Release
+        ASSERT_TRUE(WaitFor([&]()
+                            { return mailbox->GetLaneDepths()[0] == 0; }));
+
+        mailbox->Push(std::make_shared<Message>(20), 2);
+        mailbox->Push(std::make_shared<Message>(21), 7); // lanes beyond the last one are mapped to the last lane
+        mailbox->Push(std::make_shared<Message>(10), 1);
+        mailbox->Push(std::make_shared<Message>(11), 1);
+        mailbox->Push(std::make_shared<Message>(0), 0);
+        mailbox->Push(std::make_shared<Message>(1), 0);
+
+        EXPECT_EQ(mailbox->GetLaneDepths(), (std::vector<std::size_t>{2, 2, 2}));
+        EXPECT_EQ(mailbox->GetHighWaterMark(), 6u);
+
+        Release();
+        EXPECT_EQ(Received(7), (std::vector<int>{0, 1, 10, 11, 20, 21}));
+        mailbox->RemoveHandler(this);
+    }
+
+    TEST_P(MailboxTest, WeightedDequeueDoesNotStarveLowerPriorityLanes)
+    {
+        auto mailbox = Create(2, Mailbox::Dequeue::Weighted);
+        AddRecorder(mailbox);
+
+        mailbox->Push(std::make_shared<Message>(-1));
+        ASSERT_TRUE(WaitFor([&]()
+                            { return mailbox->GetLaneDepths()[0] == 0; }));
+
+        for (int i = 0; i < 6; ++i)
+        {
+            mailbox->Push(std::make_shared<Message>(10 + i), 1);
+        }
+        for (int i = 0; i < 6; ++i)
+        {
+            mailbox->Push(std::make_shared<Message>(i), 0);
+        }
+
+        Release();
+
+        // smooth weighted round robin, lane 0 having twice the weight of lane 1
+        EXPECT_EQ(Received(13), (std::vector<int>{0, 10, 1, 2, 11, 3, 4, 12, 5, 13, 14, 15}));
+        mailbox->RemoveHandler(this);
+    }
+
+    TEST_P(MailboxTest, BatchTakesQueuedMessagesOfSameName)
+    {
+        auto mailbox = Create();
+        mailbox->SetBatching(4, std::chrono::duration<double>(0), [](const Message& message)
+                             { return message.name == "batched"; });
+        AddRecorder(mailbox);
+
+        mailbox->Push(std::make_shared<Message>(-1, "gate", LuaTable()));
+        ASSERT_TRUE(WaitFor([&]()
+                            { return mailbox->GetLaneDepths()[0] == 0; }));
+
+        mailbox->Push(std::make_shared<Message>(0, "batched", LuaTable()));
+        mailbox->Push(std::make_shared<Message>(100, "single", LuaTable()));
+        mailbox->Push(std::make_shared<Message>(101, "single", LuaTable()));
+        for (int i = 1; i < 6; ++i)
+        {
+            mailbox->Push(std::make_shared<Message>(i, "batched", LuaTable()));
+        }
+
+        Release();
+
+        // the batch is limited to 4 messages; the other messages keep their order
+        EXPECT_EQ(Received(9), (std::vector<int>{0, 1, 2, 3, 100, 101, 4, 5}));
+        EXPECT_EQ(Batches(), (std::vector<std::size_t>{1, 4, 1, 1, 2}));
+        mailbox->RemoveHandler(this);
+    }
+
+    TEST_P(MailboxTest, BatchLingersForMoreMessages)
+    {
+        auto mailbox = Create();
+        mailbox->SetBatching(8, std::chrono::seconds(5), [](const Message& message)
+                             { return message.name == "batched"; });
+        AddRecorder(mailbox);
+        Release();
+
+        mailbox->Push(std::make_shared<Message>(-1, "gate", LuaTable()));
+        Received(1);
+
+        mailbox->Push(std::make_shared<Message>(0, "batched", LuaTable()));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        for (int i = 1; i < 8; ++i)
+        {
+            mailbox->Push(std::make_shared<Message>(i, "batched", LuaTable()));
+        }
+
+        // the batch is handed over as soon as it is full, long before the linger time ended
+        EXPECT_EQ(Received(9), (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}));
+        EXPECT_EQ(Batches(), (std::vector<std::size_t>{1, 8}));
+        mailbox->RemoveHandler(this);
+    }
+
+    TEST_P(MailboxTest, FullMailboxRejectsOrDropsOldest)
+    {
+        auto mailbox = Create(2);
+        AddRecorder(mailbox);
+
+        mailbox->Push(std::make_shared<Message>(-1));
+        ASSERT_TRUE(WaitFor([&]()
+                            { return mailbox->GetLaneDepths()[0] == 0; }));
+
+        mailbox->SetCapacity(2, Mailbox::Overflow::Fail);
+        EXPECT_EQ(mailbox->Push(std::make_shared<Message>(0), 0), Mailbox::PushResult::Queued);
+        EXPECT_EQ(mailbox->Push(std::make_shared<Message>(10), 1), Mailbox::PushResult::Queued);
+        EXPECT_EQ(mailbox->Push(std::make_shared<Message>(1), 0), Mailbox::PushResult::Rejected);
+        EXPECT_EQ(mailbox->GetOverflowCount(), 1u);
+
+        // the oldest message of the lowest priority lane makes room, or the new message if it is this one
+        mailbox->SetCapacity(2, Mailbox::Overflow::DropOldest);
+        std::shared_ptr<Message> dropped;
+        EXPECT_EQ(mailbox->Push(std::make_shared<Message>(1), 0, true, &dropped), Mailbox::PushResult::DroppedOldest);
+        ASSERT_TRUE(dropped);
+        EXPECT_EQ(dropped->agent_n, 10);
+
+        dropped.reset();
+        EXPECT_EQ(mailbox->Push(std::make_shared<Message>(11), 1, true, &dropped), Mailbox::PushResult::Rejected);
+        EXPECT_FALSE(dropped);
+        EXPECT_EQ(mailbox->GetOverflowCount(), 3u);
+        EXPECT_EQ(mailbox->GetHighWaterMark(), 2u);
+
+        Release();
+        EXPECT_EQ(Received(3), (std::vector<int>{0, 1}));
+        mailbox->RemoveHandler(this);
+    }
+
+    TEST_P(MailboxTest, FullMailboxBlocksSenderUntilSpace)
+    {
+        auto mailbox = Create();
+        AddRecorder(mailbox);
+
+        mailbox->Push(std::make_shared<Message>(-1));
+        ASSERT_TRUE(WaitFor([&]()
+                            { return mailbox->GetLaneDepths()[0] == 0; }));
+
+        mailbox->SetCapacity(1, Mailbox::Overflow::Block);
+        EXPECT_EQ(mailbox->Push(std::make_shared<Message>(0)), Mailbox::PushResult::Queued);
+        EXPECT_EQ(mailbox->Push(std::make_shared<Message>(1), 0, false), Mailbox::PushResult::Rejected);
+
+        std::atomic<bool> sent{false};
+        std::thread       sender([&]()
+                           {
+            mailbox->Push(std::make_shared<Message>(1));
+            sent = true; });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_FALSE(sent);
+
+        Release();
+        sender.join();
+        EXPECT_TRUE(sent);
+        EXPECT_EQ(Received(3), (std::vector<int>{0, 1}));
+        mailbox->RemoveHandler(this);
+    }
+
+    TEST_P(MailboxTest, FullMailboxDoesNotBlockSchedulerWorkers)
+    {
+        auto mailbox = Create();
+        AddRecorder(mailbox);
+
+        mailbox->Push(std::make_shared<Message>(-1));
+        ASSERT_TRUE(WaitFor([&]()
+                            { return mailbox->GetLaneDepths()[0] == 0; }));
+
+        mailbox->SetCapacity(1, Mailbox::Overflow::Block);
+        EXPECT_EQ(mailbox->Push(std::make_shared<Message>(0)), Mailbox::PushResult::Queued);
+
+        // e. g. an agent of a CoroutineHost that sends to a full mailbox; waiting would stop all agents of the host
+        std::promise<Mailbox::PushResult> result;
+        {
+            Scheduler host(1);
+            host.Submit([&]()
+                        { result.set_value(mailbox->Push(std::make_shared<Message>(1))); });
+            auto future = result.get_future();
+            ASSERT_EQ(future.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+            EXPECT_EQ(future.get(), Mailbox::PushResult::Queued);
+        }
+
+        EXPECT_EQ(mailbox->GetLaneDepths()[0], 2u); // the capacity is exceeded
+
+        Release();
+        EXPECT_EQ(Received(3), (std::vector<int>{0, 1}));
+        mailbox->RemoveHandler(this);
+    }
+
+    TEST_P(MailboxTest, RemoveHandlerIfIdleKeepsBusyHandler)
+    {
+        auto               mailbox = Create();
+        std::promise<void> gate;
+        std::atomic<bool>  started{false};
+        std::atomic<int>   handled{0};
+        const int          owner = 0;
+
+        mailbox->AddHandler(&owner, [&, released = gate.get_future().share()](std::span<std::shared_ptr<Message>>)
+                            {
+            started = true;
+            released.wait();
+            ++handled; });
+
+        mailbox->Push(std::make_shared<Message>(0));
+        ASSERT_TRUE(WaitFor([&]()
+                            { return started.load(); }));
+
+        // the handler processes a message, so it is not removed, regardless of what idle returns
+        bool idleCalled = false;
+        EXPECT_FALSE(mailbox->RemoveHandlerIfIdle(&owner, [&idleCalled]()
+                                                  { return idleCalled = true; }));
+        EXPECT_FALSE(idleCalled);
+
+        gate.set_value();
+        ASSERT_TRUE(WaitFor([&]()
+                            { return handled == 1; }));
+
+        // the handler may still be about to return to the mailbox, so retry until it is idle
+        EXPECT_FALSE(mailbox->RemoveHandlerIfIdle(&owner, []()
+                                                  { return false; }));
+        EXPECT_TRUE(WaitFor([&]()
+                            { return mailbox->RemoveHandlerIfIdle(&owner, []()
+                                                                  { return true; }); }));
+
+        // a removed handler takes no more messages
+        mailbox->Push(std::make_shared<Message>(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_EQ(handled, 1);
+        EXPECT_EQ(mailbox->GetLaneDepths()[0], 1u);
+    }
+
+    TEST_P(MailboxTest, RemoveHandlerIfIdleKeepsHandlerWithPostedTasks)
+    {
+        auto               mailbox = Create();
+        std::promise<void> gate;
+        std::atomic<bool>  started{false};
+        std::atomic<bool>  postedRan{false};
+        const int          owner = 0;
+
+        mailbox->AddHandler(&owner, [&, released = gate.get_future().share()](std::span<std::shared_ptr<Message>>)
+                            {
+            started = true;
+            released.wait(); });
+
+        mailbox->Push(std::make_shared<Message>(0));
+        ASSERT_TRUE(WaitFor([&]()
+                            { return started.load(); }));
+
+        // e. g. the reply that resumes a suspended handler
+        ASSERT_TRUE(mailbox->Post(&owner, [&postedRan]()
+                                  { postedRan = true; }));
+        gate.set_value();
+
+        ASSERT_TRUE(WaitFor([&]()
+                            { return postedRan.load(); }));
+        EXPECT_TRUE(WaitFor([&]()
+                            { return mailbox->RemoveHandlerIfIdle(&owner, []()
+                                                                  { return true; }); }));
+    }
+
+    TEST_P(MailboxTest, FirstTaskOfNewHandlerRunsBeforeQueuedMessages)
+    {
+        auto             mailbox = Create();
+        std::mutex       mtx;
+        std::vector<int> order;
+        const int        owner  = 0;
+        const auto       record = [&](const int entry)
+        {
+            std::lock_guard lock(mtx);
+            order.push_back(entry);
+        };
+
+        // e. g. a new replica that must handle the message it was created for before the messages queued meanwhile
+        mailbox->Push(std::make_shared<Message>(1));
+        mailbox->Push(std::make_shared<Message>(2));
+        mailbox->AddHandler(
+            &owner, [&](std::span<std::shared_ptr<Message>> messages)
+            {
+                for (const auto& message : messages)
+                {
+                    record(message->agent_n);
+                } },
+            {},
+            [&]()
+            { record(0); });
+
+        ASSERT_TRUE(WaitFor([&]()
+                            {
+            std::lock_guard lock(mtx);
+            return order.size() == 3; }));
+        EXPECT_EQ(order, (std::vector<int>{0, 1, 2}));
+        mailbox->RemoveHandler(&owner);
+    }
+
+    INSTANTIATE_TEST_SUITE_P(Execution, MailboxTest, ::testing::Values(false, true), [](const ::testing::TestParamInfo<bool>& info)
+                             { return info.param ? "Scheduler" : "Threads"; });
+}
@@ -35,8 +35,12 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 
 #include <nexuslua/message.hpp>
 
+#include "message_pool.hpp"
+
 #include <memory>
 #include <random>
+#include <thread>
+#include <vector>
 
 namespace nexuslua
 {
@@ -132,4 +136,88 @@ namespace nexuslua
             ASSERT_FALSE(failure);
         }
     }
+
+    TEST(MessageTest, CloneKeepsTheMessageId)
+    {
+        LuaTable parameters;
+        parameters.data["value"s] = 1LL;
+
+        const Message message(3, 7, "Name", std::move(parameters));
+        const auto    clone = message.clone();
+
+        EXPECT_EQ(clone->agent_n, 3);
+        EXPECT_EQ(clone->message_id, 7);
+        EXPECT_EQ(clone->name, "Name");
+        EXPECT_EQ(clone->parameters, message.parameters);
+    }
+
+    TEST(MessageTest, OriginalMessageIsMovedIntoTheReply)
+    {
+        LuaTable original;
+        original.data["value"s]                    = 1LL;
+        original.sub_tables["sub"s].data["value"s] = 2LL;
+        const LuaTable expected                    = original;
+
+        Message reply(0);
+        reply.parameters.SetOriginalMessage("Request", std::move(original));
+
+        EXPECT_EQ(reply.GetOriginalMessageNameOrEmpty(), "Request");
+        EXPECT_EQ(reply.GetOriginalMessageParametersOrEmpty(), expected);
+        EXPECT_EQ(Message(0).GetOriginalMessageParametersOrEmpty(), LuaTable());
+    }
+
+    TEST(MessagePoolTest, MakeConstructsTheMessage)
+    {
+        LuaTable parameters;
+        parameters.data["value"s] = 1LL;
+        const LuaTable expected   = parameters;
+
+        const auto message = MessagePool::Make(3, 7, "Name", std::move(parameters));
+
+        EXPECT_EQ(message->agent_n, 3);
+        EXPECT_EQ(message->message_id, 7);
+        EXPECT_EQ(message->name, "Name");
+        EXPECT_EQ(message->parameters, expected);
+    }
+
+    TEST(MessagePoolTest, ReleasedMessageIsReusedByTheSameThread)
+    {
+        auto        message = MessagePool::Make(0, 0, "Name", LuaTable());
+        const void* block   = message.get();
+        message.reset();
+
+        message = MessagePool::Make(0, 0, "Other", LuaTable());
+        EXPECT_EQ(message.get(), block);
+        EXPECT_EQ(message->name, "Other");
+    }
+
+    TEST(MessagePoolTest, MessagesCanBeReleasedByOtherThreads)
+    {
+        // more messages than a thread caches, so that blocks are passed on to other threads via the depot
+        constexpr int rounds       = 20;
+        constexpr int messageCount = 1000;
+
+        for (int round = 0; round < rounds; ++round)
+        {
+            std::vector<std::shared_ptr<Message>> messages;
+            messages.reserve(messageCount);
+
+            for (long long i = 0; i < messageCount; ++i)
+            {
+                LuaTable parameters;
+                parameters.data["value"s] = i;
+                messages.push_back(MessagePool::Make(0, round, "Name", std::move(parameters)));
+            }
+
+            std::thread consumer([&messages]()
+                                 {
+                                     long long expected = 0;
+                                     for (auto& message : messages)
+                                     {
+                                         EXPECT_EQ(message->parameters.get_mapped_value_or_default<long long>("value"s), expected++);
+                                         message.reset();
+                                     } });
+            consumer.join();
+        }
+    }
 }
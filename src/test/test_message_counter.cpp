@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "message_counter.hpp"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace nexuslua
+{
+    TEST(MessageCounterTest, CountsMessagesOfAllThreads)
+    {
+        message_counter counter;
+
+        counter.increase();
+        counter.increase();
+        std::thread([&counter]()
+                    { counter.decrease(2); })
+            .join();
+
+        EXPECT_EQ(counter.size(), 0);
+    }
+
+    TEST(MessageCounterTest, WaiterDoesNotMissMessagesSentByHandlers)
+    {
+        // a message is passed from thread to thread like a chain of handlers that each send the next message before they
+        // finished their own one, so that the sum over the shards is read while they change
+        constexpr int threadCount = 4;
+        constexpr int hopCount    = 2000;
+
+        for (int round = 0; round < 5; ++round)
+        {
+            message_counter          counter;
+            std::atomic<int>         hop{0};
+            std::atomic<int>         holder{0};
+            std::vector<std::thread> handlers;
+
+            counter.increase(); // the first message
+
+            for (int t = 0; t < threadCount; ++t)
+            {
+                handlers.emplace_back([&, t]()
+                                      {
+                    while (hop < hopCount)
+                    {
+                        if (holder.load() != t)
+                        {
+                            std::this_thread::yield();
+                            continue;
+                        }
+
+                        if (++hop < hopCount)
+                        {
+                            counter.increase(); // the handler sends the next message
+                        }
+
+                        holder = (t + 1) % threadCount; // which is received by the next thread
+                        counter.decrease();             // after the handler returned
+                    } });
+            }
+
+            counter.wait_until_empty();
+            EXPECT_EQ(hop, hopCount);
+
+            for (auto& handler : handlers)
+            {
+                handler.join();
+            }
+
+            EXPECT_EQ(counter.size(), 0);
+        }
+    }
+}
@@ -0,0 +1,207 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "replica_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace nexuslua
+{
+    namespace
+    {
+        /// polls condition for at most 10 seconds and returns its last result
+        bool WaitFor(const std::function<bool()>& condition)
+        {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+            while (!condition())
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            return true;
+        }
+
+        /// creates stand-ins for replicas, which are never dereferenced by the pool, and counts them
+        class ReplicaFactory
+        {
+        public:
+            /// returns a non-null replica that owns a token with the number of its creation
+            std::shared_ptr<AgentThreadLua> operator()()
+            {
+                {
+                    std::unique_lock lock(_mtx);
+                    ++_started;
+                    _cv.notify_all();
+                    _cv.wait(lock, [this]
+                             { return !_blocked; });
+                }
+
+                auto token = std::make_shared<int>(++_created);
+                ++_alive;
+                std::shared_ptr<int> counted(token.get(), [this, token](int*)
+                                             { --_alive; });
+                return std::shared_ptr<AgentThreadLua>(counted, reinterpret_cast<AgentThreadLua*>(token.get()));
+            }
+
+            /// returns the number of the creation of the given replica
+            static int Number(const std::shared_ptr<AgentThreadLua>& replica)
+            {
+                return *reinterpret_cast<const int*>(replica.get());
+            }
+
+            /// makes further replicas wait in the factory until Unblock is called
+            void Block()
+            {
+                std::lock_guard lock(_mtx);
+                _blocked = true;
+            }
+
+            void Unblock()
+            {
+                {
+                    std::lock_guard lock(_mtx);
+                    _blocked = false;
+                }
+                _cv.notify_all();
+            }
+
+            /// waits until the factory has been entered count times
+            bool WaitUntilStarted(const int count)
+            {
+                std::unique_lock lock(_mtx);
+                return _cv.wait_for(lock, std::chrono::seconds(10), [this, count]
+                                    { return _started >= count; });
+            }
+
+            std::atomic<int> _created{0}; ///< number of replicas created so far
+            std::atomic<int> _alive{0};   ///< number of replicas that have not been destroyed yet
+
+        private:
+            std::mutex              _mtx;
+            std::condition_variable _cv;
+            int                     _started{0};
+            bool                    _blocked{false};
+        };
+    }
+
+    TEST(ReplicaPoolTest, PreparesReplicasOnlyAfterFillOrTake)
+    {
+        ReplicaFactory factory;
+        ReplicaPool    pool(2, std::ref(factory));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_EQ(factory._created, 0); // warm-up "ondemand"
+        EXPECT_EQ(pool.Take(), nullptr);
+
+        EXPECT_TRUE(WaitFor([&]()
+                            { return pool.GetWarmCount() == 2; }));
+    }
+
+    TEST(ReplicaPoolTest, TakeHandsOutPreparedReplicaAndRefills)
+    {
+        ReplicaFactory factory;
+        ReplicaPool    pool(2, std::ref(factory));
+
+        pool.Fill(); // warm-up "eager"
+        ASSERT_TRUE(WaitFor([&]()
+                            { return pool.GetWarmCount() == 2; }));
+        factory.Block();
+
+        // the replica has been created before it was requested, and the oldest one is handed out first
+        const auto replica = pool.Take();
+        ASSERT_NE(replica, nullptr);
+        EXPECT_EQ(ReplicaFactory::Number(replica), 1);
+        EXPECT_EQ(pool.GetWarmCount(), 1u);
+
+        ASSERT_TRUE(factory.WaitUntilStarted(3)); // the pool is refilled in the background
+        EXPECT_EQ(factory._created, 2);
+        factory.Unblock();
+
+        EXPECT_TRUE(WaitFor([&]()
+                            { return pool.GetWarmCount() == 2; }));
+        EXPECT_EQ(factory._created, 3);
+    }
+
+    TEST(ReplicaPoolTest, DoesNotExceedItsSize)
+    {
+        ReplicaFactory factory;
+        ReplicaPool    pool(3, std::ref(factory));
+
+        for (int i = 0; i < 5; ++i)
+        {
+            pool.Fill();
+        }
+
+        ASSERT_TRUE(WaitFor([&]()
+                            { return pool.GetWarmCount() == 3; }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pool.Fill();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        EXPECT_EQ(pool.GetWarmCount(), 3u);
+        EXPECT_EQ(factory._created, 3);
+    }
+
+    TEST(ReplicaPoolTest, StopWaitsForTheReplicaBeingPrepared)
+    {
+        ReplicaFactory factory;
+        ReplicaPool    pool(2, std::ref(factory));
+
+        pool.Fill();
+        ASSERT_TRUE(WaitFor([&]()
+                            { return pool.GetWarmCount() == 2; }));
+        factory.Block();
+        ASSERT_NE(pool.Take(), nullptr);
+        ASSERT_TRUE(factory.WaitUntilStarted(3));
+
+        auto stopped = std::async(std::launch::async, [&pool]()
+                                  { pool.Stop(); });
+        EXPECT_EQ(stopped.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+
+        factory.Unblock();
+        ASSERT_EQ(stopped.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+
+        // the replica that was finished after Stop and the prepared ones are destroyed, and no further replica is prepared
+        EXPECT_EQ(pool.GetWarmCount(), 0u);
+        EXPECT_EQ(factory._alive, 0);
+        pool.Fill();
+        EXPECT_EQ(pool.Take(), nullptr);
+        EXPECT_EQ(factory._created, 3);
+    }
+}
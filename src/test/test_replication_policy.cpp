@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "replication_policy.hpp"
+
+#include "nexuslua/configuration.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace nexuslua
+{
+    using namespace std::string_literals;
+
+    TEST(ReplicationPolicyTest, IdleTimeReplicatesIfPreviousMessageFinishedRecently)
+    {
+        Configuration configuration;
+        configuration.SetInternal(Configuration::luaStartNewThreadTime, 0.01);
+        auto policy = ReplicationPolicy::Create(configuration);
+
+        EXPECT_TRUE(policy->Replicate({0, 1, 0.005, 0}));
+        EXPECT_TRUE(policy->Replicate({0, 1, 0.01, 0}));
+        EXPECT_FALSE(policy->Replicate({100, 1, 0.02, 1}));
+    }
+
+    TEST(ReplicationPolicyTest, QueueDepthReplicatesIfExpectedWaitExceedsTargetLatency)
+    {
+        Configuration configuration;
+        configuration.SetInternal(Configuration::luaReplicationPolicy, (std::string)Configuration::luaReplicationPolicyQueueDepth);
+        configuration.SetInternal(Configuration::luaReplicationTargetLatency, 0.01);
+        configuration.SetInternal(Configuration::luaReplicationCoreBudget, 1000LL);
+        auto policy = ReplicationPolicy::Create(configuration);
+
+        EXPECT_FALSE(policy->Replicate({0, 1, 0, 1.0}));   // nothing waits
+        EXPECT_FALSE(policy->Replicate({4, 1, 0, 0.001})); // 4 ms expected wait
+        EXPECT_TRUE(policy->Replicate({20, 1, 0, 0.001})); // 20 ms expected wait
+        EXPECT_FALSE(policy->Replicate({20, 4, 0, 0.001})); // 5 ms, because 4 instances share the queue
+    }
+
+    TEST(ReplicationPolicyTest, QueueDepthRespectsCoreBudget)
+    {
+        Configuration configuration;
+        configuration.SetInternal(Configuration::luaReplicationPolicy, (std::string)Configuration::luaReplicationPolicyQueueDepth);
+        configuration.SetInternal(Configuration::luaReplicationTargetLatency, 0.01);
+        auto policy = ReplicationPolicy::Create(configuration);
+
+        const std::size_t budget = ReplicationPolicy::GetReplicaCount() + 2;
+        configuration.SetInternal(Configuration::luaReplicationCoreBudget, (long long)budget);
+
+        ReplicationPolicy::ReplicasStarted(budget - 1 - ReplicationPolicy::GetReplicaCount());
+        EXPECT_TRUE(policy->Replicate({100, 1, 0, 1.0}));
+
+        ReplicationPolicy::ReplicasStarted();
+        EXPECT_FALSE(policy->Replicate({100, 1, 0, 1.0}));
+
+        ReplicationPolicy::ReplicasStopped(2);
+    }
+
+    TEST(ReplicationPolicyTest, UnknownPolicyIsRejected)
+    {
+        Configuration configuration;
+        configuration.SetInternal(Configuration::luaReplicationPolicy, "random"s);
+        EXPECT_THROW(ReplicationPolicy::Create(configuration), std::runtime_error);
+    }
+
+    TEST(AgentLoadTest, AverageHandlingTimeIsExponentiallyWeighted)
+    {
+        AgentLoad load;
+        EXPECT_EQ(load.GetAverageHandlingTime(), 0.0);
+
+        load.AddHandlingTime(1.0);
+        EXPECT_DOUBLE_EQ(load.GetAverageHandlingTime(), 1.0);
+
+        load.AddHandlingTime(2.0);
+        EXPECT_DOUBLE_EQ(load.GetAverageHandlingTime(), AgentLoad::smoothing * 2.0 + (1 - AgentLoad::smoothing) * 1.0);
+
+        load.MessageQueued();
+        load.MessageQueued();
+        load.MessageDequeued();
+        EXPECT_EQ(load.GetQueuedMessages(), 1u);
+    }
+}
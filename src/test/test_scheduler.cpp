@@ -0,0 +1,203 @@
+/*
+Copyright (c) 2025 acrion innovations GmbH
+Authors: Stefan Zipproth, s.zipproth@acrion.ch
+
+This file is part of nexuslua, see https://github.com/acrion/nexuslua and https://nexuslua.org
+
+nexuslua is offered under a commercial and under the AGPL license.
+For commercial licensing, contact us at https://acrion.ch/sales. For AGPL licensing, see below.
+
+AGPL licensing:
+
+nexuslua is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+nexuslua is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "mailbox.hpp"
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nexuslua
+{
+    namespace
+    {
+        /// polls condition for at most 10 seconds and returns its last result
+        bool WaitFor(const std::function<bool()>& condition)
+        {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+            while (!condition())
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            return true;
+        }
+    }
+
+    TEST(SchedulerTest, ExternalSubmissionsRunInFifoOrder)
+    {
+        std::mutex         mtx;
+        std::vector<int>   order;
+        std::promise<void> gate;
+        Scheduler          scheduler(1);
+
+        // occupies the only worker, so that the following tasks are queued
+        scheduler.Submit([released = gate.get_future().share()]()
+                         { released.wait(); });
+
+        for (int i = 0; i < 100; ++i)
+        {
+            scheduler.Submit([&mtx, &order, i]()
+                             {
+                std::lock_guard lock(mtx);
+                order.push_back(i); });
+        }
+
+        gate.set_value();
+
+        ASSERT_TRUE(WaitFor([&]()
+                            {
+            std::lock_guard lock(mtx);
+            return order.size() == 100; }));
+
+        std::lock_guard lock(mtx);
+        EXPECT_TRUE(std::is_sorted(order.begin(), order.end()));
+    }
+
+    TEST(SchedulerTest, WorkerSubmissionsDoNotStarveExternalOnes)
+    {
+        std::atomic<bool>     externalRan{false};
+        std::atomic<int>      spins{0};
+        std::atomic<int>      spinsWhenSubmitted{0};
+        std::atomic<int>      spinsWhenRan{0};
+        std::function<void()> spin;
+        Scheduler             scheduler(1); // destroyed first, which runs the remaining tasks
+
+        // a task that keeps submitting itself from the worker until the external task ran
+        spin = [&]()
+        {
+            if (!externalRan && ++spins < 1000000)
+            {
+                scheduler.Submit(spin);
+            }
+        };
+
+        scheduler.Submit(spin);
+        ASSERT_TRUE(WaitFor([&]()
+                            { return spins > 0; }));
+
+        spinsWhenSubmitted = spins.load();
+        scheduler.Submit([&]()
+                         {
+            spinsWhenRan = spins.load();
+            externalRan  = true; });
+
+        ASSERT_TRUE(WaitFor([&]()
+                            { return externalRan.load(); }));
+        EXPECT_LE(spinsWhenRan - spinsWhenSubmitted, (int)Scheduler::injectInterval + 1);
+    }
+
+    TEST(SchedulerTest, MailboxHandlerIsNeverRunConcurrently)
+    {
+        constexpr int messageCount = 2000;
+
+        Scheduler        scheduler(4);
+        auto             mailbox = std::make_shared<Mailbox>(&scheduler);
+        std::atomic<int> running{0};
+        std::atomic<int> maxRunning{0};
+        std::atomic<int> handled{0};
+        std::vector<int> order; // only accessed by the handler
+        const int        owner = 0;
+
+        mailbox->AddHandler(&owner, [&](std::span<std::shared_ptr<Message>> messages)
+                            {
+            const int concurrent = ++running;
+            maxRunning           = std::max(maxRunning.load(), concurrent);
+
+            for (const auto& message : messages)
+            {
+                order.push_back(message->agent_n);
+            }
+
+            --running;
+            handled += (int)messages.size(); });
+
+        std::vector<std::thread> senders;
+        std::mutex               mtxSend; // keeps the order of the messages comparable to the order of handling
+        int                      sent = 0;
+
+        for (int t = 0; t < 4; ++t)
+        {
+            senders.emplace_back([&]()
+                                 {
+                for (int i = 0; i < messageCount / 4; ++i)
+                {
+                    std::lock_guard lock(mtxSend);
+                    mailbox->Push(std::make_shared<Message>(sent++));
+                } });
+        }
+
+        for (auto& sender : senders)
+        {
+            sender.join();
+        }
+
+        ASSERT_TRUE(WaitFor([&]()
+                            { return handled == messageCount; }));
+        mailbox->RemoveHandler(&owner);
+
+        EXPECT_EQ(maxRunning, 1);
+        ASSERT_EQ(order.size(), (std::size_t)messageCount);
+        EXPECT_TRUE(std::is_sorted(order.begin(), order.end())); // FIFO within a lane
+    }
+
+    TEST(SchedulerTest, HandlerThatRemovesItselfKeepsMailboxAlive)
+    {
+        auto               mailbox = std::make_shared<Mailbox>(nullptr); // a thread per handler
+        std::weak_ptr      weak    = mailbox;
+        std::promise<void> removed;
+        const int          owner = 0;
+
+        mailbox->AddHandler(&owner, [&removed, &owner, weak](std::span<std::shared_ptr<Message>>)
+                            {
+            if (auto locked = weak.lock())
+            {
+                locked->RemoveHandler(&owner); // must neither wait for nor detach its own thread
+            }
+            removed.set_value(); });
+
+        mailbox->Push(std::make_shared<Message>(0));
+        ASSERT_EQ(removed.get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+
+        // the thread of the handler keeps the mailbox alive until it ended, then the mailbox joins it
+        mailbox.reset();
+        EXPECT_TRUE(WaitFor([&]()
+                            { return weak.expired(); }));
+    }
+}
@@ -27,39 +27,79 @@ along with nexuslua. If not, see <https://www.gnu.org/licenses/>.
 
 #include "agent.hpp"
 #include "agent_thread_base.hpp"
+#include "agent_thread_coroutine.hpp"
 #include "agent_thread_cpp.hpp"
 #include "agent_thread_lua.hpp"
 #include "agents.hpp"
 #include "config.hpp"
+#include "configuration.hpp"
+#include "coroutine_host.hpp"
+#include "cpu_affinity.hpp"
+#include "mailbox.hpp"
+#include "message_counter.hpp"
+#include "pending_calls.hpp"
+#include "replication_policy.hpp"
+#include "scheduler.hpp"
 
 #include "nexuslua_export.h"
 
+#include <cbeam/convert/nested_map.hpp>
 #include <cbeam/lifecycle/item_registry.hpp>
 #include <cbeam/lifecycle/singleton.hpp>
+#include <cbeam/logging/log_manager.hpp>
 
+#include <algorithm>
 #include <filesystem>
 #include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace nexuslua
 {
     class ThreadPool
     {
     public:
-        ThreadPool()
-            : _message_manager{std::make_shared<message_manager_type>()}
-        {
-        }
+        ThreadPool() = default;
         virtual ~ThreadPool()
         {
-            _agentThreads.clear();
+            {
+                std::shared_lock lock(_mtxMailboxes);
+                for (auto& mailbox : _mailboxes)
+                {
+                    mailbox.second->Close(); // senders that wait for space in a full mailbox must not block the shutdown
+                }
+            }
+            {
+                std::map<std::size_t, std::unique_ptr<agent_thread_base>> agentThreads;
+                {
+                    std::lock_guard lock(_mtxAgentThreads);
+                    agentThreads.swap(_agentThreads);
+                }
+
+                for (auto& agentThread : agentThreads)
+                {
+                    if (Mailbox::IsHandling(agentThread.second.get()))
+                    {
+                        // the last reference to the agents has been released by a handler of this agent, which must not be destroyed before it returned
+                        Mailbox::RunAfterHandler([handler = std::shared_ptr<agent_thread_base>(std::move(agentThread.second))]() {});
+                    }
+                }
+            }
             if (auto locked = _agent_list.lock())
             {
                 locked->DeleteAgents();
             }
-            _message_manager.reset();
+            _mailboxes.clear();
+            _agentLoads.clear();
+            _loggedAgents.clear();
+            _scheduler.reset();
+            _coroutineHosts.clear();
         }
 
         static std::shared_ptr<ThreadPool> Get(std::weak_ptr<agents> agent_list)
@@ -90,38 +130,275 @@ namespace nexuslua
 
         void StartThread(const std::filesystem::path& luaFilePath, const std::string& luaCode, Agent* agent)
         {
-            _agentThreads[agent->GetId()] =
-                std::make_unique<AgentThreadLua>(luaFilePath, luaCode, agent, _message_manager);
-
-            _agentThreads[agent->GetId()]->addHandler(); // this starts the (handler) thread
+            if (agent->GetConfiguration().GetInternal<std::string>(Configuration::scheduler) == Configuration::schedulerCoroutines)
+            {
+                auto host = GetCoroutineHost(agent);
+                AddThread(agent, std::make_unique<AgentThreadCoroutine>(luaFilePath, luaCode, agent, GetMailbox(agent, host.get()), GetAgentLoad(agent), host));
+            }
+            else
+            {
+                AddThread(agent, std::make_unique<AgentThreadLua>(luaFilePath, luaCode, agent, GetMailbox(agent), GetAgentLoad(agent)));
+            }
         }
 
         void StartThread(const CppHandler& cppHandler, Agent* agent)
         {
-            _agentThreads[agent->GetId()] =
-                std::make_unique<AgentThreadCpp>(cppHandler, agent, _message_manager);
+            AddThread(agent, std::make_unique<AgentThreadCpp>(cppHandler, agent, GetMailbox(agent)));
+        }
+
+        void StartThread(const CppBatchHandler& cppBatchHandler, Agent* agent)
+        {
+            AddThread(agent, std::make_unique<AgentThreadCpp>(cppBatchHandler, agent, GetMailbox(agent)));
+        }
 
-            _agentThreads[agent->GetId()]->addHandler(); // this starts the (handler) thread
+        std::size_t GetReplicatedCount(const std::size_t agentId)
+        {
+            std::lock_guard lock(_mtxAgentThreads);
+            auto            it = _agentThreads.find(agentId);
+            return it == _agentThreads.end() ? 0 : it->second->GetReplicatedCount();
         }
 
-        void SendMessage(std::shared_ptr<Message> message)
+        /// returns false if the message was rejected because the mailbox of the receiving agent is full (see Configuration::mailboxCapacity)
+        bool SendMessage(std::shared_ptr<Message> message, const bool mayBlock = true)
         {
             static constexpr std::string_view queueKey{"queue"};
 
-            const std::size_t queue_value = (std::size_t)message->parameters.template get_mapped_value_or_default<cbeam::container::xpod::type_index::integer>(queueKey.data());
-            // const std::size_t receiver    = message->parameters.RequestsUnreplicatedReceiver() ? 0 : -1;
+            std::shared_ptr<Mailbox>   mailbox;
+            std::shared_ptr<AgentLoad> load;
+            bool                       logMessage;
+            {
+                std::shared_lock lock(_mtxMailboxes);
+                auto             it = _mailboxes.find(message->agent_n);
+                if (it != _mailboxes.end())
+                {
+                    mailbox = it->second;
+                }
+
+                logMessage = _loggedAgents.count(message->agent_n) > 0;
+
+                auto loadIt = _agentLoads.find(message->agent_n);
+                if (loadIt != _agentLoads.end())
+                {
+                    load = loadIt->second;
+                    load->MessageQueued();
+                }
+            }
+
+            if (!mailbox)
+            {
+                CBEAM_LOG("nexuslua::ThreadPool: skipped message '" + message->name + "' to unknown agent " + std::to_string(message->agent_n));
+                message_counter::get()->decrease();
+                return false;
+            }
+
+            if (logMessage)
+            {
+                CBEAM_LOG("Message " + message->name + " to handler" + std::to_string(message->agent_n) + " was sent with parameters\n" + cbeam::convert::to_string(message->parameters));
+            }
+
+            // the optional message entry "queue" selects the priority lane of the receiving agent, 0 being the highest priority
+            const long long lane = message->parameters.template get_mapped_value_or_default<cbeam::container::xpod::type_index::integer>(queueKey.data());
+
+            std::shared_ptr<Message>  dropped;
+            const Mailbox::PushResult result = mailbox->Push(std::move(message), lane > 0 ? (std::size_t)lane : 0, mayBlock, &dropped);
 
-            _message_manager->send_message(message->agent_n, message, queue_value); // TODO
+            if (result != Mailbox::PushResult::Queued)
+            {
+                // either this message or an older one has been discarded
+                message_counter::get()->decrease();
+                if (load)
+                {
+                    load->MessageDequeued();
+                }
+            }
+
+            if (dropped)
+            {
+                // a caller that waits for the reply to the discarded message is resumed with an error; the caller of a
+                // rejected message learns from the return value that it has not been sent
+                if (const long long call = dropped->parameters.GetReplyToCallOrZero())
+                {
+                    LuaTable reply;
+                    reply.data["error"] = "message '" + dropped->name + "' has been discarded, because the mailbox of agent " + std::to_string(dropped->agent_n) + " is full";
+                    PendingCalls::Complete(call, std::move(reply));
+                }
+            }
+
+            return result != Mailbox::PushResult::Rejected;
+        }
+
+        std::vector<std::size_t> GetQueueDepths(const std::size_t agentId) ///< returns the number of queued messages per priority lane of the given agent
+        {
+            std::shared_lock lock(_mtxMailboxes);
+            auto             it = _mailboxes.find(agentId);
+            return it == _mailboxes.end() ? std::vector<std::size_t>{} : it->second->GetLaneDepths();
+        }
+
+        std::size_t GetQueueHighWaterMark(const std::size_t agentId) ///< returns the maximum number of messages that have been queued for the given agent at the same time
+        {
+            std::shared_lock lock(_mtxMailboxes);
+            auto             it = _mailboxes.find(agentId);
+            return it == _mailboxes.end() ? 0 : it->second->GetHighWaterMark();
+        }
+
+        std::size_t GetQueueOverflowCount(const std::size_t agentId) ///< returns the number of messages to the given agent that have been rejected or dropped because its mailbox was full
+        {
+            std::shared_lock lock(_mtxMailboxes);
+            auto             it = _mailboxes.find(agentId);
+            return it == _mailboxes.end() ? 0 : it->second->GetOverflowCount();
         }
 
     private:
         ThreadPool(const ThreadPool&)            = delete;
         ThreadPool& operator=(const ThreadPool&) = delete;
 
-        using message_manager_type = cbeam::concurrency::message_manager<std::shared_ptr<Message>>;
+        void AddThread(Agent* agent, std::unique_ptr<agent_thread_base> agentThread)
+        {
+            agent_thread_base* handler = agentThread.get();
+            {
+                std::lock_guard lock(_mtxAgentThreads);
+                _agentThreads[agent->GetId()] = std::move(agentThread);
+            }
+
+            handler->addHandler(); // this starts the (handler) thread
+        }
+
+        /// returns the AgentLoad that SendMessage keeps up to date for the given (Lua) agent
+        std::shared_ptr<AgentLoad> GetAgentLoad(Agent* agent)
+        {
+            std::unique_lock lock(_mtxMailboxes);
+
+            auto& load = _agentLoads[agent->GetId()];
+            if (!load)
+            {
+                load = std::make_shared<AgentLoad>();
+            }
+
+            return load;
+        }
+
+        /// returns the host of a new agent with Configuration::schedulerCoroutines; agents that are added by an agent of a host stay on this host, others are distributed round robin
+        std::shared_ptr<CoroutineHost> GetCoroutineHost(Agent* agent)
+        {
+            std::lock_guard lock(_mtxCoroutineHosts);
+
+            if (CoroutineHost* current = CoroutineHost::GetCurrent())
+            {
+                // the new agent's script has to run on the host thread, so waiting for another host could deadlock
+                for (const auto& host : _coroutineHosts)
+                {
+                    if (host.get() == current)
+                    {
+                        return host;
+                    }
+                }
+            }
+
+            if (_coroutineHostCount == 0)
+            {
+                const long long hosts = agent->GetConfiguration().GetInternal<long long>(Configuration::schedulerHosts);
+                _coroutineHostCount   = hosts > 0 ? (std::size_t)hosts : std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            if (_coroutineHosts.size() < _coroutineHostCount)
+            {
+                return _coroutineHosts.emplace_back(std::make_shared<CoroutineHost>());
+            }
+
+            return _coroutineHosts[_nextCoroutineHost++ % _coroutineHosts.size()];
+        }
+
+        /// returns the Mailbox of the agent; it is either processed by dedicated threads (Configuration::schedulerThreads), by _scheduler (Configuration::schedulerPool) or by the given host (Configuration::schedulerCoroutines)
+        std::shared_ptr<Mailbox> GetMailbox(Agent* agent, CoroutineHost* host = nullptr)
+        {
+            auto&             configuration = agent->GetConfiguration();
+            const std::string mode          = configuration.GetInternal<std::string>(Configuration::scheduler);
+            const std::string dequeue       = configuration.GetInternal<std::string>(Configuration::mailboxDequeue);
+            const long long   lanes         = configuration.GetInternal<long long>(Configuration::mailboxLanes);
+            const long long   capacity      = configuration.GetInternal<long long>(Configuration::mailboxCapacity);
+            const std::string overflow      = configuration.GetInternal<std::string>(Configuration::mailboxOverflow);
+
+            if (mode != Configuration::schedulerThreads && mode != Configuration::schedulerPool && mode != Configuration::schedulerCoroutines)
+            {
+                throw std::runtime_error("nexuslua::ThreadPool: unknown value '" + mode + "' of configuration entry '" + std::string(Configuration::scheduler) + "' of agent '" + agent->GetName() + "'");
+            }
+
+            if (dequeue != Configuration::mailboxDequeueStrict && dequeue != Configuration::mailboxDequeueWeighted)
+            {
+                throw std::runtime_error("nexuslua::ThreadPool: unknown value '" + dequeue + "' of configuration entry '" + std::string(Configuration::mailboxDequeue) + "' of agent '" + agent->GetName() + "'");
+            }
+
+            if (overflow != Configuration::mailboxOverflowBlock && overflow != Configuration::mailboxOverflowFail && overflow != Configuration::mailboxOverflowDropOldest)
+            {
+                throw std::runtime_error("nexuslua::ThreadPool: unknown value '" + overflow + "' of configuration entry '" + std::string(Configuration::mailboxOverflow) + "' of agent '" + agent->GetName() + "'");
+            }
+
+            const auto affinity = CpuAffinity::Create(configuration);
+            if (mode != Configuration::schedulerThreads && affinity->GetPolicy() != CpuAffinity::Policy::None)
+            {
+                CBEAM_LOG("nexuslua::ThreadPool: configuration entry '" + std::string(Configuration::cpuAffinity) + "' of agent '" + agent->GetName() + "' is ignored, because it is processed by shared threads (scheduler '" + mode + "')");
+            }
+
+            if (mode == Configuration::schedulerCoroutines && !host)
+            {
+                host = GetCoroutineHost(agent).get(); // C++ agent
+            }
+
+            std::unique_lock lock(_mtxMailboxes);
+
+            if (configuration.GetInternal<bool>(Configuration::logMessages))
+            {
+                _loggedAgents.insert(agent->GetId()); // like the messages received by the agent, see AgentThread::addHandler
+            }
+
+            Scheduler* scheduler = nullptr;
+            if (mode == Configuration::schedulerPool)
+            {
+                if (!_scheduler)
+                {
+                    const long long workers = configuration.GetInternal<long long>(Configuration::schedulerWorkers);
+                    _scheduler              = std::make_unique<Scheduler>(workers > 0 ? (std::size_t)workers : 0);
+                }
+
+                scheduler = _scheduler.get();
+            }
+            else if (host)
+            {
+                scheduler = host->GetScheduler();
+            }
+
+            auto& mailbox = _mailboxes[agent->GetId()];
+            if (!mailbox)
+            {
+                mailbox = std::make_shared<Mailbox>(scheduler,
+                                                    lanes > 0 ? (std::size_t)lanes : 1,
+                                                    dequeue == Configuration::mailboxDequeueWeighted ? Mailbox::Dequeue::Weighted : Mailbox::Dequeue::Strict);
+
+                mailbox->SetCapacity(capacity > 0 ? (std::size_t)capacity : 0,
+                                     overflow == Configuration::mailboxOverflowFail         ? Mailbox::Overflow::Fail
+                                     : overflow == Configuration::mailboxOverflowDropOldest ? Mailbox::Overflow::DropOldest
+                                                                                            : Mailbox::Overflow::Block);
+
+                if (!scheduler)
+                {
+                    mailbox->SetAffinity(affinity);
+                }
+            }
+
+            return mailbox;
+        }
 
-        std::shared_ptr<message_manager_type>                     _message_manager;
+        std::unique_ptr<Scheduler>                                _scheduler;
+        std::map<std::size_t, std::shared_ptr<Mailbox>>           _mailboxes;
+        std::map<std::size_t, std::shared_ptr<AgentLoad>>         _agentLoads;
+        std::set<std::size_t>                                     _loggedAgents; ///< agents whose Configuration::logMessages was set when they were added; messages sent to them are logged
+        std::shared_mutex                                         _mtxMailboxes; ///< for _mailboxes, _agentLoads and _loggedAgents
         std::map<std::size_t, std::unique_ptr<agent_thread_base>> _agentThreads;
+        std::mutex                                                _mtxAgentThreads;
+        std::vector<std::shared_ptr<CoroutineHost>>               _coroutineHosts; ///< see Configuration::schedulerCoroutines
+        std::size_t                                               _coroutineHostCount{0};
+        std::size_t                                               _nextCoroutineHost{0};
+        std::mutex                                                _mtxCoroutineHosts;
         inline static std::weak_ptr<agents>                       _agent_list;
     };
 }